@@ -0,0 +1,340 @@
+#include "analysis_server.h"
+#include "output_sink.h"
+#include "result_writer.h"
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std;
+
+
+/* Buffered reading of requests from a connection */
+struct Request_reader
+{
+        int fd;
+        string buffer;
+        size_t position;
+
+        /* Refill the buffer, false at the end of connection */
+        bool fill()
+        {
+                if (position > 0) {
+                        buffer.erase(0, position);
+                        position = 0;
+                }
+                char chunk[65536];
+                while (true) {
+                        ssize_t count = read(fd, chunk, sizeof(chunk));
+                        if (count < 0 && errno == EINTR) {
+                                continue;
+                        }
+                        /* also the timeout of the connection */
+                        if (count <= 0) {
+                                return false;
+                        }
+                        buffer.append(chunk, count);
+                        return true;
+                }
+        }
+
+        bool read_line(string &line)
+        {
+                size_t eol;
+                while ((eol = buffer.find('\n', position)) == string::npos) {
+                        if (!fill()) {
+                                return false;
+                        }
+                }
+                line.assign(buffer, position, eol - position);
+                if (!line.empty() && line.back() == '\r') {
+                        line.pop_back();
+                }
+                position = eol + 1;
+                return true;
+        }
+
+        bool read_bytes(size_t size, string &data)
+        {
+                while (buffer.size() - position < size) {
+                        if (!fill()) {
+                                return false;
+                        }
+                }
+                data.assign(buffer, position, size);
+                position += size;
+                return true;
+        }
+};
+
+
+/* Write end of the pipe waking the accepting thread by SIGINT/SIGTERM */
+static int stop_pipe = -1;
+
+
+static void stop_serving(int)
+{
+        int saved = errno;
+        if (write(stop_pipe, "", 1) < 0) {
+                /* the pipe is full, the server is woken already */
+        }
+        errno = saved;
+}
+
+
+/* Diagnostics of a failed analysis as a single line */
+static string joined_lines(const string &text)
+{
+        string joined;
+        istringstream lines(text);
+        string line;
+        while (getline(lines, line)) {
+                if (!line.empty()) {
+                        joined += (joined.empty() ? "" : "; ") + line;
+                }
+        }
+        return joined.empty() ? "ommited" : joined;
+}
+
+
+Analysis_server::Analysis_server(const Conf_analyser &_analyser,
+                                 size_t _threads, size_t _max_request,
+                                 size_t _timeout)
+        : analyser(_analyser)
+{
+        threads = (_threads == 0) ? 1 : _threads;
+        max_request = _max_request;
+        timeout = _timeout;
+        listener = -1;
+}
+
+
+Analysis_server::~Analysis_server()
+{
+        if (listener != -1) {
+                close(listener);
+                unlink(socket_path.c_str());
+        }
+}
+
+
+bool Analysis_server::listen(const string &_socket_path)
+{
+        sockaddr_un address;
+        memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        if (_socket_path.size() >= sizeof(address.sun_path)) {
+                diagnostics() << "Socket path " << _socket_path << " is too long!\n";
+                return false;
+        }
+        strcpy(address.sun_path, _socket_path.c_str());
+
+        listener = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listener == -1) {
+                diagnostics() << "Could not create socket " << _socket_path << "...\n";
+                return false;
+        }
+
+        unlink(_socket_path.c_str());
+        if (bind(listener, reinterpret_cast<sockaddr*>(&address),
+                 sizeof(address)) != 0 ||
+            ::listen(listener, SOMAXCONN) != 0) {
+                diagnostics() << "Could not listen on socket " << _socket_path << "...\n";
+                close(listener);
+                listener = -1;
+                return false;
+        }
+        socket_path = _socket_path;
+
+        return true;
+}
+
+
+bool Analysis_server::run()
+{
+        /* clients closing the connection early must not kill the server */
+        signal(SIGPIPE, SIG_IGN);
+
+        /* signals only wake the accepting thread through the pipe, so
+           none of them is lost between the checks */
+        int wake[2];
+        if (pipe(wake) != 0) {
+                diagnostics() << "Could not create pipe of the server!\n";
+                return false;
+        }
+        fcntl(wake[1], F_SETFL, O_NONBLOCK);
+        stop_pipe = wake[1];
+        struct sigaction action;
+        memset(&action, 0, sizeof(action));
+        action.sa_handler = stop_serving;
+        sigaction(SIGINT, &action, nullptr);
+        sigaction(SIGTERM, &action, nullptr);
+
+        vector<thread> pool;
+        for (size_t i = 0; i < threads; i++) {
+                pool.emplace_back(&Analysis_server::worker, this);
+        }
+
+        bool stopped = false;
+        while (true) {
+                pollfd fds[2] = {{listener, POLLIN, 0}, {wake[0], POLLIN, 0}};
+                if (poll(fds, 2, -1) < 0) {
+                        if (errno == EINTR) {
+                                continue;
+                        }
+                        diagnostics() << "Error while waiting for clients on " << socket_path << '\n';
+                        break;
+                }
+                if (fds[1].revents != 0) {
+                        stopped = true;
+                        break;
+                }
+                int client = accept(listener, nullptr, nullptr);
+                if (client == -1) {
+                        if (errno == EINTR || errno == ECONNABORTED) {
+                                continue;
+                        }
+                        diagnostics() << "Error while accepting client on " << socket_path << '\n';
+                        break;
+                }
+
+                /* idle client can not keep a thread forever */
+                timeval limit = {static_cast<time_t>(timeout), 0};
+                setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &limit, sizeof(limit));
+                setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &limit, sizeof(limit));
+                {
+                        lock_guard<mutex> lock(clients_mutex);
+                        clients.push_back(client);
+                }
+                clients_changed.notify_one();
+        }
+
+        /* waiting clients are dropped, the served ones get no more
+           requests after the current one, -1 asks a thread to finish */
+        {
+                lock_guard<mutex> lock(clients_mutex);
+                for (auto x : clients) {
+                        close(x);
+                }
+                clients.clear();
+                for (auto x : served) {
+                        shutdown(x, SHUT_RD);
+                }
+                for (size_t i = 0; i < threads; i++) {
+                        clients.push_back(-1);
+                }
+        }
+        clients_changed.notify_all();
+        for (auto &x : pool) {
+                x.join();
+        }
+
+        signal(SIGINT, SIG_DFL);
+        signal(SIGTERM, SIG_DFL);
+        stop_pipe = -1;
+        close(wake[0]);
+        close(wake[1]);
+
+        return stopped;
+}
+
+
+void Analysis_server::worker()
+{
+        while (true) {
+                int client;
+                {
+                        unique_lock<mutex> lock(clients_mutex);
+                        clients_changed.wait(lock, [this]{ return !clients.empty(); });
+                        client = clients.front();
+                        clients.pop_front();
+                        if (client != -1) {
+                                served.insert(client);
+                        }
+                }
+                if (client == -1) {
+                        return;
+                }
+                serve(client);
+                {
+                        lock_guard<mutex> lock(clients_mutex);
+                        served.erase(client);
+                }
+                close(client);
+        }
+}
+
+
+void Analysis_server::serve(int client)
+{
+        Request_reader in{client, string(), 0};
+        Output_sink sink(client, 1 << 16);
+        ostream out(&sink);
+        Json_writer writer(out);
+
+        string line;
+        string data;
+        bool last = false;
+        while (!last && in.read_line(line)) {
+                string name;
+                bool success = false;
+                Ring_result result;
+                ostringstream messages;
+                set_thread_diagnostics(&messages);
+
+                if (line.compare(0, 5, "FILE ") == 0) {
+                        name = line.substr(5);
+                        Molecule *mol = analyser.analyse_file(name);
+                        if (mol != nullptr) {
+                                result = mol->get_result();
+                                delete(mol);
+                                success = true;
+                        }
+                } else if (line.compare(0, 4, "PDB ") == 0) {
+                        char *end = nullptr;
+                        size_t size = strtoul(line.c_str() + 4, &end, 10);
+                        if (end == line.c_str() + 4 || (*end != ' ' && *end != '\0')) {
+                                diagnostics() << "Invalid size of PDB data!\n";
+                        } else if (size > max_request) {
+                                /* the data are not read, so the connection
+                                   can not continue */
+                                diagnostics() << "PDB data larger than " << max_request
+                                              << " bytes are not accepted!\n";
+                                name = (*end == ' ') ? string(end + 1) : "-";
+                                last = true;
+                        } else {
+                                name = (*end == ' ') ? string(end + 1) : "-";
+                                if (!in.read_bytes(size, data)) {
+                                        set_thread_diagnostics(nullptr);
+                                        return;
+                                }
+                                success = analyser.analyse_buffer(name,
+                                                data.data(), data.size(),
+                                                result);
+                        }
+                } else if (line == "QUIT") {
+                        set_thread_diagnostics(nullptr);
+                        return;
+                } else {
+                        diagnostics() << "Unknown request!\n";
+                }
+                set_thread_diagnostics(nullptr);
+
+                if (success) {
+                        writer.write(result);
+                } else {
+                        writer.write_error(name, joined_lines(messages.str()));
+                }
+                if (!sink.flush()) {
+                        return;
+                }
+        }
+}
@@ -0,0 +1,60 @@
+#ifndef ANALYSIS_SERVER_H
+#define ANALYSIS_SERVER_H
+
+#include "conf_analyser.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <set>
+#include <string>
+
+/*
+ * Long-lived analysis service on a local Unix domain socket. Atom names
+ * are loaded once by the analyser, clients are served by a pool of
+ * threads, one connection per thread at a time. Requests are lines:
+ *
+ *   FILE <path>                  analyse PDB file of the server
+ *   PDB <size> <name>            analyse <size> bytes of PDB data that
+ *                                follow the line, reported as <name>
+ *   QUIT                         close the connection
+ *
+ * Each request is answered by one line with a JSON object - the result
+ * as written by Json_writer, or {"file": ..., "error": ...} with the
+ * diagnostics of the failed analysis. PDB data larger than the limit is
+ * refused and the connection closed, so is a connection of a client
+ * which sends nothing for the timeout. SIGINT or SIGTERM stops accepting
+ * clients, requests being analysed are answered before the connections
+ * are closed.
+ */
+class Analysis_server
+{
+        public:
+                Analysis_server(const Conf_analyser &_analyser,
+                                size_t _threads, size_t _max_request,
+                                size_t _timeout);
+                ~Analysis_server();
+                /* Create the socket, stale socket file is replaced */
+                bool listen(const std::string &_socket_path);
+                /* Accept clients until SIGINT/SIGTERM (true) or until the
+                   socket fails (false) */
+                bool run();
+        private:
+                void worker();
+                void serve(int client);
+                const Conf_analyser &analyser;
+                size_t threads;
+                /* Largest PDB data of a request in bytes */
+                size_t max_request;
+                /* Seconds of waiting for a client to send or receive */
+                size_t timeout;
+                int listener;
+                std::string socket_path;
+                /* Accepted connections waiting for a thread */
+                std::deque<int> clients;
+                /* Connections being served */
+                std::set<int> served;
+                std::mutex clients_mutex;
+                std::condition_variable clients_changed;
+};
+
+#endif
@@ -21,14 +21,31 @@ double angle(const Point_3D &A, const Point_3D &B, const Point_3D &C)
         return angle(Vector_3D(B, A), Vector_3D(B, C));
 }
 
+template<typename T>
+static T dihedral(const Point_3D_t<T> &A, const Point_3D_t<T> &B,
+                  const Point_3D_t<T> &C, const Point_3D_t<T> &D)
+{
+        Vector_3D_t<T> _u = Vector_3D_t<T>::cross(Vector_3D_t<T>(B, A),
+                                                  Vector_3D_t<T>(B, C));
+        Vector_3D_t<T> _v = Vector_3D_t<T>::cross(Vector_3D_t<T>(C, B),
+                                                  Vector_3D_t<T>(C, D));
+        Vector_3D_t<T> normal = Vector_3D_t<T>(B, C).get_normal();
+
+        T tmp = atan2(Vector_3D_t<T>::dot(Vector_3D_t<T>::cross(_u, _v), normal),
+                      Vector_3D_t<T>::dot(_u, _v));
+        return tmp * 180 / static_cast<T>(M_PI);
+}
+
+
 double dihedral_angle(const Point_3D &A, const Point_3D &B,
                       const Point_3D &C, const Point_3D &D)
 {
-        Vector_3D _u = Vector_3D::cross(Vector_3D(B, A), Vector_3D(B, C));
-        Vector_3D _v = Vector_3D::cross(Vector_3D(C, B), Vector_3D(C, D));
-        Vector_3D normal = Vector_3D(B, C).get_normal();
+        return dihedral(A, B, C, D);
+}
 
-        double tmp = atan2(Vector_3D::dot(Vector_3D::cross(_u, _v), normal),
-                     Vector_3D::dot(_u, _v));
-        return rad_to_deg(tmp);
+
+float dihedral_angle(const Point_3Df &A, const Point_3Df &B,
+                     const Point_3Df &C, const Point_3Df &D)
+{
+        return dihedral(A, B, C, D);
 }
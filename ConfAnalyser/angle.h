@@ -7,5 +7,7 @@ double angle(const Vector_3D &vc1, const Vector_3D &vec2);
 double angle(const Point_3D &A, const Point_3D &B, const Point_3D &C);
 double dihedral_angle(const Point_3D &A, const Point_3D &B,
                       const Point_3D &C, const Point_3D &D);
+float dihedral_angle(const Point_3Df &A, const Point_3Df &B,
+                     const Point_3Df &C, const Point_3Df &D);
 
 #endif
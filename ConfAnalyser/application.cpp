@@ -1,34 +1,79 @@
 #include "application.h"
-#include "plane_3D.h"
-#include "cyclohexane.h"
-#include "cyclopentane.h"
-#include "benzene.h"
-#include "oxane.h"
+#include "result_writer.h"
+#include "instrumentation.h"
+#include "tar_reader.h"
+#include "work_scheduler.h"
+#include "partial_result.h"
+#include "analysis_server.h"
+#include "directory_watcher.h"
+#include "group_statistics.h"
+#include "descriptor_statistics.h"
+#include "result_diff.h"
+#include "bootstrap.h"
+#include "ligand_index.h"
+#include "torsion_classifier.h"
 #include <string>
 #include <iostream>
 #include <sstream>
 #include <fstream>
 #include <getopt.h>
-
-#define EMPTY        -1
-#define CYCLOHEXANE   0
-#define CYCLOPENTANE  1
-#define BENZENE       2
-#define OXANE        3
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <cstring>
+#include <cstdio>
+#include <csignal>
+#include <mutex>
+#include <numeric>
+#include <random>
 
 using namespace std;
 
 
-map<string, vector<vector<string>>> Molecule::atom_names;
-
-
 Application::Application(int _argc, char **_argv)
+        : output_sink(STDOUT_FILENO), diagnostics_sink(STDERR_FILENO),
+          output(&output_sink), diagnostics_output(&diagnostics_sink)
 {
         argc = _argc;
         argv = _argv;
         print_summary = true;
         print_list = true;
         analysis_type = EMPTY;
+        output_format = FORMAT_TEXT;
+        print_profile = false;
+        print_workers = false;
+        read_ahead_depth = 0;
+        read_ahead_memory = 256;
+        io_threads = 1;
+        jobs = 1;
+        shard = 0;
+        shards = 0;
+        write_partial = false;
+        merge_mode = false;
+        diff_mode = false;
+        compile_mode = false;
+        index_mode = false;
+        group_fields = 0;
+        print_distributions = false;
+        print_histograms = false;
+        confidence_trials = 0;
+        confidence_sigma = -1;
+        engine = ENGINE_GEOMETRIC;
+        precision_check = false;
+        sample_width = 0;
+        sample_seed = 0;
+        sampled = 0;
+        bootstrap_resamples = 0;
+        checkpoint_interval = 60;
+        max_request = 64;
+        client_timeout = 60;
+        resume = false;
+        resumed = false;
+        resume_offset = 0;
+        processed = 0;
+        last_checkpoint = chrono::steady_clock::now();
+        checkpointed = 0;
+        checkpoint_started = false;
         string input_file_list = string();
 }
 
@@ -40,169 +85,561 @@ Application::~Application()
                 delete(*itr);
         }
         molecules.clear();
+        set_diagnostics(nullptr);
 }
 
 
-bool Application::read_PDB(string &file_name, vector<Atom*> &molecule)
+bool Application::in_shard(size_t index) const
 {
-        string line;
-        string record_name;
-
-        ifstream ifile;
-        ifile.open(file_name);
-	if (ifile.fail()) {
-                cerr << "Could not open file " << file_name << "..." << endl;
-                return false; 
-        }
-
-	size_t line_number = 1; /* keep line number for case of error */
-       	while (!ifile.eof()) {
-	        getline(ifile, line);
-                if (line.length() >= 6) {
-                        record_name = line.substr(0, 6); 
-                        if (record_name == "ATOM  " || record_name == "HETATM") {
-                                Atom *atom = new Atom();
-                                atom->set_line_number(line_number);
-                                atom->read_entry(line);
-                                molecule.push_back(atom);
-                        }
+        return shards == 0 || index % shards == shard - 1;
+}
+
+
+void Application::add_molecule(Molecule *mol, size_t index)
+{
+        if (mol != nullptr) {
+                molecules.push_back(mol);
+                molecule_indices.push_back(index);
+                descriptor_statistics.add(mol->get_result());
+                if (sample_width > 0) {
+                        sample_estimate.add(mol->get_conformation());
                 }
-                line_number++;
         }
 
-        ifile.close();
+        /* files are passed here in the order of input, so everything
+           before this one is done */
+        processed = index + 1;
+}
+
 
-        return true;
+bool Application::checkpoint_due() const
+{
+        return !checkpoint_file.empty() &&
+               chrono::steady_clock::now() - last_checkpoint >=
+               chrono::seconds(checkpoint_interval);
 }
 
 
-bool Application::read_atom_names()
+void Application::maybe_checkpoint()
 {
-        size_t atoms_count = 0;
-        switch (analysis_type) {
-                case CYCLOPENTANE:
-                        atoms_count = 5;
-                        break;
-                case CYCLOHEXANE:
-                        atoms_count = 6;
-                        break;
-                case BENZENE:
-                        atoms_count = 6;
-                        break;
-                case OXANE:
-                        atoms_count = 6;
-                        break;
-                default:
-                        cerr << "Can`t deduce number of atoms from given analysis type!" << endl;
+        /* one thread writes the checkpoint, the others go on */
+        unique_lock<mutex> lock(checkpoint_mutex, try_to_lock);
+        if (lock.owns_lock() && checkpoint_due()) {
+                write_checkpoint();
+        }
+}
+
+
+/* Data of the file (or the directory) are on the disk */
+static bool sync_path(const string &path)
+{
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd == -1) {
+                return false;
+        }
+        bool success = fsync(fd) == 0;
+        close(fd);
+        return success;
+}
+
+
+bool Application::write_checkpoint()
+{
+        last_checkpoint = chrono::steady_clock::now();
+
+        /* the watch keeps its whole state in checkpoint_results */
+        if (!watch_directory.empty()) {
+                diagnostics_sink.flush();
+                return save_checkpoint(processed, collect_results());
+        }
+
+        /* only results passed since the previous checkpoint are taken
+           over under the lock, the checkpoint is written outside of it */
+        vector<pair<size_t, Ring_result>> passed;
+        Descriptor_statistics statistics;
+        size_t done;
+        {
+                lock_guard<mutex> lock(results_mutex);
+                /* diagnostics of checkpointed files are not lost on crash */
+                diagnostics_sink.flush();
+                for (; checkpointed < molecules.size(); checkpointed++) {
+                        passed.push_back(make_pair(molecule_indices[checkpointed],
+                                                   molecules[checkpointed]->get_result()));
+                }
+                statistics = descriptor_statistics;
+                done = processed;
+        }
+        if (!checkpoint_started) {
+                checkpoint_state = initial_results();
+                checkpoint_started = true;
+        }
+        for (const auto &x : passed) {
+                checkpoint_state.add(x.first, x.second);
+        }
+        checkpoint_state.set_statistics(statistics);
+
+        return save_checkpoint(done, checkpoint_state);
+}
+
+
+bool Application::save_checkpoint(size_t done, const Partial_result &rings)
+{
+        /* checkpoint is replaced at once, so a crash while writing it
+           leaves the previous one intact; the new one is on the disk
+           before it replaces the old one, the rename after it */
+        string temporary = checkpoint_file + ".tmp";
+        {
+                ofstream f(temporary);
+                f << CHECKPOINT_MAGIC << '\t' << done << '\t'
+                  << input_file_list << input_archive << watch_directory
+                  << index_file << '\n';
+                rings.write(f);
+                f.flush();
+                if (f.fail()) {
+                        diagnostics() << "Could not write file " << temporary << "...\n";
                         return false;
+                }
         }
+        size_t slash = checkpoint_file.rfind('/');
+        string directory = (slash == string::npos) ? "." :
+                           checkpoint_file.substr(0, max(slash, static_cast<size_t>(1)));
+        if (!sync_path(temporary) ||
+            rename(temporary.c_str(), checkpoint_file.c_str()) != 0 ||
+            !sync_path(directory)) {
+                diagnostics() << "Could not write file " << checkpoint_file << "...\n";
+                return false;
+        }
+
+        return true;
+}
 
-        ifstream ifile;
-        ifile.open(atom_names_list);
-	if (ifile.fail()) {
-                cerr << "Could not open file " << atom_names_list << "..." << endl;
-                return false; 
+
+bool Application::read_checkpoint()
+{
+        ifstream f(checkpoint_file);
+        if (!f.is_open()) {
+                diagnostics() << checkpoint_file << ": no checkpoint, starting from the beginning\n";
+                return true;
         }
 
         string line;
-	size_t line_number = 1; /* keep line number for case of error */
-        stringstream ss;
-       	while (getline(ifile, line)) {
-	        ss.clear();
-	        ss.str(line);
-
-                /* Get lignad name */
-                string ligand_name;
-                ss >> ligand_name;
-
-                if (ss.fail()) {
-                        ss.clear();
-                        cerr << atom_names_list << ": Wrong syntax on line nr. "
-                             << line_number << "..." << endl;
-                        line_number++;
-                        continue;
-                }
+        string input = input_file_list + input_archive + watch_directory +
+                       index_file;
+        string expected = string(CHECKPOINT_MAGIC) + '\t';
+        char *end = nullptr;
+        if (!getline(f, line) || line.compare(0, expected.size(), expected) != 0) {
+                diagnostics() << checkpoint_file << ": not a checkpoint!\n";
+                return false;
+        }
+        resume_offset = strtoul(line.c_str() + expected.size(), &end, 10);
+        if (*end != '\t' || string(end + 1) != input) {
+                diagnostics() << checkpoint_file << ": checkpoint of other input than " << input << "!\n";
+                return false;
+        }
+
+        if (!checkpoint_results.read(f, checkpoint_file)) {
+                return false;
+        }
+        Partial_result current = collect_results();
+        if (checkpoint_results.get_conformations() != current.get_conformations() ||
+            checkpoint_results.missing_shards() != current.missing_shards()) {
+                diagnostics() << checkpoint_file << ": checkpoint of other type of ring or shard!\n";
+                return false;
+        }
+
+        /* sketches continue as if the run was not interrupted */
+        descriptor_statistics = checkpoint_results.get_statistics();
+        resumed = true;
+        processed = resume_offset;
+        diagnostics() << checkpoint_file << ": resuming from position " << resume_offset + 1 << " of the input\n";
+
+        return true;
+}
+
+
+Molecule *Application::process_file(const string &file_name) const
+{
+        COUNT(COUNTER_FILES, 1);
+        Molecule *mol = analyser.analyse_file(file_name);
+        if (mol == nullptr) {
+                diagnostics() << file_name << ": ommited\n";
+                return nullptr;
+        }
+        COUNT(COUNTER_ANALYSED, 1);
 
-                /* Read atom names to temporary container */
-                vector<string> tmp_vec;
-                string tmp_str;
-                while (ss >> tmp_str) {
-                        ss.clear();
-                        tmp_vec.push_back(tmp_str);
+        return mol;
+}
+
+
+Molecule *Application::process_entry(const Read_ahead_entry &entry) const
+{
+        COUNT(COUNTER_FILES, 1);
+        Molecule *mol = nullptr;
+        if (!entry.success) {
+                diagnostics() << "Could not open file " << entry.file_name << "...\n";
+        } else {
+                mol = analyser.analyse_buffer(entry.file_name,
+                                              entry.content.data(),
+                                              entry.content.size());
+        }
+
+        if (mol == nullptr) {
+                diagnostics() << entry.file_name << ": ommited\n";
+                return nullptr;
+        }
+        COUNT(COUNTER_ANALYSED, 1);
+
+        return mol;
+}
+
+
+bool Application::process_archive()
+{
+        Tar_reader archive;
+        {
+                STAGE_TIMER(STAGE_OPEN);
+                if (!archive.open(input_archive)) {
+                        diagnostics() << "Error while opening file " << input_archive << '\n';
+                        return false;
                 }
+        }
 
-                if (tmp_vec.size() != atoms_count) {
-                        cerr << atom_names_list << ": Wrong number of atom names on line nr. "
-                             << line_number << " (expected " << atoms_count << ", was "
-                             << tmp_vec.size() << "), entry ommited..." << endl;
-                        line_number++;
+        /* members are analysed one by one and reported under their names */
+        Read_ahead_entry entry;
+        entry.success = true;
+        for (size_t index = 0; ; index++) {
+                {
+                        STAGE_TIMER(STAGE_READ);
+                        if (!archive.next(entry.file_name, entry.content)) {
+                                break;
+                        }
+                }
+                /* members of other shards and members already done before
+                   the checkpoint are only skipped over */
+                if (!in_shard(index) || index < resume_offset) {
+                        continue;
+                }
+                if (archive.member_damaged()) {
+                        COUNT(COUNTER_FILES, 1);
+                        diagnostics() << entry.file_name << ": could not decompress member\n"
+                                      << entry.file_name << ": ommited\n";
+                        add_molecule(nullptr, index);
+                        maybe_checkpoint();
                         continue;
                 }
+                COUNT(COUNTER_BYTES, entry.content.size());
+                add_molecule(process_entry(entry), index);
+                maybe_checkpoint();
+        }
+
+        if (archive.failed()) {
+                diagnostics() << input_archive << ": archive is damaged or truncated\n";
+                return false;
+        }
+
+        return true;
+}
+
+
+bool Application::read_input_list(vector<string> &files)
+{
+        string line;
+        ifstream f(input_file_list);
+        if (!f.is_open()) {
+                diagnostics() << "Error while opening file " << input_file_list << '\n';
+                return false;
+        }
+
+        /* shard takes every N-th line of the list */
+        for (size_t index = 0; getline(f, line); index++) {
+                if (in_shard(index) && index >= resume_offset) {
+                        files.push_back(line);
+                        file_indices.push_back(index);
+                }
+        }
+
+        return true;
+}
+
 
-                /* Create new lingand entry, if this one doesn`t exist */
-                if (Molecule::atom_names.count(ligand_name) == 0) {
-                        vector<vector<string>> all_names_list;
-                        Molecule::atom_names.insert(map<string, vector<vector<string>>>::value_type(ligand_name, all_names_list));
+void Application::process_files(const vector<string> &files)
+{
+        if (jobs > 1) {
+                process_files_parallel(files, nullptr);
+                return;
+        }
+
+        if (read_ahead_depth == 0) {
+                for (size_t i = 0; i < files.size(); i++) {
+                        add_molecule(process_position(files, i), file_indices[i]);
+                        maybe_checkpoint();
                 }
+                return;
+        }
+
+        /* following files are read while the current one is analysed */
+        Read_ahead reader(files, read_ahead_depth, read_ahead_memory << 20,
+                          io_threads);
+        const Read_ahead_entry *entry;
+        for (size_t i = 0; (entry = reader.next()) != nullptr; i++) {
+                add_molecule(process_entry(*entry), file_indices[i]);
+                reader.release(entry);
+                maybe_checkpoint();
+        }
+}
+
 
-                /* fill the atom names */
-                for (size_t i = 0; i < atoms_count; i++) {
-                        if (Molecule::atom_names.at(ligand_name).size() <= i) {
-                                vector<string> current_names_list;
-                                Molecule::atom_names.at(ligand_name).push_back(current_names_list);
+Molecule *Application::process_position(const vector<string> &files,
+                                         size_t position) const
+{
+        if (file_entries.empty()) {
+                return process_file(files[position]);
+        }
+
+        /* only the indexed records of the ligand are read */
+        Read_ahead_entry entry;
+        entry.file_name = files[position];
+        entry.success = Ligand_index::read_records(*file_entries[position],
+                                                   entry.content);
+        COUNT(COUNTER_BYTES, entry.content.size());
+        return process_entry(entry);
+}
+
+
+bool Application::read_index(vector<string> &files)
+{
+        /* wanted ligands, all the ligands of the names list by default */
+        set<string> ligands;
+        string ligand;
+        istringstream ss(index_ligands);
+        while (getline(ss, ligand, ',')) {
+                ligands.insert(ligand);
+        }
+        if (ligands.empty()) {
+                for (const auto &x : Molecule::atom_names) {
+                        size_t first = x.first.find_first_not_of(' ');
+                        if (first != string::npos) {
+                                ligands.insert(x.first.substr(first,
+                                        x.first.find_last_not_of(' ') - first + 1));
                         }
-                        Molecule::atom_names.at(ligand_name).at(i).push_back(tmp_vec[i]);
                 }
-                
-                line_number++;
         }
 
-        ifile.close();
+        if (!ligand_index.load(index_file, ligands)) {
+                return false;
+        }
+
+        const vector<Ligand_index_entry> &entries = ligand_index.get_entries();
+        for (size_t index = 0; index < entries.size(); index++) {
+                if (in_shard(index) && index >= resume_offset) {
+                        files.push_back(entries[index].file_name);
+                        file_indices.push_back(index);
+                        file_entries.push_back(&entries[index]);
+                }
+        }
 
         return true;
+}
+
+
+bool Application::build_index()
+{
+        vector<string> files;
+        if (!read_input_list(files)) {
+                return false;
+        }
+
+        /* entries of files are kept in order of the list */
+        vector<vector<Ligand_index_entry>> found(files.size());
+        auto scan = [&](size_t index, size_t) {
+                string content;
+                if (!Conf_analyser::read_file(files[index], content)) {
+                        ostringstream message;
+                        message << "Could not open file " << files[index] << "...\n";
+                        lock_guard<mutex> lock(index_mutex);
+                        diagnostics() << message.str();
+                        return;
+                }
+                Ligand_index::scan(files[index], content, found[index]);
+        };
+        Work_scheduler scheduler(jobs);
+        scheduler.run(vector<size_t>(files.size(), 1), scan);
 
+        vector<Ligand_index_entry> entries;
+        for (auto &x : found) {
+                entries.insert(entries.end(), x.begin(), x.end());
+        }
+        Ligand_index::write(entries, output);
+        if (!output_sink.flush()) {
+                diagnostics() << "Error while writing index!\n";
+                return false;
+        }
+
+        return true;
 }
 
-bool Application::process_file(Molecule* mol, string file_name)
+
+void Application::process_files_parallel(const vector<string> &files,
+                                         const function<bool(size_t)> &passed)
 {
-        vector<Atom*> molecule;
-        
-        if (!read_PDB(file_name, molecule))
-        {
-                goto ERROR;
+        /* sizes of files are the estimates of their processing costs,
+           files passed on one by one are taken in the order of the list */
+        size_t count = files.size();
+        vector<size_t> costs(count, 0);
+        for (size_t i = 0; i < count; i++) {
+                struct stat info;
+                if (passed) {
+                        costs[i] = count - i;
+                } else if (stat(files[i].c_str(), &info) == 0) {
+                        costs[i] = info.st_size;
+                }
         }
 
-        if (!mol->initialize(molecule))
-        {
-                goto ERROR;
+        /* results and diagnostics are kept per file and passed on in the
+           order of the list as soon as all the preceding files are done,
+           so the output does not depend on scheduling */
+        vector<Molecule*> results(count, nullptr);
+        vector<string> messages(count);
+        vector<bool> done(count, false);
+        size_t next_to_pass = 0;
+        bool stopped = false;
+        Work_scheduler scheduler(jobs);
+        scheduler.run(costs, [&](size_t index, size_t) {
+                ostringstream file_diagnostics;
+                set_thread_diagnostics(&file_diagnostics);
+                results[index] = process_position(files, index);
+                set_thread_diagnostics(nullptr);
+
+                {
+                        lock_guard<mutex> lock(results_mutex);
+                        messages[index] = file_diagnostics.str();
+                        done[index] = true;
+                        while (!stopped && next_to_pass < count && done[next_to_pass]) {
+                                diagnostics() << messages[next_to_pass];
+                                messages[next_to_pass].clear();
+                                add_molecule(results[next_to_pass],
+                                             file_indices[next_to_pass]);
+                                results[next_to_pass] = nullptr;
+                                next_to_pass++;
+                                if (passed && !passed(next_to_pass)) {
+                                        stopped = true;
+                                        scheduler.stop();
+                                }
+                        }
+                }
+                maybe_checkpoint();
+        });
+
+        /* files analysed after the stop are not passed on */
+        for (auto x : results) {
+                delete(x);
         }
 
-        if (!mol->analyse()) {
-                goto ERROR;
+        if (print_workers) {
+                diagnostics() << '\n';
+                scheduler.report(diagnostics());
         }
+}
 
-        return true;
- ERROR:
-        cout << file_name << ": ommited\n";
-        return false;
- }
 
 
+void Application::process_sample(vector<string> &files)
+{
+        /* files of the list (with their positions and index entries) are
+           shuffled, the seed makes the sample reproducible */
+        vector<size_t> order(files.size());
+        iota(order.begin(), order.end(), 0);
+        shuffle(order.begin(), order.end(), mt19937_64(sample_seed));
+        vector<string> shuffled_files(files.size());
+        vector<size_t> shuffled_indices(files.size());
+        vector<const Ligand_index_entry*> shuffled_entries(file_entries.size());
+        for (size_t i = 0; i < order.size(); i++) {
+                shuffled_files[i] = files[order[i]];
+                shuffled_indices[i] = file_indices[order[i]];
+                if (!file_entries.empty()) {
+                        shuffled_entries[i] = file_entries[order[i]];
+                }
+        }
+        files.swap(shuffled_files);
+        file_indices.swap(shuffled_indices);
+        file_entries.swap(shuffled_entries);
+
+        sample_estimate.set_conformations(analyser.conformations());
+
+        /* intervals are checked only at the looks, when the sample has
+           doubled (and at its end), each look with its own share of the
+           level (see Frequency_estimate) */
+        size_t look = 0;
+        size_t next_look = SAMPLE_FIRST_LOOK;
+        auto passed = [&](size_t count) {
+                sampled = count;
+                if (count < next_look && count < files.size()) {
+                        return true;
+                }
+                next_look *= 2;
+                sample_estimate.set_look(++look);
+                return sample_estimate.get_total() == 0 ||
+                       sample_estimate.max_width() >= sample_width;
+        };
+
+        sampled = 0;
+        if (jobs > 1) {
+                process_files_parallel(files, passed);
+        } else {
+                for (size_t i = 0; i < files.size(); i++) {
+                        add_molecule(process_position(files, i), file_indices[i]);
+                        if (!passed(i + 1)) {
+                                break;
+                        }
+                }
+        }
+
+        char width[32];
+        snprintf(width, sizeof(width), "%.4f", sample_estimate.max_width());
+        diagnostics() << "Sampled " << sampled << " of " << files.size()
+                      << " files, " << sample_estimate.get_total()
+                      << " rings, widest interval " << width << '\n';
+}
+
 void Application::help() const
 {
         cout << "Usage:" << endl;
         cout << "   " << argv[0]
-             << " [-h] -i file_list.txt -n name_list.txt --(ring_type) [-l | -s | -a]"
+             << " [-h] (-i file_list.txt | -t archive.tar) -n name_list.txt --(ring_type) [-l | -s | -a]"
+             << endl;
+        cout << "   " << argv[0]
+             << " merge [-l | -s | -a] [-f format] [-o output] partial_result..."
+             << endl;
+        cout << "   " << argv[0]
+             << " diff [-l | -s | -a] [-o output] old_result new_result"
+             << endl;
+        cout << "   " << argv[0]
+             << " --server=socket -n name_list.txt --(ring_type) [-j threads]"
+             << endl;
+        cout << "   " << argv[0]
+             << " compile-names -n name_list.txt --(ring_type) -o compiled_names"
+             << endl;
+        cout << "   " << argv[0]
+             << " index -i file_list.txt -o ligand_index [-j threads]"
              << endl << endl ;
         cout << "Required:" << endl;
         cout << "   -i --input_list=FILE" << endl
              << "      read list of molecules to process from FILE - each line is treated as path to single PDB file" << endl;
+        cout << "   -t --tar=FILE" << endl
+             << "      read molecules to process directly from tar archive FILE (may be compressed by gzip) instead" << endl
+             << "      of the -i list - each regular file of the archive is treated as single PDB file (optionally" << endl
+             << "      compressed by gzip) and reported under its name in the archive" << endl;
+        cout << "   --index=FILE" << endl
+             << "      instead of the -i list, analyse only files containing the wanted ligands according to ligand" << endl
+             << "      index FILE (created by the index subcommand), reading just the records of the ligand and the" << endl
+             << "      header records read by --max_resolution, --method and --released_after/before" << endl;
         cout << "   -n --name_list=FILE" << endl
              << "      read list of names of atom ring from FILE. Each line represents one ligand, first word on the" << endl
              << "      line is treated as ligand name, all the following words are treated as atom names (if ligand is" << endl
              << "      not known or if name of the atom is not found in this list, processed atom will be ommited)." << endl
              << "      In case of multiple name variations, more lines with the same ligand name has to be present." << endl
-             << "      Atom order matters!" << endl;
+             << "      Atom order matters! The list may also be compiled by the compile-names subcommand to a binary" << endl
+             << "      table (written to -o FILE), which is loaded without parsing and used the same way." << endl;
         cout << "   --(ring_type)" << endl
              << "      perform analysis of this type of molecule ring" << endl
              << "      currently supported:" << endl
@@ -219,6 +656,161 @@ void Application::help() const
              << "      display results only as a short summary of relative occurances of conformations among tested molecules" << endl;
         cout << "   -a --all" << endl
              << "      display both list and summary (turned on by default, unless one of -l/-s options is detected)" << endl;
+        cout << "   --ligand=CODES" << endl
+             << "      comma separated residue names wanted from --index (default all the ligands of the name list)" << endl;
+        cout << "   --max_resolution=ANGSTROMS" << endl
+             << "      analyse only structures with resolution (REMARK 2) of at most ANGSTROMS" << endl;
+        cout << "   --method=METHODS" << endl
+             << "      analyse only structures determined by one of comma separated METHODS (EXPDTA record):" << endl
+             << "      XRAY, NMR, EM, NEUTRON, FIBER or ED, e.g. --method=XRAY,NEUTRON" << endl;
+        cout << "   --released_after=DATE" << endl
+             << "   --released_before=DATE" << endl
+             << "      analyse only structures released (REVDAT 1) on or after/on or before DATE (YYYY-MM-DD)" << endl
+             << "      Header filters are applied before the coordinates are parsed, structures missing the" << endl
+             << "      requested information are rejected" << endl;
+        cout << "   --altloc=MODE" << endl
+             << "      choice among alternate locations of a residue: best (default, location with the highest" << endl
+             << "      occupancy), first (location appearing first) or all (keep all of them, so that ring with" << endl
+             << "      alternate atoms is omitted for duplicate atoms)" << endl;
+        cout << "   --min_occupancy=VALUE" << endl
+             << "   --max_b_factor=VALUE" << endl
+             << "      ignore atoms with occupancy lower than VALUE/temperature factor higher than VALUE (atoms" << endl
+             << "      without the value pass), ring with some of its atoms ignored is omitted for missing atoms" << endl;
+        cout << "   --engine=ENGINE" << endl
+             << "      recognize conformations by geometric (default, planes of ring atoms) or torsion engine" << endl
+             << "      (signs and magnitudes of endocyclic torsions, torsions under 10 degrees count as zero);" << endl
+             << "      torsions are written by csv, json and columnar formats with both of them" << endl;
+        cout << "   --precision_check" << endl
+             << "      report rings classified differently by the selected --engine in single (float32 batch" << endl
+             << "      path) and double precision to diagnostics" << endl;
+        cout << "   --confidence=TRIALS" << endl
+             << "      estimate confidence of every conformation by classifying the ring again TRIALS times with" << endl
+             << "      its atoms displaced by gaussian noise (e.g. --confidence=1000), confidence is the fraction" << endl
+             << "      of trials keeping the conformation; deviation of the noise is derived from temperature" << endl
+             << "      factors of the atoms (sqrt(B / 8 pi^2), 0.1 A for atoms without B-factor)" << endl;
+        cout << "   --noise_sigma=ANGSTROMS" << endl
+             << "      use fixed deviation of the noise of --confidence instead of the temperature factors" << endl;
+        cout << "   --sample=WIDTH" << endl
+             << "      process files of the -i list (or of --index) in random order and stop once the 95% confidence" << endl
+             << "      intervals of frequencies of all the conformations are narrower than WIDTH (e.g. --sample=0.05);" << endl
+             << "      the intervals are checked whenever the sample has doubled (from 16 files), the" << endl
+             << "      level is split among the checks so that it holds for the sample where the run stopped;" << endl
+             << "      intervals (Wilson, simultaneous for all the conformations) are added to the summary and the" << endl
+             << "      number of sampled files is written to diagnostics" << endl;
+        cout << "   --sample_seed=N" << endl
+             << "      seed of the random order of --sample (default 0), the same seed gives the same sample" << endl;
+        cout << "   --bootstrap=RESAMPLES" << endl
+             << "      add 95% percentile bootstrap intervals of frequencies of conformations to the summary and to" << endl
+             << "      the --group_by table, computed from RESAMPLES resamples of the rings (e.g. --bootstrap=1000)" << endl
+             << "      in -j threads" << endl;
+        cout << "   --group_by=FIELDS" << endl
+             << "      also display table of counts of conformations per group of rings, FIELDS is comma separated" << endl
+             << "      list of ligand, chain (chain of the structure) and entry (file name without extensions)," << endl
+             << "      e.g. --group_by=ligand or --group_by=ligand,chain (text format only)" << endl;
+        cout << "   --distributions" << endl
+             << "      also display quantiles of plane_distance, right_distance, left_distance, dihedral and" << endl
+             << "      puckering_amplitude of rings per conformation, estimated by streaming quantile sketches" << endl
+             << "      (KLL, rank error about 1%) fed as the rings are analysed; the sketches are kept in partial" << endl
+             << "      results and checkpoints and combined by merge (text format only)" << endl;
+        cout << "   --histograms" << endl
+             << "      also display histograms of the same descriptors per conformation (text format only)" << endl;
+        cout << "   -f --format=FORMAT" << endl
+             << "      write results in FORMAT: text (default), csv, json (one object per line) or columnar" << endl
+             << "      (compact binary columns); all but text write only the list of analysed rings with their" << endl
+             << "      geometric descriptors and imply -l" << endl;
+        cout << "   -o --output=FILE" << endl
+             << "      write results to FILE instead of standard output" << endl;
+        cout << "   -d --diagnostics=FILE" << endl
+             << "      write warnings and reasons of ommited files to FILE instead of standard error output" << endl;
+        cout << "   --read_ahead=K" << endl
+             << "      read up to K following files of the input list in dedicated I/O threads while the current one" << endl
+             << "      is analysed (default 0, files are read one by one)" << endl;
+        cout << "   --read_ahead_memory=MB" << endl
+             << "      read ahead only files fitting with those waiting for analysis into MB megabytes (default 256)," << endl
+             << "      a larger file is read when nothing else waits" << endl;
+        cout << "   --io_threads=N" << endl
+             << "      number of I/O threads reading ahead (default 1)" << endl;
+        cout << "   -j --jobs=N" << endl
+             << "      analyse files of the input list in N threads (default 1); the largest files are started first" << endl
+             << "      and idle threads take over files waiting for the busy ones, results keep the order of the list" << endl;
+        cout << "   --workers" << endl
+             << "      print number of files and utilisation of particular threads of -j to diagnostics" << endl;
+        cout << "   --shard=k/N" << endl
+             << "      process only k-th of N shards of the input - files (or archive members) on positions k, k+N," << endl
+             << "      k+2N, ... so that a run can be split among more machines" << endl;
+        cout << "   --partial" << endl
+             << "      write partial result (counts of conformations and the list of analysed rings) instead of the" << endl
+             << "      list and summary; partial results of all the shards are combined by the merge subcommand to" << endl
+             << "      the same output as of a single run; results of two runs (partial or csv results) are" << endl
+             << "      compared by the diff subcommand, which lists rings with changed conformation (~), added (+)" << endl
+             << "      and removed (-) rings by file, ligand, chain and residue (-l) and matrix of transitions of" << endl
+             << "      conformations (-s)" << endl;
+        cout << "   --checkpoint=FILE" << endl
+             << "      periodically save position in the input and results so far to FILE, which is removed once" << endl
+             << "      the run finishes" << endl;
+        cout << "   --checkpoint_interval=SECONDS" << endl
+             << "      save the checkpoint every SECONDS seconds (default 60)" << endl;
+        cout << "   --resume" << endl
+             << "      continue the interrupted run from its --checkpoint (run with the same options), files done" << endl
+             << "      before the checkpoint are skipped" << endl;
+        cout << "   --server=SOCKET" << endl
+             << "      load the atom names once and answer analysis requests of clients on Unix socket SOCKET" << endl
+             << "      in -j threads; a request is a line 'FILE path' or 'PDB size name' followed by size bytes of" << endl
+             << "      PDB data, the answer is a line with JSON object of the result (or of the error); SIGINT or" << endl
+             << "      SIGTERM stops the server after answering the requests being analysed" << endl;
+        cout << "   --max_request=MB" << endl
+             << "      refuse PDB data of --server requests larger than MB megabytes (default 64)" << endl;
+        cout << "   --client_timeout=SECONDS" << endl
+             << "      close connection of --server client which sends nothing for SECONDS seconds (default 60)" << endl;
+        cout << "   --watch=DIR" << endl
+             << "      instead of the -i list, analyse PDB files as they are written to directory DIR (or its" << endl
+             << "      subdirectories) and append their results to the output right away; a file written again" << endl
+             << "      replaces its older result, summary is printed when stopped by SIGINT or SIGTERM; with" << endl
+             << "      --checkpoint the state of the watch is saved and can be continued by --resume" << endl;
+        cout << "   --profile" << endl
+             << "      print time spent in particular stages and counts of ommited files by reason to diagnostics" << endl
+             << "      (available only when built with 'make profile')" << endl;
+        cout << "   --profile_json=FILE" << endl
+             << "      write the same profile as a JSON object to FILE" << endl;
+}
+
+
+/* Non-negative decimal number of a command line option */
+static bool parse_count(const char *arg, size_t &value)
+{
+        char *end = nullptr;
+        if (arg == nullptr || *arg == '\0' || *arg == '-') {
+                return false;
+        }
+        value = strtoul(arg, &end, 10);
+        return *end == '\0';
+}
+
+
+/* Non-negative real number */
+static bool parse_real(const char *arg, double &value)
+{
+        char *end = nullptr;
+        if (arg == nullptr || *arg == '\0' || *arg == '-') {
+                return false;
+        }
+        value = strtod(arg, &end);
+        return *end == '\0';
+}
+
+
+/* Shard of a run given as k/N */
+static bool parse_shard(const char *arg, size_t &shard, size_t &shards)
+{
+        const char *slash = (arg == nullptr) ? nullptr : strchr(arg, '/');
+        if (slash == nullptr) {
+                return false;
+        }
+
+        string first(arg, slash - arg);
+        return parse_count(first.c_str(), shard) &&
+               parse_count(slash + 1, shards) &&
+               shard >= 1 && shard <= shards;
 }
 
 
@@ -244,10 +836,70 @@ void Application::parse_options()
                 {"all",          no_argument,       nullptr,        'a'},
                 {"input_list",   required_argument, nullptr,        'i'},
                 {"name_list",    required_argument, nullptr,        'n'},
+                {"tar",          required_argument, nullptr,        't'},
+                {"format",       required_argument, nullptr,        'f'},
+                {"output",       required_argument, nullptr,        'o'},
+                {"diagnostics",  required_argument, nullptr,        'd'},
+                {"profile",      no_argument,       nullptr,        'P'},
+                {"profile_json", required_argument, nullptr,        'J'},
+                {"read_ahead",   required_argument, nullptr,        'R'},
+                {"read_ahead_memory", required_argument, nullptr,   'M'},
+                {"io_threads",   required_argument, nullptr,        'T'},
+                {"jobs",         required_argument, nullptr,        'j'},
+                {"workers",      no_argument,       nullptr,        'W'},
+                {"shard",        required_argument, nullptr,        'S'},
+                {"partial",      no_argument,       nullptr,        'p'},
+                {"checkpoint",   required_argument, nullptr,        'c'},
+                {"checkpoint_interval", required_argument, nullptr, 'I'},
+                {"resume",       no_argument,       nullptr,        'r'},
+                {"server",       required_argument, nullptr,        'L'},
+                {"max_request",  required_argument, nullptr,        'm'},
+                {"client_timeout", required_argument, nullptr,      'u'},
+                {"watch",        required_argument, nullptr,        'w'},
+                {"group_by",     required_argument, nullptr,        'g'},
+                {"index",        required_argument, nullptr,        'x'},
+                {"ligand",       required_argument, nullptr,        'G'},
+                {"max_resolution", required_argument, nullptr,      'Q'},
+                {"method",       required_argument, nullptr,        'E'},
+                {"released_after", required_argument, nullptr,      'A'},
+                {"released_before", required_argument, nullptr,     'B'},
+                {"altloc",       required_argument, nullptr,        'K'},
+                {"min_occupancy", required_argument, nullptr,       'O'},
+                {"max_b_factor", required_argument, nullptr,        'F'},
+                {"confidence",   required_argument, nullptr,        'C'},
+                {"noise_sigma",  required_argument, nullptr,        'N'},
+                {"engine",       required_argument, nullptr,        'e'},
+                {"precision_check", no_argument,    nullptr,        'V'},
+                {"sample",       required_argument, nullptr,        'Y'},
+                {"sample_seed",  required_argument, nullptr,        'Z'},
+                {"bootstrap",    required_argument, nullptr,        'U'},
+                {"distributions", no_argument,      nullptr,        'D'},
+                {"histograms",   no_argument,       nullptr,        'H'},
                 {0, 0, 0, 0}
         };
         /* short options */
-        static const char *short_opt = "hlsai:n:";
+        static const char *short_opt = "hlsai:n:t:f:o:d:j:";
+
+        /* merge subcommand takes partial results instead of input */
+        if (argc > 1 && strcmp(argv[1], "merge") == 0) {
+                merge_mode = true;
+                optind = 2;
+        }
+        /* diff subcommand compares results of two runs */
+        if (argc > 1 && strcmp(argv[1], "diff") == 0) {
+                diff_mode = true;
+                optind = 2;
+        }
+        /* index subcommand writes index of ligands of the input list */
+        if (argc > 1 && strcmp(argv[1], "index") == 0) {
+                index_mode = true;
+                optind = 2;
+        }
+        /* compile-names subcommand writes the compiled list of names */
+        if (argc > 1 && strcmp(argv[1], "compile-names") == 0) {
+                compile_mode = true;
+                optind = 2;
+        }
 
         /* Proces all of the arguments */
         while(true) {
@@ -304,113 +956,920 @@ void Application::parse_options()
                                 }
                                 atom_names_list = optarg;
                                 break;
-                        case '?':
-                                cout << "Terminating...";
-                                goto END;
-                        default:
-                                cout << "Error: getopt_long() returned unexpected char: '" << opt << "'" << endl;
-                                abort ();
-                }
-        }
-
-        /* check that required arguments were found */
-        if (input_file_list.empty() || analysis_type == EMPTY) {
-                cout << "Some required arguments are missing!";
-                goto END;
-        }
-
-        return;
-
-END:
-        cout << endl << endl;
-        help();
-        exit(0);
-}
-
-
-void Application::results(vector<Molecule*> molecules){
-        if (print_list) {
-                for (auto x : molecules) {
-                        cout << *x;
-                }
-        }
-
-        if (print_list && print_summary) {
-                cout << endl;
-        }
-
-        if (print_summary) {
-                if (!molecules.empty()) {
-                        cout << "SUMMARY" << endl << "-------" << endl;
-                        Molecule::statistics(molecules);
-                } else {
-                        cout << "No molecules detected!" << endl;
-                }
-        }
-}
-
-
-int Application::run()
-{
-        /* Parse command line arguments */
-        parse_options();
-
-        /* Read list of atom names */
-        if (!read_atom_names()) {
-                return EXIT_FAILURE;
-        }
-
-        /* Test print of read atom names */
-        /*for (const auto &x : atom_names) {
-                cout << "[" << x.first << "]" << endl;
-                for (const auto &y : x.second) {
-                        cout << "   ";
-                        for (const auto &z : y) {
-                                cout << "\"" << z << "\" ";
-                        }
-                        cout << endl;
-                }
-        }*/
-
-        /* Open list of molecules */
-        string line;
-        ifstream f(input_file_list);
-        if (!f.is_open()) {
-                cerr << "Error while opening file " << input_file_list << endl;
-                return EXIT_FAILURE;
-        }
-
-        /* Read molecules from list of molecules and proccess them */ 
-        Molecule* tmp;
-        while(getline(f, line)) {
-                switch (analysis_type) {
-                        case CYCLOHEXANE:
-                                tmp = new Cyclohexane(line);
+                        case 't':
+                                input_archive = optarg;
                                 break;
-                        case CYCLOPENTANE:
-                                tmp = new Cyclopentane(line);
+                        case 'f':
+                                output_format = Result_writer::format_from_name(optarg);
+                                if (output_format == -1) {
+                                        cout << "Unknown output format '" << optarg << "'!";
+                                        goto END;
+                                }
                                 break;
-                        case BENZENE:
-                                tmp = new Benzene(line);
+                        case 'o':
+                                output_file = optarg;
                                 break;
-                        case OXANE:
-                                tmp = new Oxane(line);
+                        case 'd':
+                                diagnostics_file = optarg;
                                 break;
-                        default:
-                                cerr << "Unknown type of analysis!" << endl;
-                                return EXIT_FAILURE;
-                }
+                        case 'P':
+                                print_profile = true;
+                                break;
+                        case 'J':
+                                profile_file = optarg;
+                                break;
+                        case 'R':
+                                if (!parse_count(optarg, read_ahead_depth)) {
+                                        cout << "Invalid read ahead depth!";
+                                        goto END;
+                                }
+                                break;
+                        case 'M':
+                                if (!parse_count(optarg, read_ahead_memory) ||
+                                    read_ahead_memory == 0) {
+                                        cout << "Invalid read ahead memory budget!";
+                                        goto END;
+                                }
+                                break;
+                        case 'T':
+                                if (!parse_count(optarg, io_threads) ||
+                                    io_threads == 0) {
+                                        cout << "Invalid number of I/O threads!";
+                                        goto END;
+                                }
+                                break;
+                        case 'j':
+                                if (!parse_count(optarg, jobs) || jobs == 0) {
+                                        cout << "Invalid number of jobs!";
+                                        goto END;
+                                }
+                                break;
+                        case 'W':
+                                print_workers = true;
+                                break;
+                        case 'S':
+                                if (!parse_shard(optarg, shard, shards)) {
+                                        cout << "Shard has to be given as k/N with 1 <= k <= N!";
+                                        goto END;
+                                }
+                                break;
+                        case 'p':
+                                write_partial = true;
+                                break;
+                        case 'c':
+                                checkpoint_file = optarg;
+                                break;
+                        case 'I':
+                                if (!parse_count(optarg, checkpoint_interval)) {
+                                        cout << "Invalid checkpoint interval!";
+                                        goto END;
+                                }
+                                break;
+                        case 'r':
+                                resume = true;
+                                break;
+                        case 'L':
+                                server_socket = optarg;
+                                break;
+                        case 'm':
+                                if (!parse_count(optarg, max_request) ||
+                                    max_request == 0) {
+                                        cout << "Invalid limit of request size!";
+                                        goto END;
+                                }
+                                break;
+                        case 'u':
+                                if (!parse_count(optarg, client_timeout) ||
+                                    client_timeout == 0) {
+                                        cout << "Invalid client timeout!";
+                                        goto END;
+                                }
+                                break;
+                        case 'w':
+                                watch_directory = optarg;
+                                break;
+                        case 'x':
+                                index_file = optarg;
+                                break;
+                        case 'G':
+                                index_ligands = optarg;
+                                break;
+                        case 'Q': {
+                                double resolution;
+                                if (!parse_real(optarg, resolution)) {
+                                        cout << "Invalid maximal resolution!";
+                                        goto END;
+                                }
+                                header_filter.set_max_resolution(resolution);
+                                break;
+                        }
+                        case 'E':
+                                if (!header_filter.set_methods(optarg)) {
+                                        cout << "Unknown experimental method in '" << optarg << "'!";
+                                        goto END;
+                                }
+                                break;
+                        case 'A':
+                                if (!header_filter.set_released_after(optarg)) {
+                                        cout << "Invalid date '" << optarg << "', expected YYYY-MM-DD!";
+                                        goto END;
+                                }
+                                break;
+                        case 'B':
+                                if (!header_filter.set_released_before(optarg)) {
+                                        cout << "Invalid date '" << optarg << "', expected YYYY-MM-DD!";
+                                        goto END;
+                                }
+                                break;
+                        case 'K':
+                                if (!atom_selection.set_altloc(optarg)) {
+                                        cout << "Unknown choice of alternate locations '" << optarg << "'!";
+                                        goto END;
+                                }
+                                break;
+                        case 'O': {
+                                double occupancy;
+                                if (!parse_real(optarg, occupancy)) {
+                                        cout << "Invalid minimal occupancy!";
+                                        goto END;
+                                }
+                                atom_selection.set_min_occupancy(occupancy);
+                                break;
+                        }
+                        case 'F': {
+                                double temp_factor;
+                                if (!parse_real(optarg, temp_factor)) {
+                                        cout << "Invalid maximal B-factor!";
+                                        goto END;
+                                }
+                                atom_selection.set_max_temp_factor(temp_factor);
+                                break;
+                        }
+                        case 'C':
+                                if (!parse_count(optarg, confidence_trials)) {
+                                        cout << "Invalid number of confidence trials!";
+                                        goto END;
+                                }
+                                break;
+                        case 'N':
+                                if (!parse_real(optarg, confidence_sigma)) {
+                                        cout << "Invalid deviation of noise!";
+                                        goto END;
+                                }
+                                break;
+                        case 'e':
+                                engine = engine_from_name(optarg);
+                                if (engine == -1) {
+                                        cout << "Unknown engine '" << optarg << "'!";
+                                        goto END;
+                                }
+                                break;
+                        case 'V':
+                                precision_check = true;
+                                break;
+                        case 'Y':
+                                if (!parse_real(optarg, sample_width) ||
+                                    sample_width <= 0 || sample_width > 1) {
+                                        cout << "Width of intervals has to be in (0, 1]!";
+                                        goto END;
+                                }
+                                break;
+                        case 'U':
+                                if (!parse_count(optarg, bootstrap_resamples)) {
+                                        cout << "Invalid number of bootstrap resamples!";
+                                        goto END;
+                                }
+                                break;
+                        case 'Z':
+                                if (!parse_count(optarg, sample_seed)) {
+                                        cout << "Invalid seed of sampling!";
+                                        goto END;
+                                }
+                                break;
+                        case 'D':
+                                print_distributions = true;
+                                break;
+                        case 'H':
+                                print_histograms = true;
+                                break;
+                        case 'g':
+                                group_fields = Group_statistics::fields_from_names(optarg);
+                                if (group_fields == 0) {
+                                        cout << "Unknown field to group by in '" << optarg << "'!";
+                                        goto END;
+                                }
+                                break;
+                        case '?':
+                                cout << "Terminating...";
+                                goto END;
+                        default:
+                                cout << "Error: getopt_long() returned unexpected char: '" << opt << "'" << endl;
+                                abort ();
+                }
+        }
 
-                if (!process_file(tmp, line)) {
-                        delete(tmp);
-                        continue;
+        /* structured formats carry the list only */
+        if (output_format != FORMAT_TEXT) {
+                if (group_fields != 0) {
+                        cout << "Grouped statistics are available only in text format!";
+                        goto END;
+                }
+                if (print_distributions || print_histograms) {
+                        cout << "Distributions of descriptors are available only in text format!";
+                        goto END;
                 }
+                if (display_option_set && print_summary) {
+                        cout << "Summary is available only in text format!";
+                        goto END;
+                }
+                print_summary = false;
+        }
 
-                molecules.push_back(tmp);
+        if ((print_profile || !profile_file.empty()) &&
+            !Instrumentation::enabled()) {
+                cerr << "Profiling is not compiled in, rebuild with 'make profile'..." << endl;
         }
 
+        if (merge_mode) {
+                if (!input_file_list.empty() || !input_archive.empty() ||
+                    shards != 0 || write_partial ||
+                    !checkpoint_file.empty()) {
+                        cout << "Only output options can be used with merge!";
+                        goto END;
+                }
+                for (int i = optind; i < argc; i++) {
+                        partial_files.push_back(argv[i]);
+                }
+                if (partial_files.empty()) {
+                        cout << "No partial results to merge!";
+                        goto END;
+                }
+                return;
+        }
+
+        if (diff_mode) {
+                if (!input_file_list.empty() || !input_archive.empty() ||
+                    shards != 0 || write_partial ||
+                    !checkpoint_file.empty() ||
+                    output_format != FORMAT_TEXT) {
+                        cout << "Only -l, -s, -a, -o and -d options can be used with diff!";
+                        goto END;
+                }
+                for (int i = optind; i < argc; i++) {
+                        diff_files.push_back(argv[i]);
+                }
+                if (diff_files.size() != 2) {
+                        cout << "Diff needs exactly two results (old and new)!";
+                        goto END;
+                }
+                return;
+        }
+
+        if (index_mode) {
+                if (input_file_list.empty()) {
+                        cout << "Some required arguments are missing!";
+                        goto END;
+                }
+                return;
+        }
+
+        if (compile_mode) {
+                if (atom_names_list.empty() || analysis_type == EMPTY) {
+                        cout << "Some required arguments are missing!";
+                        goto END;
+                }
+                return;
+        }
+
+        if (!server_socket.empty()) {
+                if (!input_file_list.empty() || !input_archive.empty() ||
+                    shards != 0 || write_partial || !checkpoint_file.empty()) {
+                        cout << "Server does not take any input options!";
+                        goto END;
+                }
+                if (analysis_type == EMPTY) {
+                        cout << "Some required arguments are missing!";
+                        goto END;
+                }
+                return;
+        }
+
+        if (resume && checkpoint_file.empty()) {
+                cout << "Option --resume requires --checkpoint!";
+                goto END;
+        }
+
+        if (write_partial && output_format != FORMAT_TEXT) {
+                cout << "Partial result can not be written in other formats!";
+                goto END;
+        }
+
+        if ((!input_file_list.empty()) + (!input_archive.empty()) +
+            (!watch_directory.empty()) + (!index_file.empty()) > 1) {
+                cout << "Only one of -i/-t/--watch/--index options can be specified!";
+                goto END;
+        }
+
+        if (!index_ligands.empty() && index_file.empty()) {
+                cout << "Option --ligand requires --index!";
+                goto END;
+        }
+
+        if (!index_file.empty() && read_ahead_depth > 0) {
+                cout << "Option --read_ahead can not be used with --index!";
+                goto END;
+        }
+
+        if (!watch_directory.empty() &&
+            (jobs > 1 || read_ahead_depth > 0 || shards != 0 ||
+             write_partial || output_format == FORMAT_COLUMNAR)) {
+                cout << "Options -j, --read_ahead, --shard, --partial and columnar format can not be used with --watch!";
+                goto END;
+        }
+
+        if (sample_width > 0 &&
+            ((input_file_list.empty() && index_file.empty()) ||
+             read_ahead_depth > 0 || !checkpoint_file.empty())) {
+                cout << "Option --sample can be used only with -i/--index and without --read_ahead and --checkpoint!";
+                goto END;
+        }
+
+        if (jobs > 1 && (read_ahead_depth > 0 || !input_archive.empty())) {
+                cout << "Option -j can be used only with -i/--index and without --read_ahead!";
+                goto END;
+        }
+
+        /* check that required arguments were found */
+        if ((input_file_list.empty() && input_archive.empty() &&
+             watch_directory.empty() && index_file.empty()) ||
+            analysis_type == EMPTY) {
+                cout << "Some required arguments are missing!";
+                goto END;
+        }
+
+        return;
+
+END:
+        cout << endl << endl;
+        help();
+        exit(0);
+}
+
+
+/* Line of the text list of results */
+static void print_ring(const Ring_result &ring, ostream &out)
+{
+        size_t sep = ring.structure.find_last_of("/");
+        out << ((sep == string::npos) ? ring.structure :
+                ring.structure.substr(sep + 1))
+            << ": " << ring.conformation_name;
+        if (ring.confidence >= 0) {
+                char buffer[32];
+                snprintf(buffer, sizeof(buffer), " (confidence %.3f)",
+                         ring.confidence);
+                out << buffer;
+        }
+        out << '\n';
+}
+
+
+void Application::results(const Partial_result &rings, ostream &out)
+{
+        if (print_list) {
+                for (const auto &x : rings.get_indexed_results()) {
+                        print_ring(x.second, out);
+                }
+        }
+
+        if (print_list && print_summary) {
+                out << '\n';
+        }
+
+        if (print_summary) {
+                summary(rings, out);
+        }
+
+        if (group_fields != 0) {
+                if (print_list || print_summary) {
+                        out << '\n';
+                }
+                groups(rings, out);
+        }
+
+        if (print_distributions || print_histograms) {
+                if (print_list || print_summary || group_fields != 0) {
+                        out << '\n';
+                }
+                distributions(rings, out);
+        }
+}
+
+
+void Application::groups(const Partial_result &rings, ostream &out)
+{
+        Group_statistics statistics(group_fields, rings.get_conformations());
+        statistics.add_all(rings.get_results(), jobs);
+        if (bootstrap_resamples > 0) {
+                Bootstrap bootstrap(bootstrap_resamples, jobs);
+                statistics.print(out, &bootstrap);
+        } else {
+                statistics.print(out);
+        }
+}
+
+
+void Application::distributions(const Partial_result &rings, ostream &out)
+{
+        const Descriptor_statistics &statistics = rings.get_statistics();
+        if (print_distributions) {
+                statistics.print_quantiles(out);
+        }
+        if (print_distributions && print_histograms) {
+                out << '\n';
+        }
+        if (print_histograms) {
+                statistics.print_histograms(out);
+        }
+}
+
+
+void Application::summary(const Partial_result &rings, ostream &out)
+{
+        if (!rings.get_indexed_results().empty()) {
+                out << "SUMMARY\n-------\n";
+                Molecule::statistics(rings.get_conformations(),
+                                     rings.get_counts(), out);
+                if (bootstrap_resamples > 0) {
+                        vector<vector<double>> low, high;
+                        Bootstrap(bootstrap_resamples, jobs).intervals(
+                                        {rings.get_counts()}, low, high);
+                        out << "\nFREQUENCIES (95% bootstrap, "
+                            << bootstrap_resamples << " resamples)\n-------\n";
+                        print_frequencies(out, rings.get_conformations(),
+                                          rings.get_counts(), low[0], high[0]);
+                }
+                if (sample_width > 0) {
+                        out << "\nFREQUENCIES (95% confidence, sampled "
+                            << sampled << " files)\n-------\n";
+                        sample_estimate.print(out);
+                }
+        } else {
+                out << "No molecules detected!\n";
+        }
+}
+
+
+Partial_result Application::initial_results() const
+{
+        /* results of resumed run continue those of the checkpoint */
+        Partial_result rings = checkpoint_results;
+        if (!resumed) {
+                rings.set_conformations(analyser.conformations());
+                rings.set_shard(shards == 0 ? 1 : shard,
+                                shards == 0 ? 1 : shards);
+        }
+        return rings;
+}
+
+
+Partial_result Application::collect_results() const
+{
+        Partial_result rings = initial_results();
+        for (size_t i = 0; i < molecules.size(); i++) {
+                rings.add(molecule_indices[i], molecules[i]->get_result());
+        }
+        rings.set_statistics(descriptor_statistics);
+        return rings;
+}
+
+
+bool Application::merge_partials(Partial_result &merged)
+{
+        for (const auto &x : partial_files) {
+                ifstream f(x);
+                if (!f.is_open()) {
+                        diagnostics() << "Error while opening file " << x << '\n';
+                        return false;
+                }
+
+                Partial_result part;
+                if (!part.read(f, x) || !merged.merge(part, x)) {
+                        return false;
+                }
+        }
+
+        for (auto x : merged.missing_shards()) {
+                diagnostics() << "Results of shard " << x << " are missing!\n";
+        }
+
+        return true;
+}
+
+
+bool Application::open_outputs()
+{
+        if (!output_file.empty() && !output_sink.open(output_file)) {
+                cerr << "Could not open file " << output_file << "..." << endl;
+                return false;
+        }
+
+        if (!diagnostics_file.empty() &&
+            !diagnostics_sink.open(diagnostics_file)) {
+                cerr << "Could not open file " << diagnostics_file << "..." << endl;
+                return false;
+        }
+        set_diagnostics(&diagnostics_output);
+
+        return true;
+}
+
+
+/* Set by SIGINT/SIGTERM to finish watching */
+static volatile sig_atomic_t watch_stopped = 0;
+
+
+static void stop_watching(int)
+{
+        watch_stopped = 1;
+}
+
+
+bool Application::watch()
+{
+        Directory_watcher watcher;
+        if (!watcher.open(watch_directory)) {
+                return false;
+        }
+
+        /* state of the watch is kept in the same form as a checkpoint,
+           new result of a file replaces its older one */
+        if (!resumed) {
+                checkpoint_results = collect_results();
+                resumed = true;
+        }
+        map<string, size_t> positions;
+        for (const auto &x : checkpoint_results.get_indexed_results()) {
+                positions[x.second.structure] = x.first;
+                processed = max(processed, x.first + 1);
+        }
+
+        /* sketches do not forget values, so those of every WATCH_BLOCK
+           positions are kept apart as well; a file analysed again
+           rebuilds only its block and the whole statistics are merged
+           from the blocks once they are needed */
+        vector<Descriptor_statistics> blocks;
+        auto block = [&](size_t index) -> Descriptor_statistics & {
+                size_t b = index / WATCH_BLOCK;
+                while (blocks.size() <= b) {
+                        blocks.push_back(Descriptor_statistics(
+                                        analyser.conformations(), blocks.size()));
+                }
+                return blocks[b];
+        };
+        for (const auto &x : checkpoint_results.get_indexed_results()) {
+                block(x.first).add(x.second);
+        }
+        bool statistics_stale = false;
+        auto merge_blocks = [&]() {
+                if (statistics_stale) {
+                        descriptor_statistics = Descriptor_statistics(
+                                        analyser.conformations(), shard);
+                        for (const auto &x : blocks) {
+                                descriptor_statistics.merge(x);
+                        }
+                        statistics_stale = false;
+                }
+        };
+
+        /* signals interrupt waiting for changes, they are blocked
+           otherwise, so that one coming just before the wait is not lost */
+        struct sigaction action;
+        memset(&action, 0, sizeof(action));
+        action.sa_handler = stop_watching;
+        sigaction(SIGINT, &action, nullptr);
+        sigaction(SIGTERM, &action, nullptr);
+        sigset_t stop_signals, wait_mask;
+        sigemptyset(&stop_signals);
+        sigaddset(&stop_signals, SIGINT);
+        sigaddset(&stop_signals, SIGTERM);
+        sigprocmask(SIG_BLOCK, &stop_signals, &wait_mask);
+        sigdelset(&wait_mask, SIGINT);
+        sigdelset(&wait_mask, SIGTERM);
+        watcher.set_wait_mask(wait_mask);
+
+        Result_writer *writer = Result_writer::create(output_format, output);
+        if (writer != nullptr) {
+                writer->begin();
+        }
+        output_sink.flush();
+        diagnostics() << "Watching " << watch_directory << '\n';
+        diagnostics_sink.flush();
+
+        string path;
+        while (!watch_stopped && watcher.next(path)) {
+                auto itr = positions.find(path);
+                size_t index = (itr == positions.end()) ? processed++ :
+                                                          itr->second;
+                positions[path] = index;
+
+                Molecule *mol = process_file(path);
+                if (mol == nullptr) {
+                        checkpoint_results.remove(index);
+                } else {
+                        Ring_result ring = mol->get_result();
+                        delete(mol);
+                        checkpoint_results.add(index, ring);
+                        if (itr == positions.end()) {
+                                descriptor_statistics.add(ring);
+                                block(index).add(ring);
+                        }
+                        if (writer != nullptr) {
+                                writer->write(ring);
+                        } else if (print_list) {
+                                print_ring(ring, output);
+                        }
+                }
+
+                if (itr != positions.end()) {
+                        size_t first = index / WATCH_BLOCK * WATCH_BLOCK;
+                        Descriptor_statistics &rebuilt = block(index);
+                        rebuilt = Descriptor_statistics(analyser.conformations(),
+                                                        index / WATCH_BLOCK);
+                        const auto &results = checkpoint_results.get_indexed_results();
+                        for (auto x = results.lower_bound(first);
+                             x != results.end() && x->first < first + WATCH_BLOCK; x++) {
+                                rebuilt.add(x->second);
+                        }
+                        statistics_stale = true;
+                }
+
+                /* results are passed on right away */
+                output_sink.flush();
+                diagnostics_sink.flush();
+                if (checkpoint_due()) {
+                        merge_blocks();
+                        write_checkpoint();
+                }
+        }
+
+        merge_blocks();
+        checkpoint_results.set_statistics(descriptor_statistics);
+        if (writer != nullptr) {
+                writer->finish();
+                delete(writer);
+        } else {
+                if (print_summary) {
+                        if (print_list) {
+                                output << '\n';
+                        }
+                        summary(checkpoint_results, output);
+                }
+                if (group_fields != 0) {
+                        if (print_list || print_summary) {
+                                output << '\n';
+                        }
+                        groups(checkpoint_results, output);
+                }
+                if (print_distributions || print_histograms) {
+                        if (print_list || print_summary || group_fields != 0) {
+                                output << '\n';
+                        }
+                        distributions(checkpoint_results, output);
+                }
+        }
+        if (!checkpoint_file.empty()) {
+                write_checkpoint();
+        }
+        if (!output_sink.flush()) {
+                diagnostics() << "Error while writing results!\n";
+                return false;
+        }
+
+        return !watcher.failed();
+}
+
+
+bool Application::write_results(const Partial_result &rings)
+{
+        if (write_partial) {
+                rings.write(output);
+        } else {
+                Result_writer *writer = Result_writer::create(output_format,
+                                                              output);
+                if (writer == nullptr) {
+                        results(rings, output);
+                } else {
+                        writer->begin();
+                        for (const auto &x : rings.get_results()) {
+                                writer->write(x);
+                        }
+                        writer->finish();
+                        delete(writer);
+                }
+        }
+
+        /* the only flush point of results */
+        if (!output_sink.flush()) {
+                diagnostics() << "Error while writing results!\n";
+                return false;
+        }
+
+        return true;
+}
+
+
+bool Application::diff_results()
+{
+        Result_diff diff;
+        if (!diff.compare(diff_files[0], diff_files[1],
+                          print_list ? &output : nullptr)) {
+                return false;
+        }
+        if (print_summary) {
+                if (print_list) {
+                        output << '\n';
+                }
+                diff.print_transitions(output);
+        }
+
+        if (!output_sink.flush()) {
+                diagnostics() << "Error while writing results!\n";
+                return false;
+        }
+        return true;
+}
+
+
+bool Application::write_profile()
+{
+        if (!Instrumentation::enabled()) {
+                return true;
+        }
+
+        if (print_profile) {
+                diagnostics() << '\n';
+                Instrumentation::report(diagnostics());
+        }
+
+        if (!profile_file.empty()) {
+                ofstream ofile(profile_file);
+                Instrumentation::report_json(ofile);
+                if (ofile.fail()) {
+                        diagnostics() << "Could not write file " << profile_file << "...\n";
+                        return false;
+                }
+        }
+
+        return true;
+}
+
+
+int Application::run()
+{
+        /* Parse command line arguments */
+        parse_options();
+
+        /* Open buffered outputs */
+        if (!open_outputs()) {
+                return EXIT_FAILURE;
+        }
+
+        /* Build index of ligands of the input files */
+        if (index_mode) {
+                bool success = build_index();
+                diagnostics_sink.flush();
+                return success ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+
+        /* Combine partial results of shards */
+        if (merge_mode) {
+                Partial_result merged;
+                bool success = merge_partials(merged);
+                diagnostics_sink.flush();
+                if (!success || !write_results(merged)) {
+                        return EXIT_FAILURE;
+                }
+                return EXIT_SUCCESS;
+        }
+
+        /* Compare results of two runs */
+        if (diff_mode) {
+                bool success = diff_results();
+                diagnostics_sink.flush();
+                return success ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+
+        /* Read list of atom names */
+        analyser.set_analysis_type(analysis_type);
+        analyser.set_header_filter(header_filter);
+        analyser.set_atom_selection(atom_selection);
+        analyser.set_confidence(confidence_trials, confidence_sigma);
+        analyser.set_engine(engine);
+        analyser.set_precision_check(precision_check);
+        {
+                STAGE_TIMER(STAGE_NAMES);
+                if (!analyser.read_atom_names(atom_names_list)) {
+                        return EXIT_FAILURE;
+                }
+        }
+
+        /* Write the compiled list of atom names */
+        if (compile_mode) {
+                bool success = analyser.compile_atom_names(output);
+                if (!success || !output_sink.flush()) {
+                        diagnostics() << "Error while writing compiled list of atom names!\n";
+                        return EXIT_FAILURE;
+                }
+                return EXIT_SUCCESS;
+        }
+
+        /* Serve analysis requests of clients */
+        if (!server_socket.empty()) {
+                Analysis_server server(analyser, jobs, max_request << 20,
+                                       client_timeout);
+                if (!server.listen(server_socket)) {
+                        return EXIT_FAILURE;
+                }
+                diagnostics() << "Listening on " << server_socket << '\n';
+                diagnostics_sink.flush();
+                if (!server.run()) {
+                        return EXIT_FAILURE;
+                }
+                diagnostics() << "Server stopped\n";
+                return EXIT_SUCCESS;
+        }
+
+        /* Distributions of descriptors of the rings analysed from now */
+        descriptor_statistics = Descriptor_statistics(analyser.conformations(),
+                                                      shard);
+
+        /* Continue interrupted run */
+        if (resume && !read_checkpoint()) {
+                return EXIT_FAILURE;
+        }
+
+        /* Analyse files as they appear until stopped by a signal */
+        if (!watch_directory.empty()) {
+                bool success = watch();
+                diagnostics_sink.flush();
+                if (!success || !write_profile()) {
+                        return EXIT_FAILURE;
+                }
+                return EXIT_SUCCESS;
+        }
+
+        /* Test print of read atom names */
+        /*for (const auto &x : atom_names) {
+                cout << "[" << x.first << "]" << endl;
+                for (const auto &y : x.second) {
+                        cout << "   ";
+                        for (const auto &z : y) {
+                                cout << "\"" << z << "\" ";
+                        }
+                        cout << endl;
+                }
+        }*/
+
+        if (!input_archive.empty()) {
+                /* Read molecules straight from the archive */
+                if (!process_archive()) {
+                        return EXIT_FAILURE;
+                }
+        } else {
+                /* Open list of molecules (or files of the ligand index) */
+                vector<string> files;
+                if (!(index_file.empty() ? read_input_list(files) :
+                                           read_index(files))) {
+                        return EXIT_FAILURE;
+                }
+
+                /* Read molecules from list of molecules and proccess them */ 
+                if (sample_width > 0) {
+                        process_sample(files);
+                } else {
+                        process_files(files);
+                }
+        }
+
+        /* Diagnostics of processing are flushed before the results */
+        diagnostics_sink.flush();
+
         /* Print results */
-        results(molecules);
+        {
+                STAGE_TIMER(STAGE_OUTPUT);
+                if (!write_results(collect_results())) {
+                        return EXIT_FAILURE;
+                }
+        }
+
+        /* finished run is not to be resumed */
+        if (!checkpoint_file.empty()) {
+                remove(checkpoint_file.c_str());
+        }
+
+        if (!write_profile()) {
+                return EXIT_FAILURE;
+        }
 
         return EXIT_SUCCESS; 
 }
@@ -2,10 +2,31 @@
 #define APPLICATION_H
 
 #include "molecule.h"
+#include "conf_analyser.h"
+#include "output_sink.h"
+#include "read_ahead.h"
+#include "partial_result.h"
+#include "ligand_index.h"
+#include "structure_header.h"
+#include "atom_selection.h"
+#include "frequency_estimate.h"
+#include <chrono>
+#include <functional>
 #include <vector>
 #include <map>
+#include <mutex>
+#include <ostream>
 #include <string>
 
+/* Format of the first line of checkpoint */
+#define CHECKPOINT_MAGIC "CONFCHECK1"
+/* Files analysed before the first check of --sample, the sample is
+   checked again whenever it has doubled (the same for any -j) */
+#define SAMPLE_FIRST_LOOK 16
+/* Files of --watch (by position) whose descriptor sketches are rebuilt
+   together when one of them is analysed again */
+#define WATCH_BLOCK 256
+
 class Application
 {
         public:
@@ -13,21 +34,142 @@ class Application
                 ~Application();
                 int run();
         private:
-                bool read_PDB(std::string &file_name,
-                              std::vector<Atom*> &molecule);
-                bool read_atom_names();
-                bool process_file(Molecule* mol, std::string file_name);
+                bool in_shard(size_t index) const;
+                void add_molecule(Molecule *mol, size_t index);
+                bool checkpoint_due() const;
+                void maybe_checkpoint();
+                bool write_checkpoint();
+                bool save_checkpoint(size_t done, const Partial_result &rings);
+                bool read_checkpoint();
+                Molecule *process_file(const std::string &file_name) const;
+                Molecule *process_entry(const Read_ahead_entry &entry) const;
+                bool read_input_list(std::vector<std::string> &files);
+                void process_files(const std::vector<std::string> &files);
+                Molecule *process_position(const std::vector<std::string> &files,
+                                           size_t position) const;
+                bool read_index(std::vector<std::string> &files);
+                bool build_index();
+                void process_files_parallel(
+                                const std::vector<std::string> &files,
+                                const std::function<bool(size_t)> &passed);
+                void process_sample(std::vector<std::string> &files);
+                bool process_archive();
                 void help() const;
                 void parse_options();
-                void results(std::vector<Molecule*> molecules);
+                void results(const Partial_result &rings, std::ostream &out);
+                void summary(const Partial_result &rings, std::ostream &out);
+                void groups(const Partial_result &rings, std::ostream &out);
+                void distributions(const Partial_result &rings,
+                                   std::ostream &out);
+                bool watch();
+                Partial_result initial_results() const;
+                Partial_result collect_results() const;
+                bool merge_partials(Partial_result &merged);
+                bool diff_results();
+                bool write_results(const Partial_result &rings);
+                bool open_outputs();
+                bool write_profile();
                 std::vector<Molecule*> molecules;
+                /* Positions of molecules and of read files in the input */
+                std::vector<size_t> molecule_indices;
+                std::vector<size_t> file_indices;
+                Conf_analyser analyser;
                 int argc;
                 char ** argv;
                 bool print_summary;
                 bool print_list;
+                /* Fields of grouped statistics (GROUP_*), 0 if not wanted */
+                int group_fields;
+                /* Quantiles and histograms of descriptors per conformation */
+                bool print_distributions;
+                bool print_histograms;
                 int analysis_type;
                 std::string input_file_list;
+                std::string input_archive;
                 std::string atom_names_list;
+                int output_format;
+                std::string output_file;
+                std::string diagnostics_file;
+                bool print_profile;
+                /* Pipelined reading of input files */
+                size_t read_ahead_depth;
+                size_t read_ahead_memory;
+                size_t io_threads;
+                /* Parallel analysis of input files */
+                size_t jobs;
+                bool print_workers;
+                /* Sharded runs, shard k of N (N = 0 without sharding) */
+                size_t shard;
+                size_t shards;
+                bool write_partial;
+                bool merge_mode;
+                bool diff_mode;
+                bool compile_mode;
+                bool index_mode;
+                /* Targeted runs by index of ligands, file_entries are the
+                   index entries of read files */
+                std::string index_file;
+                std::string index_ligands;
+                Ligand_index ligand_index;
+                std::vector<const Ligand_index_entry*> file_entries;
+                std::mutex index_mutex;
+                /* Prefiltering of structures by their headers */
+                Header_filter header_filter;
+                Atom_selection atom_selection;
+                /* Monte Carlo confidence, 0 trials if not wanted */
+                size_t confidence_trials;
+                double confidence_sigma;
+                /* Engine recognizing conformations (ENGINE_*) */
+                int engine;
+                bool precision_check;
+                /* Sampling of the input list in random order until all the
+                   intervals of frequencies are narrower than sample_width
+                   (0 without sampling) */
+                double sample_width;
+                size_t sample_seed;
+                size_t sampled;
+                Frequency_estimate sample_estimate;
+                /* Bootstrap intervals of the summary, 0 resamples if not
+                   wanted */
+                size_t bootstrap_resamples;
+                std::vector<std::string> partial_files;
+                /* Old and new result of the diff subcommand */
+                std::vector<std::string> diff_files;
+                /* Checkpoints of long runs, processed is the position in
+                   the input before which all files are done */
+                std::string checkpoint_file;
+                size_t checkpoint_interval;
+                bool resume;
+                bool resumed;
+                size_t resume_offset;
+                size_t processed;
+                std::chrono::steady_clock::time_point last_checkpoint;
+                Partial_result checkpoint_results;
+                /* Results written by checkpoints so far (the first
+                   checkpointed molecules), kept up to date by the thread
+                   writing the checkpoint outside of results_mutex */
+                Partial_result checkpoint_state;
+                size_t checkpointed;
+                bool checkpoint_started;
+                std::mutex checkpoint_mutex;
+                /* Guards results passed on by threads of -j */
+                std::mutex results_mutex;
+                /* Distributions of descriptors of all the analysed rings
+                   (with those of the checkpoint), fed in input order */
+                Descriptor_statistics descriptor_statistics;
+                /* Socket of the analysis server, limit of PDB data of
+                   a request (MB) and timeout of its clients (seconds) */
+                std::string server_socket;
+                size_t max_request;
+                size_t client_timeout;
+                /* Directory watched for new files */
+                std::string watch_directory;
+                std::string profile_file;
+                /* Buffered results and diagnostics, flushed explicitly */
+                Output_sink output_sink;
+                Output_sink diagnostics_sink;
+                std::ostream output;
+                std::ostream diagnostics_output;
 };
 
 #endif
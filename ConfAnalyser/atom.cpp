@@ -3,6 +3,7 @@
  */
 
 #include "atom.h"
+#include "output_sink.h"
 #include <fstream>
 #include <sstream>
 #include <iomanip>
@@ -37,7 +38,7 @@ void Atom::read_entry(const string &line)
         istringstream sstream;
         /* check minimal line size */
         if (line.length() < 53) {
-                cout<<"The line number " << line_number << " is too short!" << endl;
+                diagnostics() << "The line number " << line_number << " is too short!" << '\n';
                 return;
         }
 
@@ -58,8 +59,8 @@ void Atom::read_entry(const string &line)
         sstream >> atom_number;
 
         if (sstream.fail()) {
-                cout << "Line " << line_number
-                     << ": Error reading atom number!" << endl;
+                diagnostics() << "Line " << line_number
+                     << ": Error reading atom number!" << '\n';
                 return;
         }
 
@@ -90,8 +91,8 @@ void Atom::read_entry(const string &line)
         sstream.clear();
         sstream >> X;
         if (sstream.fail()) {
-                cout << "Line " << line_number
-                     << ": Error while reading coordinates!" << endl;
+                diagnostics() << "Line " << line_number
+                     << ": Error while reading coordinates!" << '\n';
                 return;
         }
 
@@ -101,8 +102,8 @@ void Atom::read_entry(const string &line)
         sstream.clear();
         sstream >> Y;
         if (sstream.fail()) {
-                cout << "Line " << line_number
-                     << ": Error while reading coordinates!" << endl;
+                diagnostics() << "Line " << line_number
+                     << ": Error while reading coordinates!" << '\n';
                 return;
         }
 
@@ -112,8 +113,8 @@ void Atom::read_entry(const string &line)
         sstream.clear();
         sstream >> Z;
         if (sstream.fail()) {
-                cout << "Line " << line_number
-                     << ": Error while reading coordinates!" << endl;
+                diagnostics() << "Line " << line_number
+                     << ": Error while reading coordinates!" << '\n';
                 return;
         }
 
@@ -253,6 +254,12 @@ string Atom::get_residue_name() const
 }
 
 
+char Atom::get_chain_id() const
+{
+	return chain_id;
+}
+
+
 int Atom::get_residue_number() const
 {
 	return residue_number;
@@ -262,3 +269,39 @@ string Atom::get_element_name() const
 {
         return element_name;
 }
+
+
+char Atom::get_alternate_location() const
+{
+        return alternate_location;
+}
+
+
+char Atom::get_insertion_code() const
+{
+        return i_code;
+}
+
+
+bool Atom::has_occupancy() const
+{
+        return is_occupancy;
+}
+
+
+double Atom::get_occupancy() const
+{
+        return occupancy;
+}
+
+
+bool Atom::has_temp_factor() const
+{
+        return is_temp_factor;
+}
+
+
+double Atom::get_temp_factor() const
+{
+        return temp_factor;
+}
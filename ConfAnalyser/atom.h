@@ -39,11 +39,24 @@ class Atom : public Point_3D
 		/* get residue name */
                 std::string get_residue_name() const;
 
+		/* get chain identifier */
+		char get_chain_id() const;
+
 		/* get residue number */
 		int get_residue_number() const;
 
 		/* get element name */
                 std::string get_element_name() const;
+
+                /* get alternate location indicator and insertion code */
+                char get_alternate_location() const;
+                char get_insertion_code() const;
+
+                /* get occupancy and temperature factor, check presence first */
+                bool has_occupancy() const;
+                double get_occupancy() const;
+                bool has_temp_factor() const;
+                double get_temp_factor() const;
         private:
                 /* atom attributes */
                 size_t line_number; /* keep line number in case of error */
@@ -0,0 +1,110 @@
+#include "atom_selection.h"
+#include <map>
+#include <utility>
+
+using namespace std;
+
+
+/* Residue of the atom, alternate locations are chosen per residue */
+static string residue_key(const Atom &atom)
+{
+        return atom.get_residue_name() + atom.get_chain_id() +
+               to_string(atom.get_residue_number()) + atom.get_insertion_code();
+}
+
+
+Atom_selection::Atom_selection()
+{
+        altloc = ALTLOC_BEST;
+        min_occupancy = -1;
+        max_temp_factor = -1;
+}
+
+
+bool Atom_selection::set_altloc(const string &name)
+{
+        if (name == "all") {
+                altloc = ALTLOC_ALL;
+        } else if (name == "best") {
+                altloc = ALTLOC_BEST;
+        } else if (name == "first") {
+                altloc = ALTLOC_FIRST;
+        } else {
+                return false;
+        }
+        return true;
+}
+
+
+void Atom_selection::set_min_occupancy(double _min_occupancy)
+{
+        min_occupancy = _min_occupancy;
+}
+
+
+void Atom_selection::set_max_temp_factor(double _max_temp_factor)
+{
+        max_temp_factor = _max_temp_factor;
+}
+
+
+bool Atom_selection::passes(const Atom &atom) const
+{
+        if (min_occupancy >= 0 && atom.has_occupancy() &&
+            atom.get_occupancy() < min_occupancy) {
+                return false;
+        }
+        if (max_temp_factor >= 0 && atom.has_temp_factor() &&
+            atom.get_temp_factor() > max_temp_factor) {
+                return false;
+        }
+        return true;
+}
+
+
+void Atom_selection::select(vector<Atom*> &atoms) const
+{
+        /* locations of residues in order of appearance, summed occupancy */
+        map<string, vector<pair<char, double>>> locations;
+        if (altloc != ALTLOC_ALL) {
+                for (auto x : atoms) {
+                        char location = x->get_alternate_location();
+                        if (location == ' ') {
+                                continue;
+                        }
+                        vector<pair<char, double>> &found = locations[residue_key(*x)];
+                        size_t i = 0;
+                        while (i < found.size() && found[i].first != location) {
+                                i++;
+                        }
+                        if (i == found.size()) {
+                                found.push_back(make_pair(location, 0.0));
+                        }
+                        found[i].second += x->has_occupancy() ? x->get_occupancy() : 0;
+                }
+        }
+
+        /* chosen location of each residue, ties go to the first one */
+        map<string, char> chosen;
+        for (const auto &x : locations) {
+                size_t best = 0;
+                for (size_t i = 1; altloc == ALTLOC_BEST && i < x.second.size(); i++) {
+                        if (x.second[i].second > x.second[best].second) {
+                                best = i;
+                        }
+                }
+                chosen[x.first] = x.second[best].first;
+        }
+
+        size_t kept = 0;
+        for (auto x : atoms) {
+                char location = x->get_alternate_location();
+                if ((location == ' ' || chosen.empty() ||
+                     chosen[residue_key(*x)] == location) && passes(*x)) {
+                        atoms[kept++] = x;
+                } else {
+                        delete(x);
+                }
+        }
+        atoms.resize(kept);
+}
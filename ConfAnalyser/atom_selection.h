@@ -0,0 +1,37 @@
+#ifndef ATOM_SELECTION_H
+#define ATOM_SELECTION_H
+
+#include "atom.h"
+#include <string>
+#include <vector>
+
+/* Choice among alternate locations of a residue */
+#define ALTLOC_ALL    0   /* keep all of them (duplicate ring atoms fail) */
+#define ALTLOC_BEST   1   /* location with the highest occupancy */
+#define ALTLOC_FIRST  2   /* location appearing first in the file */
+
+/*
+ * Selection of parsed atoms before they are matched to ring atoms. Atoms
+ * of one residue keep a single consistent alternate location, so that
+ * disordered residues are not discarded for duplicate atoms, and atoms
+ * failing the quality cutoffs are dropped. Atoms without occupancy or
+ * temperature factor given pass the respective cutoff.
+ */
+class Atom_selection
+{
+        public:
+                Atom_selection();
+                /* Mode by its name (all, best, first), false if not known */
+                bool set_altloc(const std::string &name);
+                void set_min_occupancy(double _min_occupancy);
+                void set_max_temp_factor(double _max_temp_factor);
+                /* Removes (and deletes) the atoms not selected */
+                void select(std::vector<Atom*> &atoms) const;
+        private:
+                bool passes(const Atom &atom) const;
+                int altloc;
+                double min_occupancy;
+                double max_temp_factor;
+};
+
+#endif
@@ -0,0 +1,473 @@
+/*
+ *	file: bench.cpp
+ *
+ *	Benchmark of ConfAnalyser stages on synthetic ring corpus with known
+ *	conformations. Rings are generated from Cremer-Pople puckering
+ *	coordinates (or out-of-plane patterns for conformations defined
+ *	that way by the analysers) and disturbed by gaussian noise.
+ */
+
+#define _USE_MATH_DEFINES
+
+#include "conf_analyser.h"
+#include "output_sink.h"
+#include "torsion_classifier.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <getopt.h>
+#include <unistd.h>
+
+using namespace std;
+
+/* Synthetic conformation and its expected label */
+struct Template
+{
+        const char *conformation;
+        int analysis_type;
+        const char *ligand;
+        /* Cremer-Pople parameters, ring radius in angstroms */
+        double amplitude;
+        double theta;
+        double phi;
+        double radius;
+        /* explicit out-of-plane displacements, used if amplitude is 0 */
+        double z[6];
+};
+
+static const Template templates[] = {
+        {"CHAIR",        CYCLOHEXANE,  "CHX", 0.90,  0, 0,  1.50, {0}},
+        {"BOAT",         CYCLOHEXANE,  "CHX", 0.90, 90, 0,  1.50, {0}},
+        {"TWISTED BOAT", CYCLOHEXANE,  "CHX", 0.86, 90, 30, 1.55, {0}},
+        {"HALF CHAIR",   CYCLOHEXANE,  "CHX", 0,     0, 0,  1.50,
+                                        {0, 0, 0, 0, 0, 0.8}},
+        {"ENVELOPE",     CYCLOPENTANE, "CYP", 0,     0, 0,  1.25,
+                                        {0, 0, 0, 0, 0.8, 0}}
+};
+
+/* Lowest accepted recognition rates (in %) of the templates (in their
+   order) for noise up to the given one, a few points under the rates
+   measured with several seeds; lower rate fails the benchmark */
+static const struct
+{
+        double noise;
+        double rates[sizeof(templates) / sizeof(templates[0])];
+} minimum_rates[] = {
+        {0,    {99.0, 99.0, 99.0, 99.0, 99.0}},
+        {0.01, {99.0, 99.0, 82.0, 99.0, 99.0}},
+        {0.02, {98.0, 96.0, 65.0, 95.0, 90.0}},
+        {0.05, {93.0, 62.0, 30.0, 48.0, 48.0}},
+        {0.1,  {72.0, 26.0, 12.0, 13.0, 21.0}}
+};
+
+static const char *atom_names[] = {"C1", "C2", "C3", "C4", "C5", "C6"};
+
+/* Parameters of the benchmark */
+struct Settings
+{
+        size_t files;           /* per conformation */
+        size_t rings;           /* per conformation, coordinates only */
+        size_t extra_atoms;     /* non-ring atoms in every file */
+        double noise;
+        unsigned seed;
+        string directory;
+        bool keep;
+        double min_throughput;  /* rings/s of batch classify, 0 if not checked */
+};
+
+
+static double seconds(chrono::steady_clock::time_point start)
+{
+        return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+
+static void ring_coordinates(const Template &t, mt19937 &rng, double noise,
+                             double *coordinates)
+{
+        normal_distribution<double> gauss(0, noise);
+        size_t count = (t.analysis_type == CYCLOPENTANE) ? 5 : 6;
+        double theta = t.theta * M_PI / 180;
+        double phi = t.phi * M_PI / 180;
+
+        for (size_t j = 0; j < count; j++) {
+                double z = t.z[j];
+                if (t.amplitude != 0) {
+                        /* six membered ring only */
+                        z = sqrt(1.0 / 3) * t.amplitude * sin(theta) *
+                                        cos(phi + 4 * M_PI * j / count) +
+                            sqrt(1.0 / 6) * t.amplitude * cos(theta) *
+                                        ((j % 2 == 0) ? 1 : -1);
+                }
+                coordinates[3*j] = t.radius * cos(2 * M_PI * j / count) + gauss(rng);
+                coordinates[3*j + 1] = t.radius * sin(2 * M_PI * j / count) + gauss(rng);
+                coordinates[3*j + 2] = z + gauss(rng);
+        }
+}
+
+
+static string pdb_line(const char *record, int number, const char *name,
+                       const char *residue, int residue_number,
+                       const double *xyz, const char *element)
+{
+        char line[96];
+        snprintf(line, sizeof(line),
+                 "%-6s%5d %-4s %3s A%4d    %8.3f%8.3f%8.3f%6.2f%6.2f          %2s  \n",
+                 record, number % 100000, name, residue, residue_number % 10000,
+                 xyz[0], xyz[1], xyz[2], 1.0, 20.0, element);
+        return line;
+}
+
+
+static string synthetic_PDB(const Template &t, mt19937 &rng,
+                            const Settings &settings)
+{
+        static const char *protein_names[] = {"N", "CA", "C", "O", "CB"};
+        uniform_real_distribution<double> position(-30, 30);
+        double coordinates[18];
+        size_t count = (t.analysis_type == CYCLOPENTANE) ? 5 : 6;
+        string content;
+
+        /* ligand goes first, analysers take the ligand from the first atom */
+        ring_coordinates(t, rng, settings.noise, coordinates);
+        for (size_t j = 0; j < count; j++) {
+                content += pdb_line("HETATM", j + 1, atom_names[j], t.ligand,
+                                    1, coordinates + 3*j, "C");
+        }
+        for (size_t j = 0; j < settings.extra_atoms; j++) {
+                double xyz[3] = {position(rng), position(rng), position(rng)};
+                content += pdb_line("ATOM", count + j + 1, protein_names[j % 5],
+                                    "ALA", j / 5 + 1, xyz, "C");
+        }
+        content += "END\n";
+
+        return content;
+}
+
+
+static bool parse_settings(int argc, char **argv, Settings &settings)
+{
+        static struct option long_opt[] =
+        {
+                {"files",       required_argument, nullptr, 'f'},
+                {"rings",       required_argument, nullptr, 'r'},
+                {"extra_atoms", required_argument, nullptr, 'a'},
+                {"noise",       required_argument, nullptr, 'e'},
+                {"seed",        required_argument, nullptr, 's'},
+                {"directory",   required_argument, nullptr, 'd'},
+                {"keep",        no_argument,       nullptr, 'k'},
+                {"min_throughput", required_argument, nullptr, 't'},
+                {0, 0, 0, 0}
+        };
+
+        int opt;
+        while ((opt = getopt_long(argc, argv, "f:r:a:e:s:d:kt:", long_opt,
+                                  nullptr)) != -1) {
+                switch (opt) {
+                        case 'f':
+                                settings.files = strtoul(optarg, nullptr, 10);
+                                break;
+                        case 'r':
+                                settings.rings = strtoul(optarg, nullptr, 10);
+                                break;
+                        case 'a':
+                                settings.extra_atoms = strtoul(optarg, nullptr, 10);
+                                break;
+                        case 'e':
+                                settings.noise = strtod(optarg, nullptr);
+                                break;
+                        case 's':
+                                settings.seed = strtoul(optarg, nullptr, 10);
+                                break;
+                        case 'd':
+                                settings.directory = optarg;
+                                break;
+                        case 'k':
+                                settings.keep = true;
+                                break;
+                        case 't':
+                                settings.min_throughput = strtod(optarg, nullptr);
+                                break;
+                        default:
+                                cout << "Usage: " << argv[0]
+                                     << " [-f FILES] [-r RINGS] [-a EXTRA_ATOMS]"
+                                        " [-e NOISE] [-s SEED] [-d DIR] [-k] [-t RINGS]\n"
+                                        "   -f  synthetic PDB files per conformation (default 100)\n"
+                                        "   -r  coordinate-only rings per conformation (default 20000)\n"
+                                        "   -a  non-ring atoms in every file (default 300)\n"
+                                        "   -e  gaussian noise of coordinates in angstroms (default 0.01)\n"
+                                        "   -s  seed of the generator (default 1)\n"
+                                        "   -d  directory for the files (default new one in /tmp)\n"
+                                        "   -k  keep the generated files\n"
+                                        "   -t  fail if batch classify is slower than RINGS rings/s\n"
+                                        "Fails (exit status 1) if recognition rate of some conformation is\n"
+                                        "under its minimum for the noise or throughput under -t.\n";
+                                return false;
+                }
+        }
+
+        return true;
+}
+
+
+static void report(const char *stage, double time, size_t count,
+                   const char *unit)
+{
+        cout << "  " << setw(16) << left << stage
+             << setw(12) << right << fixed << setprecision(4) << time
+             << setw(14) << right << setprecision(0)
+             << (time > 0 ? count / time : 0) << " " << unit << "\n";
+}
+
+
+int main(int argc, char **argv)
+{
+        Settings settings = {100, 20000, 300, 0.01, 1, "", false, 0};
+        if (!parse_settings(argc, argv, settings)) {
+                return EXIT_FAILURE;
+        }
+
+        /* warnings of the analysis are not part of the measurement */
+        ostringstream silenced;
+        set_diagnostics(&silenced);
+
+        /* one analyser per ring type, sharing the atom names list */
+        map<int, Conf_analyser> analysers;
+        for (const auto &t : templates) {
+                if (analysers.count(t.analysis_type) == 0) {
+                        analysers[t.analysis_type] = Conf_analyser(t.analysis_type);
+                        size_t count = analysers[t.analysis_type].ring_size();
+                        stringstream names;
+                        names << t.ligand;
+                        for (size_t j = 0; j < count; j++) {
+                                names << " " << atom_names[j];
+                        }
+                        analysers[t.analysis_type].read_atom_names(names, "bench");
+                }
+        }
+
+        if (settings.directory.empty()) {
+                char tmp[] = "/tmp/confbench.XXXXXX";
+                if (mkdtemp(tmp) == nullptr) {
+                        cerr << "Could not create temporary directory...\n";
+                        return EXIT_FAILURE;
+                }
+                settings.directory = tmp;
+        }
+
+        mt19937 rng(settings.seed);
+        size_t templates_count = sizeof(templates) / sizeof(templates[0]);
+
+        /* Generate synthetic corpus */
+        auto start = chrono::steady_clock::now();
+        vector<string> files;
+        vector<const Template*> expected;
+        for (size_t i = 0; i < settings.files; i++) {
+                for (const auto &t : templates) {
+                        string name = settings.directory + "/synthetic_" +
+                                      to_string(files.size()) + ".pdb";
+                        ofstream ofile(name, ios::binary);
+                        ofile << synthetic_PDB(t, rng, settings);
+                        if (ofile.fail()) {
+                                cerr << "Could not write file " << name << "...\n";
+                                return EXIT_FAILURE;
+                        }
+                        files.push_back(name);
+                        expected.push_back(&t);
+                }
+        }
+        double generate_time = seconds(start);
+
+        /* Read files to memory */
+        start = chrono::steady_clock::now();
+        vector<string> contents(files.size());
+        size_t bytes = 0;
+        for (size_t i = 0; i < files.size(); i++) {
+                ifstream ifile(files[i], ios::binary);
+                stringstream ss;
+                ss << ifile.rdbuf();
+                contents[i] = ss.str();
+                bytes += contents[i].size();
+        }
+        double read_time = seconds(start);
+
+        /* Parse PDB records */
+        start = chrono::steady_clock::now();
+        vector<vector<Atom*>> atoms(files.size());
+        for (size_t i = 0; i < files.size(); i++) {
+                Conf_analyser::parse_PDB(contents[i].data(), contents[i].size(),
+                                         atoms[i]);
+        }
+        double parse_time = seconds(start);
+
+        /* Match ring atoms by names */
+        start = chrono::steady_clock::now();
+        vector<Ring*> molecules(files.size());
+        for (size_t i = 0; i < files.size(); i++) {
+                const Conf_analyser &analyser =
+                                analysers.at(expected[i]->analysis_type);
+                molecules[i] = analyser.create_molecule(files[i]);
+                if (!molecules[i]->initialize(atoms[i])) {
+                        delete(molecules[i]);
+                        molecules[i] = nullptr;
+                }
+        }
+        double match_time = seconds(start);
+
+        /* Classify matched rings */
+        start = chrono::steady_clock::now();
+        size_t classified = 0;
+        for (auto x : molecules) {
+                if (x != nullptr && x->analyse()) {
+                        classified++;
+                }
+        }
+        double classify_time = seconds(start);
+
+        /* Classify coordinate-only rings through the batch interface */
+        map<string, pair<size_t, size_t>> agreement;
+        for (size_t i = 0; i < files.size(); i++) {
+                auto &x = agreement[expected[i]->conformation];
+                x.first++;
+                if (molecules[i] != nullptr &&
+                    molecules[i]->translate_conformation() ==
+                                        expected[i]->conformation) {
+                        x.second++;
+                }
+        }
+
+        double batch_time = 0;
+        size_t batch_rings = 0;
+        double torsion_time = 0;
+        double single_time = 0;
+        size_t precision_differs = 0;
+        for (const auto &t : templates) {
+                const Conf_analyser &analyser = analysers.at(t.analysis_type);
+                size_t stride = 3 * analyser.ring_size();
+                vector<double> coordinates(settings.rings * stride);
+                for (size_t i = 0; i < settings.rings; i++) {
+                        ring_coordinates(t, rng, settings.noise,
+                                         coordinates.data() + i * stride);
+                }
+
+                start = chrono::steady_clock::now();
+                vector<Ring_result> results =
+                        analyser.analyse_coordinates(coordinates.data(),
+                                                     settings.rings);
+                batch_time += seconds(start);
+                batch_rings += results.size();
+
+                auto &x = agreement[t.conformation];
+                for (const auto &r : results) {
+                        x.first++;
+                        x.second += (r.conformation_name == t.conformation);
+                }
+
+                /* torsion engine in double and single precision */
+                Conf_analyser torsion(t.analysis_type);
+                torsion.set_engine(ENGINE_TORSION);
+                vector<float> single(coordinates.begin(), coordinates.end());
+                start = chrono::steady_clock::now();
+                vector<short> codes = torsion.classify_coordinates(
+                                coordinates.data(), settings.rings);
+                torsion_time += seconds(start);
+                start = chrono::steady_clock::now();
+                vector<short> single_codes = torsion.classify_coordinates(
+                                single.data(), settings.rings);
+                single_time += seconds(start);
+                for (size_t i = 0; i < codes.size(); i++) {
+                        precision_differs += (codes[i] != single_codes[i]);
+                }
+        }
+
+        /* Report */
+        cout << "ConfBench: " << files.size() << " files ("
+             << bytes / files.size() << " B each), "
+             << batch_rings << " coordinate-only rings, noise "
+             << settings.noise << " A, seed " << settings.seed << "\n\n";
+        cout << "  " << setw(16) << left << "STAGE"
+             << setw(12) << right << "TIME [s]"
+             << setw(14) << right << "THROUGHPUT" << "\n";
+        report("generate", generate_time, files.size(), "files/s");
+        report("read", read_time, files.size(), "files/s");
+        report("parse", parse_time, files.size(), "files/s");
+        report("match", match_time, files.size(), "files/s");
+        report("classify", classify_time, classified, "rings/s");
+        report("batch classify", batch_time, batch_rings, "rings/s");
+        report("torsion double", torsion_time, batch_rings, "rings/s");
+        report("torsion float32", single_time, batch_rings, "rings/s");
+        report("total (files)", read_time + parse_time + match_time +
+                                classify_time, files.size(), "files/s");
+
+        cout << "\n  torsion engine differs between precisions in "
+             << precision_differs << " of " << batch_rings << " rings\n";
+
+        /* rates are checked against the first row of the noise or higher */
+        const double *minimum = nullptr;
+        for (const auto &x : minimum_rates) {
+                if (settings.noise <= x.noise) {
+                        minimum = x.rates;
+                        break;
+                }
+        }
+
+        bool failed = false;
+        cout << "\n  " << setw(16) << left << "CONFORMATION"
+             << setw(12) << right << "RINGS"
+             << setw(14) << right << "RECOGNIZED"
+             << setw(12) << right << "MINIMUM" << "\n";
+        for (size_t i = 0; i < templates_count; i++) {
+                const auto &x = agreement[templates[i].conformation];
+                double rate = 100.0 * x.second / x.first;
+                cout << "  " << setw(16) << left << templates[i].conformation
+                     << setw(12) << right << x.first
+                     << setw(13) << right << setprecision(1) << rate << "%";
+                if (minimum != nullptr) {
+                        cout << setw(11) << right << minimum[i] << "%";
+                        if (rate < minimum[i]) {
+                                cout << "  FAILED";
+                                failed = true;
+                        }
+                }
+                cout << "\n";
+        }
+        if (minimum == nullptr) {
+                cout << "\n  no minimum rates for noise " << settings.noise
+                     << " A, rates are not checked\n";
+        }
+
+        double throughput = batch_time > 0 ? batch_rings / batch_time : 0;
+        if (settings.min_throughput > 0 &&
+            throughput < settings.min_throughput) {
+                cout << "\n  FAILED: batch classify " << setprecision(0)
+                     << throughput << " rings/s, expected at least "
+                     << settings.min_throughput << " rings/s\n";
+                failed = true;
+        }
+
+        /* Cleanup */
+        for (size_t i = 0; i < files.size(); i++) {
+                for (auto x : atoms[i]) {
+                        delete(x);
+                }
+                delete(molecules[i]);
+                if (!settings.keep) {
+                        unlink(files[i].c_str());
+                }
+        }
+        if (!settings.keep) {
+                rmdir(settings.directory.c_str());
+        }
+        set_diagnostics(nullptr);
+
+        return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
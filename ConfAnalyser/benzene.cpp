@@ -3,6 +3,8 @@
 #include "plane_3D.h"
 #include "angle.h"
 #include "helper_functions.h"
+#include "output_sink.h"
+#include "instrumentation.h"
 
 #define ATOM_C1 0
 #define ATOM_C2 1
@@ -11,10 +13,21 @@
 #define ATOM_C5 4
 #define ATOM_C6 5
 
+#define UNDEFINIED      1
+#define FLAT            2
+
 using namespace std;
 
 
-Benzene::Benzene(string _structure) : Six_atom_ring(_structure) {}
+map<string, short> Benzene::conformation_table = {
+        {"UNANALYSED", 0},
+        {"UNDEFINIED", UNDEFINIED},
+        {"FLAT", FLAT}
+};
+
+
+Benzene::Benzene(string _structure)
+        : Six_atom_ring(_structure, conformation_table) {}
 
 
 Benzene::~Benzene()
@@ -30,7 +43,8 @@ Benzene::~Benzene()
 static bool filler(Atom *x, bool &found, Atom *&C)
 {
         if (found) {
-                cerr << strip(x->get_atom_name()) << " atom found twice!\n";
+                COUNT(COUNTER_DUPLICATE_ATOMS, 1);
+                diagnostics() << strip(x->get_atom_name()) << " atom found twice!\n";
                 return false;
         }
 
@@ -48,8 +62,11 @@ bool Benzene::initialize(const vector<Atom*> &atoms)
 	for (auto x : atoms) {
 	        if (ligand.empty()) {
                         ligand = x->get_residue_name();
+                        chain_id = x->get_chain_id();
+                        residue_number = x->get_residue_number();
                         if (atom_names.find(ligand) == atom_names.end()) {
-                                cerr << "Ligand not recognized!" << endl;
+                                COUNT(COUNTER_UNKNOWN_LIGAND, 1);
+                                diagnostics() << "Ligand not recognized!" << '\n';
                                 return false;
                         }
                 }
@@ -84,48 +101,87 @@ bool Benzene::initialize(const vector<Atom*> &atoms)
         filled = found[0] && found[1] && found[2] && found[3]
                                                 && found[4] && found[5];
         if (!filled) {
-             cerr << "Not all atoms were found!" << endl;   
+             COUNT(COUNTER_MISSING_ATOMS, 1);
+             diagnostics() << "Not all atoms were found!" << '\n';   
         }
 
         return filled;
 }
 
 
-bool Benzene::is_flat() const
+template<typename T>
+bool Benzene::is_flat(const Point_3D_t<T> *P, int begin, bool has_plane)
 {
         /* flat conforamtion has all atoms in one plane */
         if (!has_plane) {
                 return false;
         }
 
-        Plane_3D left_plane(*(C[begin]), *(C[(begin+1)%6]), *(C[(begin+4)%6]));
-        Plane_3D right_plane(*(C[begin]), *(C[(begin+1)%6]), *(C[(begin+3)%6]));
-        return left_plane.is_on_plane(*(C[(begin+2)%6]), tolerance_flat_in) &&
-               left_plane.is_on_plane(*(C[(begin+5)%6]), tolerance_flat_in) &&
-               right_plane.is_on_plane(*(C[(begin+2)%6]), tolerance_flat_in) &&
-               right_plane.is_on_plane(*(C[(begin+5)%6]), tolerance_flat_in);
+        Plane_3D_t<T> left_plane(P[begin], P[(begin+1)%6], P[(begin+4)%6]);
+        Plane_3D_t<T> right_plane(P[begin], P[(begin+1)%6], P[(begin+3)%6]);
+        return left_plane.is_on_plane(P[(begin+2)%6], tolerance_flat_in) &&
+               left_plane.is_on_plane(P[(begin+5)%6], tolerance_flat_in) &&
+               right_plane.is_on_plane(P[(begin+2)%6], tolerance_flat_in) &&
+               right_plane.is_on_plane(P[(begin+5)%6], tolerance_flat_in);
+}
+
+
+template<typename T>
+void Benzene::classify_rings(const T *coordinates, size_t ring_count,
+                             short *classes)
+{
+        for (size_t i = 0; i < ring_count; i++) {
+                Point_3D_t<T> P[6];
+                ring_points(coordinates + 18 * i, P);
+
+                /* finding the most accurate plane of 4 atoms within the ring */
+                int begin;
+                bool has_plane = find_plane(P, static_cast<T>(tolerance_flat_in),
+                                            begin);
+                if (is_flat(P, begin, has_plane)) {
+                        classes[i] = FLAT;
+                } else {
+                        classes[i] = UNDEFINIED;
+                }
+        }
+}
+
+
+void Benzene::classify_geometric(const double *coordinates,
+                                 size_t ring_count, short *classes) const
+{
+        classify_rings(coordinates, ring_count, classes);
+}
+
+
+void Benzene::classify_geometric(const float *coordinates,
+                                 size_t ring_count, short *classes) const
+{
+        classify_rings(coordinates, ring_count, classes);
+}
+
+
+void Benzene::classify()
+{
+        double coordinates[18];
+        get_coordinates(coordinates);
+        classify_geometric(coordinates, 1, &conformation);
 }
 
 
 bool Benzene::analyse()
 {
         if (!filled) {
-                cerr << "Molecule has to be filled before analysis!" << endl;
+                diagnostics() << "Molecule has to be filled before analysis!" << '\n';
                 return false;
         }
         if (analysed) {
-                cerr << "Attempt to analyze the same molecule twice!" << endl;
+                diagnostics() << "Attempt to analyze the same molecule twice!" << '\n';
                 return false;
         }
 
-        /* finding the most accurate plane of 4 atoms within the ring */
-        has_plane = find_plane(tolerance_flat_in);
-        if (is_flat()) {
-                conformation = conformations["FLAT"];
-        } else {
-		conformation = conformations["UNDEFINIED"];
-        }
-                
+        recognize();
+        describe();
         analysed = true;
         return true;
 }
@@ -134,8 +190,12 @@ bool Benzene::analyse()
 bool Benzene::is_valid_atom_name(const int atom_number,
                                         const std::string &name) const
 {
-        return (ligand.empty()) ? false :
-                                any_of(atom_names[ligand][atom_number].begin(),
-                                atom_names[ligand][atom_number].end(),
-                                [&name](string &tmp){return tmp == name;});
+        auto itr = atom_names.find(ligand);
+        if (ligand.empty() || itr == atom_names.end() ||
+            static_cast<size_t>(atom_number) >= itr->second.size()) {
+                return false;
+        }
+        const vector<string> &names = itr->second[atom_number];
+        return any_of(names.begin(), names.end(),
+                      [&name](const string &tmp){return tmp == name;});
 }
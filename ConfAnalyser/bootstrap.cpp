@@ -0,0 +1,296 @@
+#define _USE_MATH_DEFINES
+
+#include "bootstrap.h"
+#include "frequency_estimate.h"
+#include "helper_functions.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include <thread>
+
+using namespace std;
+
+/* Positions of the generator reserved for one resample */
+#define RESAMPLE_STREAM (static_cast<uint64_t>(1) << 24)
+/* Rings are resampled one by one if there are at most this many per drawn
+   conformation, drawing single ring is much cheaper than a binomial draw */
+#define DIRECT_PER_CONFORMATION 32
+/* Binomial draws with lower mean are done by inversion */
+#define INVERSION_MEAN 10
+
+
+/* Uniform value in (0, 1) of the given position of the stream */
+static inline double uniform(uint64_t &position)
+{
+        return ((random_value(position++) >> 11) + 0.5) / 9007199254740992.0;
+}
+
+
+/* log(k!) - log of its Stirling approximation */
+static double stirling_tail(double k)
+{
+        return lgamma(k + 1) - (k + 0.5) * log(k + 1) + (k + 1) -
+               0.5 * log(2 * M_PI);
+}
+
+
+/* Binomial draw - inversion for low means, otherwise transformed rejection
+   with squeeze (Hormann W.: The generation of binomial random variates,
+   J. Stat. Comput. Simul. 1993, 46, 101-110) */
+static size_t binomial(size_t n, double p, uint64_t &position)
+{
+        if (n == 0 || p <= 0) {
+                return 0;
+        }
+        if (p >= 1) {
+                return n;
+        }
+        if (p > 0.5) {
+                return n - binomial(n, 1 - p, position);
+        }
+
+        double q = 1 - p;
+        if (n * p < INVERSION_MEAN) {
+                /* P(x) = P(x - 1) * ((n + 1) / x - 1) * p / q */
+                double s = p / q, a = (n + 1) * s;
+                double probability = pow(q, static_cast<double>(n));
+                double u = uniform(position);
+                size_t x = 0;
+                while (u > probability && x < n) {
+                        u -= probability;
+                        x++;
+                        probability *= a / x - s;
+                }
+                return x;
+        }
+
+        double npq = n * p * q, spq = sqrt(npq);
+        double b = 1.15 + 2.53 * spq, a = -0.0873 + 0.0248 * b + 0.01 * p;
+        double c = n * p + 0.5, alpha = (2.83 + 5.1 / b) * spq;
+        double vr = 0.92 - 4.2 / b, urvr = 0.86 * vr;
+        double m = floor((n + 1) * p), r = p / q, nr = (n + 1) * r;
+        while (true) {
+                double v = uniform(position), u;
+                if (v <= urvr) {
+                        u = v / vr - 0.43;
+                        return static_cast<size_t>(
+                                floor((2 * a / (0.5 - fabs(u)) + b) * u + c));
+                }
+                if (v >= vr) {
+                        u = uniform(position) - 0.5;
+                } else {
+                        u = v / vr - 0.93;
+                        u = ((u > 0) ? 0.5 : -0.5) - u;
+                        v = uniform(position) * vr;
+                }
+
+                double us = 0.5 - fabs(u);
+                double k = floor((2 * a / us + b) * u + c);
+                if (k < 0 || k > n) {
+                        continue;
+                }
+                v = v * alpha / (a / (us * us) + b);
+                double km = fabs(k - m);
+                if (km <= 15) {
+                        /* ratio of probabilities of k and m step by step */
+                        double f = 1;
+                        for (double i = m + 1; i <= k; i++) {
+                                f *= nr / i - r;
+                        }
+                        for (double i = k + 1; i <= m; i++) {
+                                v *= nr / i - r;
+                        }
+                        if (v <= f) {
+                                return static_cast<size_t>(k);
+                        }
+                        continue;
+                }
+
+                /* squeeze, then the exact test by Stirling approximation */
+                v = log(v);
+                double rho = (km / npq) * (((km / 3 + 0.625) * km + 1.0 / 6) /
+                                           npq + 0.5);
+                double t = -km * km / (2 * npq);
+                if (v < t - rho) {
+                        return static_cast<size_t>(k);
+                }
+                if (v > t + rho) {
+                        continue;
+                }
+                double nm = n - m + 1, nk = n - k + 1;
+                double h = (m + 0.5) * log((m + 1) / (r * nm)) +
+                           stirling_tail(m) + stirling_tail(n - m);
+                if (v <= h + (n + 1) * log(nm / nk) +
+                         (k + 0.5) * log(nk * r / (k + 1)) -
+                         stirling_tail(k) - stirling_tail(n - k)) {
+                        return static_cast<size_t>(k);
+                }
+        }
+}
+
+
+/* Conformations of the rings if there are few enough of them to be
+   resampled one by one, empty otherwise */
+static vector<unsigned short> direct_rings(const vector<size_t> &observed,
+                                           size_t total)
+{
+        vector<unsigned short> rings;
+        size_t drawn = count_if(observed.begin(), observed.end(),
+                                [](size_t x){return x > 0;});
+        if (total <= drawn * DIRECT_PER_CONFORMATION) {
+                for (size_t k = 0; k < observed.size(); k++) {
+                        rings.insert(rings.end(), observed[k], k);
+                }
+        }
+        return rings;
+}
+
+
+/* Frequencies of resamples first to last - 1 of one vector of counts,
+   conformation k of resample r is kept at k * resamples + r of samples;
+   resample r draws from position stream + r * RESAMPLE_STREAM */
+static void resample_counts(const vector<size_t> &observed, size_t n,
+                            const vector<unsigned short> &rings,
+                            uint64_t stream, size_t resamples, size_t first,
+                            size_t last, vector<float> &samples)
+{
+        vector<size_t> resampled(observed.size());
+        for (size_t r = first; r < last; r++) {
+                uint64_t position = stream + r * RESAMPLE_STREAM;
+                fill(resampled.begin(), resampled.end(), 0);
+                if (!rings.empty()) {
+                        for (size_t i = 0; i < n; i++) {
+                                uint64_t x = random_value(position++) >> 32;
+                                resampled[rings[(x * n) >> 32]]++;
+                        }
+                } else {
+                        /* counts of conformations one by one, each from
+                           the rings left */
+                        size_t left = n, left_observed = n;
+                        for (size_t k = 0; k < observed.size(); k++) {
+                                if (left > 0 && observed[k] > 0) {
+                                        resampled[k] = binomial(left,
+                                                static_cast<double>(observed[k]) /
+                                                left_observed, position);
+                                }
+                                left -= resampled[k];
+                                left_observed -= observed[k];
+                        }
+                }
+                for (size_t k = 0; k < observed.size(); k++) {
+                        samples[k * resamples + r] = (n == 0) ? 0 :
+                                static_cast<float>(resampled[k]) / n;
+                }
+        }
+}
+
+
+/* Percentiles of the resampled frequencies of every conformation */
+static void percentiles(vector<float> &samples, size_t resamples,
+                        vector<double> &low, vector<double> &high)
+{
+        double alpha = (1 - FREQUENCY_LEVEL) / 2;
+        size_t lower = static_cast<size_t>(alpha * (resamples - 1));
+        size_t upper = resamples - 1 - lower;
+        for (size_t k = 0; k < low.size(); k++) {
+                auto begin = samples.begin() + k * resamples;
+                auto end = begin + resamples;
+                nth_element(begin, begin + lower, end);
+                low[k] = *(begin + lower);
+                nth_element(begin + lower, begin + upper, end);
+                high[k] = *(begin + upper);
+        }
+}
+
+
+Bootstrap::Bootstrap(size_t _resamples, size_t _threads, uint64_t _seed)
+{
+        resamples = _resamples;
+        threads = max(_threads, static_cast<size_t>(1));
+        seed = _seed;
+}
+
+
+size_t Bootstrap::get_resamples() const
+{
+        return resamples;
+}
+
+
+void Bootstrap::intervals(const vector<vector<size_t>> &counts,
+                          vector<vector<double>> &low,
+                          vector<vector<double>> &high) const
+{
+        low.assign(counts.size(), vector<double>());
+        high.assign(counts.size(), vector<double>());
+        for (size_t v = 0; v < counts.size(); v++) {
+                low[v].assign(counts[v].size(), 0);
+                high[v].assign(counts[v].size(), 0);
+        }
+        if (resamples == 0) {
+                return;
+        }
+
+        /* resamples of one vector of counts are kept only until its
+           percentiles are found, so the memory does not grow with the
+           number of groups; stream of every resample depends only on the
+           vector and the resample, not on the threads */
+        auto total = [&](size_t v) {
+                size_t n = 0;
+                for (auto x : counts[v]) {
+                        n += x;
+                }
+                return n;
+        };
+        auto group = [&](size_t v, size_t first, size_t last,
+                         const vector<unsigned short> &rings,
+                         vector<float> &samples) {
+                resample_counts(counts[v], total(v), rings,
+                                seed + v * resamples * RESAMPLE_STREAM,
+                                resamples, first, last, samples);
+        };
+
+        /* many vectors (groups) are split among the threads whole, each
+           thread with its own buffer */
+        if (counts.size() >= threads) {
+                atomic<size_t> next(0);
+                auto work = [&]() {
+                        vector<float> samples;
+                        for (size_t v; (v = next++) < counts.size(); ) {
+                                samples.resize(counts[v].size() * resamples);
+                                group(v, 0, resamples,
+                                      direct_rings(counts[v], total(v)), samples);
+                                percentiles(samples, resamples, low[v], high[v]);
+                        }
+                };
+                vector<thread> workers;
+                for (size_t i = 1; i < threads; i++) {
+                        workers.emplace_back(work);
+                }
+                work();
+                for (auto &x : workers) {
+                        x.join();
+                }
+                return;
+        }
+
+        /* otherwise resamples of every vector are split among them */
+        vector<float> samples;
+        size_t batch = (resamples + threads - 1) / threads;
+        for (size_t v = 0; v < counts.size(); v++) {
+                samples.resize(counts[v].size() * resamples);
+                vector<unsigned short> rings = direct_rings(counts[v], total(v));
+                vector<thread> workers;
+                for (size_t i = 0; i + 1 < threads && (i + 1) * batch < resamples; i++) {
+                        workers.emplace_back(group, v, (i + 1) * batch,
+                                             min(resamples, (i + 2) * batch),
+                                             cref(rings), ref(samples));
+                }
+                group(v, 0, min(resamples, batch), rings, samples);
+                for (auto &x : workers) {
+                        x.join();
+                }
+                percentiles(samples, resamples, low[v], high[v]);
+        }
+}
@@ -0,0 +1,36 @@
+#ifndef BOOTSTRAP_H
+#define BOOTSTRAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+ * Percentile bootstrap intervals of frequencies of conformations (at
+ * FREQUENCY_LEVEL). Resampling N rings with replacement gives multinomial
+ * counts of the conformations, so every resample draws the counts at once
+ * by conditional binomial draws instead of picking the rings one by one -
+ * the cost does not depend on the number of rings. Resamples are split
+ * among threads, each of them draws from its own position of the counter
+ * based generator, so the intervals do not depend on the threads.
+ * Resampled frequencies are kept for one vector of counts per thread at
+ * a time, so the memory does not grow with the number of groups.
+ */
+class Bootstrap
+{
+        public:
+                Bootstrap(size_t _resamples, size_t _threads = 1,
+                          uint64_t _seed = 0);
+                /* Intervals of frequencies for every vector of counts
+                   (indexed by codes of conformations), e.g. of groups */
+                void intervals(const std::vector<std::vector<size_t>> &counts,
+                               std::vector<std::vector<double>> &low,
+                               std::vector<std::vector<double>> &high) const;
+                size_t get_resamples() const;
+        private:
+                size_t resamples;
+                size_t threads;
+                uint64_t seed;
+};
+
+#endif
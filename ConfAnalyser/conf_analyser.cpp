@@ -0,0 +1,468 @@
+#include "conf_analyser.h"
+#include "cyclohexane.h"
+#include "cyclopentane.h"
+#include "benzene.h"
+#include "oxane.h"
+#include "output_sink.h"
+#include "instrumentation.h"
+#include "torsion_classifier.h"
+#include "name_table.h"
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+
+
+Conf_analyser::Conf_analyser(int _analysis_type)
+{
+        analysis_type = _analysis_type;
+        confidence_trials = 0;
+        confidence_sigma = -1;
+        engine = ENGINE_GEOMETRIC;
+        precision_check = false;
+}
+
+
+void Conf_analyser::set_precision_check(bool _precision_check)
+{
+        precision_check = _precision_check;
+}
+
+
+void Conf_analyser::set_engine(int _engine)
+{
+        engine = _engine;
+}
+
+
+void Conf_analyser::set_header_filter(const Header_filter &filter)
+{
+        header_filter = filter;
+}
+
+
+void Conf_analyser::set_atom_selection(const Atom_selection &selection)
+{
+        atom_selection = selection;
+}
+
+
+void Conf_analyser::set_confidence(size_t _confidence_trials,
+                                   double _confidence_sigma)
+{
+        confidence_trials = _confidence_trials;
+        confidence_sigma = _confidence_sigma;
+}
+
+
+void Conf_analyser::set_analysis_type(int _analysis_type)
+{
+        analysis_type = _analysis_type;
+}
+
+
+int Conf_analyser::get_analysis_type() const
+{
+        return analysis_type;
+}
+
+
+size_t Conf_analyser::ring_size() const
+{
+        switch (analysis_type) {
+                case CYCLOPENTANE:
+                        return 5;
+                case CYCLOHEXANE:
+                        return 6;
+                case BENZENE:
+                        return 6;
+                case OXANE:
+                        return 6;
+                default:
+                        return 0;
+        }
+}
+
+
+bool Conf_analyser::read_atom_names(const string &file_name) const
+{
+        /* compiled list is mapped to memory instead of parsing */
+        if (is_name_table(file_name)) {
+                if (ring_size() == 0) {
+                        diagnostics() << "Can`t deduce number of atoms from given analysis type!" << '\n';
+                        return false;
+                }
+                return load_name_table(file_name, ring_size());
+        }
+
+        ifstream ifile;
+        ifile.open(file_name);
+	if (ifile.fail()) {
+                diagnostics() << "Could not open file " << file_name << "..." << '\n';
+                return false;
+        }
+
+        bool result = read_atom_names(ifile, file_name);
+        ifile.close();
+
+        return result;
+}
+
+
+bool Conf_analyser::read_atom_names(istream &in, const string &source_name) const
+{
+        size_t atoms_count = ring_size();
+        if (atoms_count == 0) {
+                diagnostics() << "Can`t deduce number of atoms from given analysis type!" << '\n';
+                return false;
+        }
+
+        string line;
+	size_t line_number = 1; /* keep line number for case of error */
+        stringstream ss;
+       	while (getline(in, line)) {
+	        ss.clear();
+	        ss.str(line);
+
+                /* Get lignad name */
+                string ligand_name;
+                ss >> ligand_name;
+
+                if (ss.fail()) {
+                        ss.clear();
+                        diagnostics() << source_name << ": Wrong syntax on line nr. "
+                             << line_number << "..." << '\n';
+                        line_number++;
+                        continue;
+                }
+
+                /* Read atom names to temporary container */
+                vector<string> tmp_vec;
+                string tmp_str;
+                while (ss >> tmp_str) {
+                        ss.clear();
+                        tmp_vec.push_back(tmp_str);
+                }
+
+                if (tmp_vec.size() != atoms_count) {
+                        diagnostics() << source_name << ": Wrong number of atom names on line nr. "
+                             << line_number << " (expected " << atoms_count << ", was "
+                             << tmp_vec.size() << "), entry ommited..." << '\n';
+                        line_number++;
+                        continue;
+                }
+
+                /* Create new lingand entry, if this one doesn`t exist */
+                if (Molecule::atom_names.count(ligand_name) == 0) {
+                        vector<vector<string>> all_names_list;
+                        Molecule::atom_names.insert(map<string, vector<vector<string>>>::value_type(ligand_name, all_names_list));
+                }
+
+                /* fill the atom names */
+                for (size_t i = 0; i < atoms_count; i++) {
+                        if (Molecule::atom_names.at(ligand_name).size() <= i) {
+                                vector<string> current_names_list;
+                                Molecule::atom_names.at(ligand_name).push_back(current_names_list);
+                        }
+                        Molecule::atom_names.at(ligand_name).at(i).push_back(tmp_vec[i]);
+                }
+
+                line_number++;
+        }
+
+        return true;
+}
+
+
+bool Conf_analyser::compile_atom_names(ostream &out) const
+{
+        return write_name_table(out, ring_size());
+}
+
+
+bool Conf_analyser::read_file(const string &file_name, string &content)
+{
+        ifstream ifile;
+        {
+                STAGE_TIMER(STAGE_OPEN);
+                ifile.open(file_name, ios::binary);
+        }
+	if (ifile.fail()) {
+                COUNT(COUNTER_NOT_FOUND, 1);
+                return false;
+        }
+
+        /* whole file is read at once, lines are split in memory */
+        STAGE_TIMER(STAGE_READ);
+        content.clear();
+        ifile.seekg(0, ios::end);
+        streamoff size = ifile.tellg();
+        if (size > 0) {
+                content.resize(size);
+                ifile.seekg(0, ios::beg);
+                ifile.read(&content[0], size);
+                content.resize(ifile.gcount());
+        }
+        ifile.close();
+        COUNT(COUNTER_BYTES, content.size());
+
+        return true;
+}
+
+
+bool Conf_analyser::read_PDB(const string &file_name, vector<Atom*> &atoms)
+{
+        string content;
+        if (!read_file(file_name, content)) {
+                diagnostics() << "Could not open file " << file_name << "..." << '\n';
+                return false;
+        }
+
+        parse_PDB(content.data(), content.size(), atoms);
+
+        return true;
+}
+
+
+void Conf_analyser::parse_PDB(const char *data, size_t size,
+                              vector<Atom*> &atoms)
+{
+        STAGE_TIMER(STAGE_PARSE);
+        [[maybe_unused]] size_t atoms_before = atoms.size();
+        const char *end = data + size;
+	size_t line_number = 1; /* keep line number for case of error */
+        while (data < end) {
+                const char *eol = static_cast<const char*>(
+                                        memchr(data, '\n', end - data));
+                if (eol == nullptr) {
+                        eol = end;
+                }
+
+                size_t length = eol - data;
+                if (length >= 6 && (memcmp(data, "ATOM  ", 6) == 0 ||
+                                    memcmp(data, "HETATM", 6) == 0)) {
+                        Atom *atom = new Atom();
+                        atom->set_line_number(line_number);
+                        atom->read_entry(string(data, length));
+                        atoms.push_back(atom);
+                }
+
+                data = eol + 1;
+                line_number++;
+        }
+        COUNT(COUNTER_ATOMS, atoms.size() - atoms_before);
+}
+
+
+Ring *Conf_analyser::create_molecule(const string &structure) const
+{
+        Ring *ring;
+        switch (analysis_type) {
+                case CYCLOHEXANE:
+                        ring = new Cyclohexane(structure);
+                        break;
+                case CYCLOPENTANE:
+                        ring = new Cyclopentane(structure);
+                        break;
+                case BENZENE:
+                        ring = new Benzene(structure);
+                        break;
+                case OXANE:
+                        ring = new Oxane(structure);
+                        break;
+                default:
+                        diagnostics() << "Unknown type of analysis!" << '\n';
+                        return nullptr;
+        }
+        ring->set_engine(engine);
+        return ring;
+}
+
+
+map<string, short> Conf_analyser::conformations() const
+{
+        map<string, short> table;
+        Ring *ring = create_molecule("");
+        if (ring != nullptr) {
+                table = ring->get_conformations();
+                delete(ring);
+        }
+        return table;
+}
+
+
+Molecule *Conf_analyser::analyse_atoms(Ring *mol, vector<Atom*> &atoms) const
+{
+        bool success;
+        {
+                STAGE_TIMER(STAGE_MATCH);
+                success = mol->initialize(atoms);
+        }
+        if (success) {
+                STAGE_TIMER(STAGE_ANALYSE);
+                success = mol->analyse();
+                if (!success) {
+                        COUNT(COUNTER_OTHER_FAILURE, 1);
+                }
+        }
+        if (success && precision_check) {
+                check_precision(mol);
+        }
+        if (success && confidence_trials > 0) {
+                STAGE_TIMER(STAGE_CONFIDENCE);
+                mol->estimate_confidence(confidence_trials, confidence_sigma);
+        }
+
+        for (auto x : atoms) {
+                delete(x);
+        }
+        atoms.clear();
+
+        if (!success) {
+                delete(mol);
+                return nullptr;
+        }
+
+        return mol;
+}
+
+
+Molecule *Conf_analyser::analyse_file(const string &file_name) const
+{
+        string content;
+        if (!read_file(file_name, content)) {
+                diagnostics() << "Could not open file " << file_name << "..." << '\n';
+                return nullptr;
+        }
+
+        return analyse_buffer(file_name, content.data(), content.size());
+}
+
+
+Molecule *Conf_analyser::analyse_buffer(const string &structure,
+                                        const char *data, size_t size) const
+{
+        vector<Atom*> atoms;
+
+        /* unwanted structures are rejected before parsing coordinates */
+        if (header_filter.enabled()) {
+                string reason = header_filter.check(
+                                Structure_header::parse(data, size));
+                if (!reason.empty()) {
+                        COUNT(COUNTER_FILTERED, 1);
+                        diagnostics() << structure << ": rejected by header (" << reason << ")!" << '\n';
+                        return nullptr;
+                }
+        }
+
+        Ring *mol = create_molecule(structure);
+        if (mol == nullptr) {
+                return nullptr;
+        }
+
+        parse_PDB(data, size, atoms);
+        atom_selection.select(atoms);
+
+        return analyse_atoms(mol, atoms);
+}
+
+
+bool Conf_analyser::analyse_buffer(const string &structure, const char *data,
+                                   size_t size, Ring_result &result) const
+{
+        Molecule *mol = analyse_buffer(structure, data, size);
+        if (mol == nullptr) {
+                return false;
+        }
+
+        result = mol->get_result();
+        delete(mol);
+
+        return true;
+}
+
+
+/* Codes of conformations of batch of rings classified by the ring */
+template<typename T>
+static vector<short> conformation_codes(Ring *ring, const T *coordinates,
+                                        size_t ring_count)
+{
+        vector<short> codes;
+        if (ring == nullptr) {
+                return codes;
+        }
+        codes.resize(ring_count);
+        ring->classify_batch(coordinates, ring_count, codes.data());
+        for (auto &x : codes) {
+                x = ring->class_conformation(x);
+        }
+        delete(ring);
+        return codes;
+}
+
+
+vector<short> Conf_analyser::classify_coordinates(const float *coordinates,
+                                                  size_t ring_count) const
+{
+        return conformation_codes(create_molecule(""), coordinates,
+                                  ring_count);
+}
+
+
+vector<short> Conf_analyser::classify_coordinates(const double *coordinates,
+                                                  size_t ring_count) const
+{
+        return conformation_codes(create_molecule(""), coordinates,
+                                  ring_count);
+}
+
+
+void Conf_analyser::check_precision(Ring *mol) const
+{
+        double coordinates[3 * MAX_RING_SIZE];
+        float single[3 * MAX_RING_SIZE];
+        mol->get_coordinates(coordinates);
+        for (size_t i = 0; i < 3 * mol->size(); i++) {
+                single[i] = coordinates[i];
+        }
+
+        /* by the engine of the analysis, as the ring was classified */
+        short code, single_code;
+        mol->classify_batch(coordinates, 1, &code);
+        mol->classify_batch(single, 1, &single_code);
+        if (code == single_code) {
+                return;
+        }
+
+        COUNT(COUNTER_PRECISION, 1);
+        diagnostics() << mol->get_result().structure << ": "
+                      << mol->class_name(code) << " in double but "
+                      << mol->class_name(single_code)
+                      << " in single precision!" << '\n';
+}
+
+
+vector<Ring_result> Conf_analyser::analyse_coordinates(const double *coordinates,
+                                                       size_t ring_count) const
+{
+        vector<Ring_result> results;
+        size_t atoms_count = ring_size();
+        if (atoms_count == 0) {
+                diagnostics() << "Can`t deduce number of atoms from given analysis type!" << '\n';
+                return results;
+        }
+
+        results.reserve(ring_count);
+        for (size_t i = 0; i < ring_count; i++) {
+                Ring *mol = create_molecule(to_string(i));
+                mol->set_coordinates(coordinates + 3 * atoms_count * i);
+                mol->analyse();
+                mol->estimate_confidence(confidence_trials, confidence_sigma);
+                results.push_back(mol->get_result());
+                delete(mol);
+        }
+
+        return results;
+}
@@ -0,0 +1,112 @@
+#ifndef CONF_ANALYSER_H
+#define CONF_ANALYSER_H
+
+#include "molecule.h"
+#include "ring.h"
+#include "structure_header.h"
+#include "atom_selection.h"
+#include <istream>
+#include <ostream>
+#include <map>
+#include <string>
+#include <vector>
+
+/* Supported types of analysis */
+#define EMPTY        -1
+#define CYCLOHEXANE   0
+#define CYCLOPENTANE  1
+#define BENZENE       2
+#define OXANE         3
+
+/*
+ * Embeddable interface of the conformation analysis (libconfanalyser).
+ *
+ * The atom names list is shared by all analysers of the process
+ * (Molecule::atom_names), once it is loaded all the analysing methods
+ * are read-only and can be called from more threads at once.
+ */
+class Conf_analyser
+{
+        public:
+                Conf_analyser(int _analysis_type = EMPTY);
+                void set_analysis_type(int _analysis_type);
+                int get_analysis_type() const;
+                /* Structures failing the filter are not analysed */
+                void set_header_filter(const Header_filter &filter);
+                /* Parsed atoms are reduced by the selection before matching */
+                void set_atom_selection(const Atom_selection &selection);
+                /* Monte Carlo confidence of analysed rings (trials per ring,
+                   0 to switch off), sigma as Ring::estimate_confidence() */
+                void set_confidence(size_t _confidence_trials,
+                                    double _confidence_sigma);
+                /* Engine recognizing conformations (ENGINE_* of
+                   torsion_classifier.h), geometric by default */
+                void set_engine(int _engine);
+                /* Number of ring atoms of current analysis type, 0 if unknown */
+                size_t ring_size() const;
+
+                /* Reading list of atom names, text or compiled one */
+                bool read_atom_names(const std::string &file_name) const;
+                bool read_atom_names(std::istream &in,
+                                     const std::string &source_name) const;
+                /* Writing loaded atom names as a compiled list (name_table.h) */
+                bool compile_atom_names(std::ostream &out) const;
+
+                /* Reading whole file to memory (without diagnostics) */
+                static bool read_file(const std::string &file_name,
+                                      std::string &content);
+
+                /* Reading atoms of PDB structure */
+                static bool read_PDB(const std::string &file_name,
+                                     std::vector<Atom*> &atoms);
+                static void parse_PDB(const char *data, size_t size,
+                                      std::vector<Atom*> &atoms);
+
+                /* Empty molecule of current analysis type */
+                Ring *create_molecule(const std::string &structure) const;
+                /* Conformations of current analysis type and their codes */
+                std::map<std::string, short> conformations() const;
+
+                /* Analyse ring from PDB file or from PDB file already
+                   loaded to memory, nullptr is returned in case of failure,
+                   otherwise caller owns the returned molecule */
+                Molecule *analyse_file(const std::string &file_name) const;
+                Molecule *analyse_buffer(const std::string &structure,
+                                         const char *data, size_t size) const;
+                bool analyse_buffer(const std::string &structure,
+                                    const char *data, size_t size,
+                                    Ring_result &result) const;
+
+                /* Analyse batch of rings given by coordinates only, there are
+                   ring_size() atoms (X, Y, Z) per ring in the order of atom
+                   names list, oxane ring expects the oxygen atom to be last */
+                std::vector<Ring_result> analyse_coordinates(
+                                const double *coordinates,
+                                size_t ring_count) const;
+                /* Codes of conformations of batch of rings (coordinates as
+                   above) by the engine of set_engine, without descriptors;
+                   single precision is the fast path of large batches, empty
+                   for unknown analysis type */
+                std::vector<short> classify_coordinates(
+                                const float *coordinates,
+                                size_t ring_count) const;
+                std::vector<short> classify_coordinates(
+                                const double *coordinates,
+                                size_t ring_count) const;
+                /* Report rings classified differently by the engine in
+                   single and double precision to diagnostics */
+                void set_precision_check(bool _precision_check);
+        private:
+                Molecule *analyse_atoms(Ring *mol,
+                                        std::vector<Atom*> &atoms) const;
+                void check_precision(Ring *mol) const;
+                int analysis_type;
+                Header_filter header_filter;
+                Atom_selection atom_selection;
+                size_t confidence_trials;
+                double confidence_sigma;
+                int engine;
+                bool precision_check;
+};
+
+#endif
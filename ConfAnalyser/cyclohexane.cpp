@@ -3,6 +3,8 @@
 #include "plane_3D.h"
 #include "angle.h"
 #include "helper_functions.h"
+#include "output_sink.h"
+#include "instrumentation.h"
 
 #define ATOM_C1 0
 #define ATOM_C2 1
@@ -11,16 +13,29 @@
 #define ATOM_C5 4
 #define ATOM_C6 5
 
+#define UNDEFINIED      1
+#define FLAT            2
+#define CHAIR           3
+#define TWISTED_BOAT    4
+#define HALF_CHAIR      5
+#define BOAT            6
+
 using namespace std;
 
 
-Cyclohexane::Cyclohexane(string _structure) : Six_atom_ring(_structure)
-{
-        conformations.insert({"CHAIR", 3});
-        conformations.insert({"TWISTED BOAT", 4});
-        conformations.insert({"HALF CHAIR", 5});
-        conformations.insert({"BOAT", 6});
-}
+map<string, short> Cyclohexane::conformation_table = {
+        {"UNANALYSED", 0},
+        {"UNDEFINIED", UNDEFINIED},
+        {"FLAT", FLAT},
+        {"CHAIR", CHAIR},
+        {"TWISTED BOAT", TWISTED_BOAT},
+        {"HALF CHAIR", HALF_CHAIR},
+        {"BOAT", BOAT}
+};
+
+
+Cyclohexane::Cyclohexane(string _structure)
+        : Six_atom_ring(_structure, conformation_table) {}
 
 
 Cyclohexane::~Cyclohexane()
@@ -36,7 +51,8 @@ Cyclohexane::~Cyclohexane()
 static bool filler(Atom *x, bool &found, Atom *&C)
 {
         if (found) {
-                cerr << strip(x->get_atom_name()) << " atom found twice!\n";
+                COUNT(COUNTER_DUPLICATE_ATOMS, 1);
+                diagnostics() << strip(x->get_atom_name()) << " atom found twice!\n";
                 return false;
         }
 
@@ -54,8 +70,11 @@ bool Cyclohexane::initialize(const vector<Atom*> &atoms)
 	for (auto x : atoms) {
 	        if (ligand.empty()) {
                         ligand = x->get_residue_name();
+                        chain_id = x->get_chain_id();
+                        residue_number = x->get_residue_number();
                         if (atom_names.find(ligand) == atom_names.end()) {
-                                cerr << "Ligand not recognized!" << endl;
+                                COUNT(COUNTER_UNKNOWN_LIGAND, 1);
+                                diagnostics() << "Ligand not recognized!" << '\n';
                                 return false;
                         }
                 }
@@ -90,93 +109,95 @@ bool Cyclohexane::initialize(const vector<Atom*> &atoms)
         filled = found[0] && found[1] && found[2] && found[3]
                                                 && found[4] && found[5];
         if (!filled) {
-             cerr << "Not all atoms were found!" << endl;   
+             COUNT(COUNTER_MISSING_ATOMS, 1);
+             diagnostics() << "Not all atoms were found!" << '\n';   
         }
 
         return filled;
 }
 
 
-bool Cyclohexane::is_flat() const
+template<typename T>
+bool Cyclohexane::is_flat(const Point_3D_t<T> *P, int begin, bool has_plane)
 {
         /* flat conforamtion has all atoms in one plane */
         if (!has_plane) {
                 return false;
         }
 
-        Plane_3D left_plane(*(C[begin]), *(C[(begin+1)%6]), *(C[(begin+4)%6]));
-        Plane_3D right_plane(*(C[begin]), *(C[(begin+1)%6]), *(C[(begin+3)%6]));
-        return left_plane.is_on_plane(*(C[(begin+2)%6]), tolerance_flat_in) &&
-               left_plane.is_on_plane(*(C[(begin+5)%6]), tolerance_flat_in) &&
-               right_plane.is_on_plane(*(C[(begin+2)%6]), tolerance_flat_in) &&
-               right_plane.is_on_plane(*(C[(begin+5)%6]), tolerance_flat_in);
+        Plane_3D_t<T> left_plane(P[begin], P[(begin+1)%6], P[(begin+4)%6]);
+        Plane_3D_t<T> right_plane(P[begin], P[(begin+1)%6], P[(begin+3)%6]);
+        return left_plane.is_on_plane(P[(begin+2)%6], tolerance_flat_in) &&
+               left_plane.is_on_plane(P[(begin+5)%6], tolerance_flat_in) &&
+               right_plane.is_on_plane(P[(begin+2)%6], tolerance_flat_in) &&
+               right_plane.is_on_plane(P[(begin+5)%6], tolerance_flat_in);
 }
 
 
-bool Cyclohexane::is_half_chair() const
+template<typename T>
+bool Cyclohexane::is_half_chair(const Point_3D_t<T> *P, int begin, bool has_plane)
 {
         /* half chair has all but one atom in one plane */
         if (!has_plane) {
                 return false;
         }
 
-        Plane_3D plane(*(C[begin]), *(C[(begin+1)%6]), *(C[(begin+3)%6]));
-        double right_dist = plane.distance_from(*(C[(begin+2)%6]));
-        double left_dist = plane.distance_from(*(C[(begin+5)%6]));
-        return (plane.is_on_plane(*(C[(begin+2)%6]), tolerance_flat_in) !=
-                plane.is_on_plane(*(C[(begin+5)%6]), tolerance_flat_in)) &&
-               plane.is_on_plane(*(C[(begin+4)%6]), tolerance_flat_in) &&
+        Plane_3D_t<T> plane(P[begin], P[(begin+1)%6], P[(begin+3)%6]);
+        T right_dist = plane.distance_from(P[(begin+2)%6]);
+        T left_dist = plane.distance_from(P[(begin+5)%6]);
+        return (plane.is_on_plane(P[(begin+2)%6], tolerance_flat_in) !=
+                plane.is_on_plane(P[(begin+5)%6], tolerance_flat_in)) &&
+               plane.is_on_plane(P[(begin+4)%6], tolerance_flat_in) &&
                ((abs(right_dist) > tolerance_out) !=
                 (abs(left_dist) > tolerance_out));
 }
 
 
-bool Cyclohexane::is_chair() const
+template<typename T>
+bool Cyclohexane::is_chair(const Point_3D_t<T> *P, int begin, bool has_plane)
 {
         /* two atoms of chair are on the opposite sides of plane */
         if (!has_plane) {
                 return false;
         }
-        Plane_3D plane(*(C[begin]), *(C[(begin+1)%6]), *(C[(begin+3)%6]));
-        double right_dist = plane.distance_from(*(C[(begin+2)%6]));
-        double left_dist = plane.distance_from(*(C[(begin+5)%6]));
+        Plane_3D_t<T> plane(P[begin], P[(begin+1)%6], P[(begin+3)%6]);
+        T right_dist = plane.distance_from(P[(begin+2)%6]);
+        T left_dist = plane.distance_from(P[(begin+5)%6]);
         return (abs(right_dist) > tolerance_out &&
                 abs(left_dist) > tolerance_out) &&
                (right_dist * left_dist < 0);
 }
 
 
-bool Cyclohexane::is_boat() const
+template<typename T>
+bool Cyclohexane::is_boat(const Point_3D_t<T> *P, int begin, bool has_plane)
 {
         /* two atoms of boat are on the same side of plane */
         if (!has_plane) {
                 return false;
         }
-        Plane_3D plane(*(C[begin]), *(C[(begin+1)%6]), *(C[(begin+3)%6]));
-        double right_dist = plane.distance_from(*(C[(begin+2)%6]));
-        double left_dist = plane.distance_from(*(C[(begin+5)%6]));
+        Plane_3D_t<T> plane(P[begin], P[(begin+1)%6], P[(begin+3)%6]);
+        T right_dist = plane.distance_from(P[(begin+2)%6]);
+        T left_dist = plane.distance_from(P[(begin+5)%6]);
         return (abs(right_dist) > tolerance_out &&
                 abs(left_dist) > tolerance_out) &&
                (right_dist * left_dist > 0);
 }
 
 
-bool Cyclohexane::is_tw_boat() const
+template<typename T>
+bool Cyclohexane::is_tw_boat(const Point_3D_t<T> *P, int begin, bool has_plane)
 {
         /* twisted boat has no plane within the circle */
         if (has_plane) {
                 return false;
         }
-        Plane_3D right_plane(*(C[begin]),
-                             *(C[(begin+1)%6]),
-                             *(C[(begin+3)%6]));
-        Plane_3D left_plane(*(C[begin]),
-                            *(C[(begin+1)%6]),
-                            *(C[(begin+4)%6]));
-        double right_dist = right_plane.distance_from(*(C[(begin+2)%6]));
-        double left_dist = left_plane.distance_from(*(C[(begin+5)%6]));
-        double tw_angle = dihedral_angle(*(C[(begin+1)%6]), *(C[(begin+3)%6]),
-					 *(C[(begin+4)%6]), *(C[begin]));
+        Plane_3D_t<T> right_plane(P[begin], P[(begin+1)%6], P[(begin+3)%6]);
+        Plane_3D_t<T> left_plane(P[begin], P[(begin+1)%6], P[(begin+4)%6]);
+        T right_dist = right_plane.distance_from(P[(begin+2)%6]);
+        T left_dist = left_plane.distance_from(P[(begin+5)%6]);
+        T tw_angle = dihedral_angle(P[(begin+1)%6], P[(begin+3)%6],
+                                    P[(begin+4)%6], P[begin]);
         return ((abs(tw_angle) > angle_tw_boat - angle_tolerance) &&
                 (abs(tw_angle) < angle_tw_boat + angle_tolerance)) &&
                ((abs(right_dist) > tolerance_tw_out) &&
@@ -185,33 +206,69 @@ bool Cyclohexane::is_tw_boat() const
 }
 
 
+template<typename T>
+void Cyclohexane::classify_rings(const T *coordinates, size_t ring_count,
+                                 short *classes)
+{
+        for (size_t i = 0; i < ring_count; i++) {
+                Point_3D_t<T> P[6];
+                ring_points(coordinates + 18 * i, P);
+
+                /* finding the most accurate plane of 4 atoms within the ring */
+                int begin;
+                bool has_plane = find_plane(P, static_cast<T>(tolerance_in), begin);
+                if (is_flat(P, begin, has_plane)) {
+                        classes[i] = FLAT;
+                } else if (is_half_chair(P, begin, has_plane)) {
+                        classes[i] = HALF_CHAIR;
+                } else if (is_boat(P, begin, has_plane)) {
+                        classes[i] = BOAT;
+                } else if (is_tw_boat(P, begin, has_plane)) {
+                        classes[i] = TWISTED_BOAT;
+                } else if (is_chair(P, begin, has_plane)) {
+                        classes[i] = CHAIR;
+                } else {
+                        classes[i] = UNDEFINIED;
+                }
+        }
+}
+
+
+void Cyclohexane::classify_geometric(const double *coordinates,
+                                     size_t ring_count, short *classes) const
+{
+        classify_rings(coordinates, ring_count, classes);
+}
+
+
+void Cyclohexane::classify_geometric(const float *coordinates,
+                                     size_t ring_count, short *classes) const
+{
+        classify_rings(coordinates, ring_count, classes);
+}
+
+
+void Cyclohexane::classify()
+{
+        double coordinates[18];
+        get_coordinates(coordinates);
+        classify_geometric(coordinates, 1, &conformation);
+}
+
+
 bool Cyclohexane::analyse()
 {
         if (!filled) {
-                cerr << "Molecule has to be filled before analysis!" << endl;
+                diagnostics() << "Molecule has to be filled before analysis!" << '\n';
                 return false;
         }
         if (analysed) {
-                cerr << "Attempt to analyze the same molecule twice!" << endl;
+                diagnostics() << "Attempt to analyze the same molecule twice!" << '\n';
                 return false;
         }
 
-        /* finding the most accurate plane of 4 atoms within the ring */
-        has_plane = find_plane(tolerance_in);
-        if (is_flat()) {
-                conformation = conformations["FLAT"];
-        } else if (is_half_chair()) {
-                conformation = conformations["HALF CHAIR"];
-        } else if (is_boat()) {
-                conformation = conformations["BOAT"];
-        } else if (is_tw_boat()) {
-		conformation = conformations["TWISTED BOAT"];
-        } else if (is_chair()) {
-                conformation = conformations["CHAIR"];
-        } else {
-		conformation = conformations["UNDEFINIED"];
-        }
-                
+        recognize();
+        describe();
         analysed = true;
         return true;
 }
@@ -220,8 +277,12 @@ bool Cyclohexane::analyse()
 bool Cyclohexane::is_valid_atom_name(const int atom_number,
                                         const std::string &name) const
 {
-        return (ligand.empty()) ? false :
-                                any_of(atom_names[ligand][atom_number].begin(),
-                                atom_names[ligand][atom_number].end(),
-                                [&name](string &tmp){return tmp == name;});
+        auto itr = atom_names.find(ligand);
+        if (ligand.empty() || itr == atom_names.end() ||
+            static_cast<size_t>(atom_number) >= itr->second.size()) {
+                return false;
+        }
+        const vector<string> &names = itr->second[atom_number];
+        return any_of(names.begin(), names.end(),
+                      [&name](const string &tmp){return tmp == name;});
 }
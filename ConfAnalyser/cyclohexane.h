@@ -13,16 +13,35 @@ class Cyclohexane: public Six_atom_ring
                 virtual ~Cyclohexane();
                 virtual bool analyse();
                 virtual bool initialize(const std::vector<Atom*> &atoms);
+        protected:
+                virtual void classify();
+                virtual void classify_geometric(const double *coordinates,
+                                                size_t ring_count,
+                                                short *classes) const;
+                virtual void classify_geometric(const float *coordinates,
+                                                size_t ring_count,
+                                                short *classes) const;
         private:
-                /* functions for analyzing */
-                bool is_flat() const;
-                bool is_half_chair() const;
-                bool is_chair() const;
-                bool is_boat() const; 
-                bool is_tw_boat() const;
+                template<typename T>
+                static void classify_rings(const T *coordinates,
+                                           size_t ring_count, short *classes);
+                /* functions for analyzing ring of atoms P by its plane
+                   starting at atom begin */
+                template<typename T>
+                static bool is_flat(const Point_3D_t<T> *P, int begin, bool has_plane);
+                template<typename T>
+                static bool is_half_chair(const Point_3D_t<T> *P, int begin, bool has_plane);
+                template<typename T>
+                static bool is_chair(const Point_3D_t<T> *P, int begin, bool has_plane);
+                template<typename T>
+                static bool is_boat(const Point_3D_t<T> *P, int begin, bool has_plane);
+                template<typename T>
+                static bool is_tw_boat(const Point_3D_t<T> *P, int begin, bool has_plane);
 		/* function verifying atom names for current ligand type */
 		bool is_valid_atom_name(const int atom_number,
 		                        const std::string &name) const;
+                /* Possible conformations of this ring type */
+                static std::map<std::string, short> conformation_table;
                 /* Tolerances */
                 static constexpr double tolerance_in = 0.1;
                 static constexpr double tolerance_flat_in = 0.1;
@@ -3,6 +3,8 @@
 #include "plane_3D.h"
 #include "angle.h"
 #include "helper_functions.h"
+#include "output_sink.h"
+#include "instrumentation.h"
 
 #define ATOM_C1 0
 #define ATOM_C2 1
@@ -10,14 +12,25 @@
 #define ATOM_C4 3
 #define ATOM_C5 4
 
+#define UNDEFINIED      1
+#define FLAT            2
+#define ENVELOPE        3
+#define TWIST           4
+
 using namespace std;
 
 
-Cyclopentane::Cyclopentane(string _structure) : Five_atom_ring(_structure)
-{
-        conformations.insert({"ENVELOPE", 3});
-        conformations.insert({"TWIST", 4});
-}
+map<string, short> Cyclopentane::conformation_table = {
+        {"UNANALYSED", 0},
+        {"UNDEFINIED", UNDEFINIED},
+        {"FLAT", FLAT},
+        {"ENVELOPE", ENVELOPE},
+        {"TWIST", TWIST}
+};
+
+
+Cyclopentane::Cyclopentane(string _structure)
+        : Five_atom_ring(_structure, conformation_table) {}
 
 
 Cyclopentane::~Cyclopentane()
@@ -33,7 +46,8 @@ Cyclopentane::~Cyclopentane()
 static bool filler(Atom *x, bool &found, Atom *&C)
 {
         if (found) {
-                cerr << strip(x->get_atom_name()) << " atom found twice!\n";
+                COUNT(COUNTER_DUPLICATE_ATOMS, 1);
+                diagnostics() << strip(x->get_atom_name()) << " atom found twice!\n";
                 return false;
         }
 
@@ -51,8 +65,11 @@ bool Cyclopentane::initialize(const vector<Atom*> &atoms)
 	for (auto x : atoms) {
 	        if (ligand.empty()) {
                         ligand = x->get_residue_name();
+                        chain_id = x->get_chain_id();
+                        residue_number = x->get_residue_number();
                         if (atom_names.find(ligand) == atom_names.end()) {
-                                cerr << "Ligand not recognized!" << endl;
+                                COUNT(COUNTER_UNKNOWN_LIGAND, 1);
+                                diagnostics() << "Ligand not recognized!" << '\n';
                                 return false;
                         }
                 }
@@ -83,56 +100,56 @@ bool Cyclopentane::initialize(const vector<Atom*> &atoms)
         filled = found[0] && found[1] && found[2] && found[3] && found[4];
 
         if (!filled) {
-             cerr << "Not all atoms were found!" << endl;   
+             COUNT(COUNTER_MISSING_ATOMS, 1);
+             diagnostics() << "Not all atoms were found!" << '\n';   
         }
 
         return filled;
 }
 
 
-bool Cyclopentane::is_flat() const
+template<typename T>
+bool Cyclopentane::is_flat(const Point_3D_t<T> *P, int begin, bool has_plane)
 {
         /* flat conformation has all atoms in one plane */
         if (!has_plane) {
                 return false;
         }
 
-        Plane_3D plane(*(C[begin]), *(C[(begin+1)%5]), *(C[(begin+2)%5]));
-        return plane.is_on_plane(*(C[(begin+3)%5]), tolerance_in) &&
-               plane.is_on_plane(*(C[(begin+4)%5]), tolerance_in); 
+        Plane_3D_t<T> plane(P[begin], P[(begin+1)%5], P[(begin+2)%5]);
+        return plane.is_on_plane(P[(begin+3)%5], tolerance_in) &&
+               plane.is_on_plane(P[(begin+4)%5], tolerance_in); 
 }
 
 
-bool Cyclopentane::is_envelope() const
+template<typename T>
+bool Cyclopentane::is_envelope(const Point_3D_t<T> *P, int begin, bool has_plane)
 {
         /* envelope conformation has all but one atom in one plane */
         if (!has_plane) {
                 return false;
         }
 
-        Plane_3D plane(*(C[begin]), *(C[(begin+1)%5]), *(C[(begin+2)%5]));
+        Plane_3D_t<T> plane(P[begin], P[(begin+1)%5], P[(begin+2)%5]);
 
-        return abs(plane.distance_from(*(C[(begin+4)%5]))) > tolerance_out;
+        return abs(plane.distance_from(P[(begin+4)%5])) > tolerance_out;
 }
 
 
-bool Cyclopentane::is_twist() const
+template<typename T>
+bool Cyclopentane::is_twist(const Point_3D_t<T> *P, int begin, bool has_plane)
 {
         /* twist conformation has no plane within the circle */
         if (has_plane) {
                 return false;
         }
 
-        Plane_3D left_plane(*(C[begin]),
-                            *(C[(begin+1)%5]),
-                            *(C[(begin+3)%5]));
-        Plane_3D right_plane(*(C[begin]),
-                             *(C[(begin+2)%5]),
-                             *(C[(begin+3)%5]));
-        double left_dist = left_plane.distance_from(*(C[(begin+4)%5]));
-        double right_dist = right_plane.distance_from(*(C[(begin+4)%5]));
-        double tw_angle = dihedral_angle(*(C[begin]), *(C[(begin+1)%5]),
-					 *(C[(begin+2)%5]), *(C[(begin+3)%5]));
+        Plane_3D_t<T> left_plane(P[begin], P[(begin+1)%5], P[(begin+3)%5]);
+        Plane_3D_t<T> right_plane(P[begin], P[(begin+2)%5], P[(begin+3)%5]);
+        T left_dist = left_plane.distance_from(P[(begin+4)%5]);
+        T right_dist = right_plane.distance_from(P[(begin+4)%5]);
+        T tw_angle = dihedral_angle(P[begin], P[(begin+1)%5],
+                                    P[(begin+2)%5], P[(begin+3)%5]);
         return (abs(abs(tw_angle) - angle_tw_boat) < angle_tolerance) &&
                (abs(right_dist) > tolerance_tw_out) &&
                (abs(left_dist) > tolerance_tw_out) &&
@@ -140,29 +157,65 @@ bool Cyclopentane::is_twist() const
 }
 
 
+template<typename T>
+void Cyclopentane::classify_rings(const T *coordinates, size_t ring_count,
+                                  short *classes)
+{
+        for (size_t i = 0; i < ring_count; i++) {
+                Point_3D_t<T> P[5];
+                ring_points(coordinates + 15 * i, P);
+
+                /* finding the most accurate plane of 4 atoms within the ring */
+                int begin;
+                bool has_plane = find_plane(P, static_cast<T>(tolerance_in), begin);
+                if (is_flat(P, begin, has_plane)) {
+                        classes[i] = FLAT;
+                } else if (is_envelope(P, begin, has_plane)) {
+                        classes[i] = ENVELOPE;
+                } else if (is_twist(P, begin, has_plane)) {
+                        classes[i] = TWIST;
+                } else {
+                        classes[i] = UNDEFINIED;
+                }
+        }
+}
+
+
+void Cyclopentane::classify_geometric(const double *coordinates,
+                                      size_t ring_count, short *classes) const
+{
+        classify_rings(coordinates, ring_count, classes);
+}
+
+
+void Cyclopentane::classify_geometric(const float *coordinates,
+                                      size_t ring_count, short *classes) const
+{
+        classify_rings(coordinates, ring_count, classes);
+}
+
+
+void Cyclopentane::classify()
+{
+        double coordinates[15];
+        get_coordinates(coordinates);
+        classify_geometric(coordinates, 1, &conformation);
+}
+
+
 bool Cyclopentane::analyse()
 {
         if (!filled) {
-                cerr << "Molecule has to be filled before analysis!" << endl;
+                diagnostics() << "Molecule has to be filled before analysis!" << '\n';
                 return false;
         }
         if (analysed) {
-                cerr << "Attempt to analyze the same molecule twice!" << endl;
+                diagnostics() << "Attempt to analyze the same molecule twice!" << '\n';
                 return false;
         }
 
-        /* finding the most accurate plane of 4 atoms within the ring */
-        has_plane = find_plane(tolerance_in);
-        if (is_flat()) {
-                conformation = conformations["FLAT"];
-        } else if (is_envelope()) {
-                conformation = conformations["ENVELOPE"];
-        } else if (is_twist()) {
-		conformation = conformations["TWIST"];
-        } else {
-		conformation = conformations["UNDEFINIED"];
-        }
-                
+        recognize();
+        describe();
         analysed = true;
         return true;
 }
@@ -171,8 +224,12 @@ bool Cyclopentane::analyse()
 bool Cyclopentane::is_valid_atom_name(const int atom_number,
                                         const string &name) const
 {
-        return (ligand.empty()) ? false :
-                                any_of(atom_names[ligand][atom_number].begin(),
-                                atom_names[ligand][atom_number].end(),
-                                [&name](string &tmp){return tmp == name;});
+        auto itr = atom_names.find(ligand);
+        if (ligand.empty() || itr == atom_names.end() ||
+            static_cast<size_t>(atom_number) >= itr->second.size()) {
+                return false;
+        }
+        const vector<string> &names = itr->second[atom_number];
+        return any_of(names.begin(), names.end(),
+                      [&name](const string &tmp){return tmp == name;});
 }
@@ -0,0 +1,226 @@
+#include "descriptor_statistics.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+
+using namespace std;
+
+/* Summarized descriptors with ranges and numbers of bins of histograms */
+static const struct
+{
+        const char *name;
+        double Ring_descriptors::*field;
+        double low;
+        double high;
+        size_t bins;
+} descriptors[DESCRIPTORS] = {
+        {"plane_distance",      &Ring_descriptors::plane_distance,       0.0,  0.2, 10},
+        {"right_distance",      &Ring_descriptors::right_distance,      -1.5,  1.5, 12},
+        {"left_distance",       &Ring_descriptors::left_distance,       -1.5,  1.5, 12},
+        {"dihedral",            &Ring_descriptors::dihedral,           -60.0, 60.0, 12},
+        {"puckering_amplitude", &Ring_descriptors::puckering_amplitude,  0.0,  1.5, 10}
+};
+
+/* Ranks printed by print_quantiles */
+static const double ranks[] = {0, 0.05, 0.25, 0.5, 0.75, 0.95, 1};
+static const char *rank_names[] = {"MIN", "5%", "25%", "MEDIAN", "75%", "95%",
+                                   "MAX"};
+
+/* Width of the column of descriptor names */
+#define NAME_WIDTH 22
+/* Width of the columns of values */
+#define VALUE_WIDTH 10
+
+
+Descriptor_statistics::Descriptor_statistics(
+                const map<string, short> &_conformations, uint64_t _stream)
+        : conformations(_conformations)
+{
+        stream = _stream;
+        unanalysed = -1;
+        short codes = 0;
+        for (const auto &x : conformations) {
+                codes = max(codes, static_cast<short>(x.second + 1));
+                if (x.first == "UNANALYSED") {
+                        unanalysed = x.second;
+                }
+        }
+        table.resize(codes);
+}
+
+
+vector<Descriptor_statistics::Distribution> &
+Descriptor_statistics::distributions(short conformation)
+{
+        vector<Distribution> &result = table[conformation];
+        if (result.empty()) {
+                /* every sketch draws its coins from separate stream */
+                uint64_t first = (stream * table.size() + conformation) *
+                                 DESCRIPTORS;
+                for (size_t i = 0; i < DESCRIPTORS; i++) {
+                        result.push_back({Quantile_sketch(first + i),
+                                          Histogram(descriptors[i].low,
+                                                    descriptors[i].high,
+                                                    descriptors[i].bins)});
+                }
+        }
+        return result;
+}
+
+
+void Descriptor_statistics::add(const Ring_result &ring)
+{
+        if (ring.conformation == unanalysed || ring.conformation < 0 ||
+            static_cast<size_t>(ring.conformation) >= table.size()) {
+                return;
+        }
+        vector<Distribution> &x = distributions(ring.conformation);
+        for (size_t i = 0; i < DESCRIPTORS; i++) {
+                double value = ring.descriptors.*descriptors[i].field;
+                if (!isnan(value)) {
+                        x[i].sketch.add(value);
+                        x[i].histogram.add(value);
+                }
+        }
+}
+
+
+void Descriptor_statistics::merge(const Descriptor_statistics &other)
+{
+        for (size_t c = 0; c < table.size() && c < other.table.size(); c++) {
+                if (other.table[c].empty()) {
+                        continue;
+                }
+                vector<Distribution> &x = distributions(static_cast<short>(c));
+                for (size_t i = 0; i < DESCRIPTORS; i++) {
+                        x[i].sketch.merge(other.table[c][i].sketch);
+                        x[i].histogram.merge(other.table[c][i].histogram);
+                }
+        }
+}
+
+
+void Descriptor_statistics::write(ostream &out) const
+{
+        /* distributions of later rings draw their coins from the stream */
+        out << "statistics\t" << stream << '\n';
+        for (size_t c = 0; c < table.size(); c++) {
+                for (size_t i = 0; i < table[c].size(); i++) {
+                        out << "sketch\t" << c << '\t' << descriptors[i].name
+                            << '\t';
+                        table[c][i].sketch.write(out);
+                        out << "\nhistogram\t" << c << '\t'
+                            << descriptors[i].name << '\t';
+                        table[c][i].histogram.write(out);
+                        out << '\n';
+                }
+        }
+}
+
+
+bool Descriptor_statistics::read(const vector<string> &fields)
+{
+        char *end = nullptr;
+        if (fields[0] == "statistics" && fields.size() == 2 &&
+            !fields[1].empty() && fields[1][0] != '-') {
+                stream = strtoull(fields[1].c_str(), &end, 10);
+                return *end == '\0';
+        }
+        if (fields.size() < 4 || fields[1].empty()) {
+                return false;
+        }
+        unsigned long code = strtoul(fields[1].c_str(), &end, 10);
+        if (*end != '\0' || code >= table.size() ||
+            static_cast<short>(code) == unanalysed) {
+                return false;
+        }
+        for (size_t i = 0; i < DESCRIPTORS; i++) {
+                if (fields[2] != descriptors[i].name) {
+                        continue;
+                }
+                Distribution &x = distributions(code)[i];
+                if (fields[0] == "sketch") {
+                        return x.sketch.read(fields, 3);
+                }
+                return fields[0] == "histogram" && fields.size() == 4 &&
+                       x.histogram.read(fields[3]);
+        }
+        return false;
+}
+
+
+void Descriptor_statistics::print_quantiles(ostream &out) const
+{
+        out << "DISTRIBUTIONS OF DESCRIPTORS\n-------\n";
+        char cell[32];
+        bool first = true;
+        for (const auto &conf : conformations) {
+                const vector<Distribution> &x = table[conf.second];
+                if (conf.second == unanalysed || x.empty()) {
+                        continue;
+                }
+                if (!first) {
+                        out << '\n';
+                }
+                first = false;
+
+                out << conf.first << " (" << x[0].sketch.get_count()
+                    << " rings)\n" << setw(NAME_WIDTH) << left << "";
+                for (const char *name : rank_names) {
+                        out << setw(VALUE_WIDTH) << right << name;
+                }
+                out << '\n';
+                for (size_t i = 0; i < DESCRIPTORS; i++) {
+                        out << setw(NAME_WIDTH) << left << descriptors[i].name;
+                        for (double rank : ranks) {
+                                snprintf(cell, sizeof(cell), "%.4f",
+                                         x[i].sketch.quantile(rank));
+                                out << setw(VALUE_WIDTH) << right << cell;
+                        }
+                        out << '\n';
+                }
+        }
+}
+
+
+void Descriptor_statistics::print_histograms(ostream &out) const
+{
+        out << "HISTOGRAMS OF DESCRIPTORS\n-------\n";
+        char cell[64];
+        bool first = true;
+        for (const auto &conf : conformations) {
+                const vector<Distribution> &x = table[conf.second];
+                if (conf.second == unanalysed || x.empty()) {
+                        continue;
+                }
+                for (size_t i = 0; i < DESCRIPTORS; i++) {
+                        if (!first) {
+                                out << '\n';
+                        }
+                        first = false;
+
+                        out << conf.first << ", " << descriptors[i].name << '\n';
+                        const Histogram &h = x[i].histogram;
+                        const vector<size_t> &counts = h.get_counts();
+                        for (size_t b = 0; b < counts.size(); b++) {
+                                if (b == 0) {
+                                        snprintf(cell, sizeof(cell),
+                                                 "%9s < %-9.4f", "",
+                                                 h.edge(1));
+                                } else if (b + 1 == counts.size()) {
+                                        snprintf(cell, sizeof(cell),
+                                                 "%9.4f <= %-8s", h.edge(b),
+                                                 "");
+                                } else {
+                                        snprintf(cell, sizeof(cell),
+                                                 "%9.4f - %-9.4f", h.edge(b),
+                                                 h.edge(b + 1));
+                                }
+                                out << "  " << cell << setw(VALUE_WIDTH)
+                                    << right << counts[b] << '\n';
+                        }
+                }
+        }
+}
@@ -0,0 +1,60 @@
+#ifndef DESCRIPTOR_STATISTICS_H
+#define DESCRIPTOR_STATISTICS_H
+
+#include "molecule.h"
+#include "quantile_sketch.h"
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/* Number of summarized descriptors (plane_distance, right_distance,
+   left_distance, dihedral, puckering_amplitude) */
+#define DESCRIPTORS 5
+
+/*
+ * Distributions of geometric descriptors of rings per conformation, each
+ * of them summarized by quantile sketch and histogram. Rings are added as
+ * they are analysed, so memory does not depend on their number. The state
+ * is kept in partial results and checkpoints as lines
+ *
+ *   statistics <stream>
+ *   sketch     <code> <descriptor> <sketch fields...>
+ *   histogram  <code> <descriptor> <counts>
+ *
+ * and the statistics of parts of a run are merged.
+ */
+class Descriptor_statistics
+{
+        public:
+                Descriptor_statistics(
+                                const std::map<std::string, short> &_conformations =
+                                        std::map<std::string, short>(),
+                                uint64_t _stream = 0);
+                void add(const Ring_result &ring);
+                void merge(const Descriptor_statistics &other);
+                /* Lines of sketches and histograms of all the distributions */
+                void write(std::ostream &out) const;
+                /* Restore stream or distribution from fields of its line,
+                   false if the line is damaged */
+                bool read(const std::vector<std::string> &fields);
+                /* Table of quantiles of descriptors per conformation */
+                void print_quantiles(std::ostream &out) const;
+                /* Histograms of descriptors per conformation */
+                void print_histograms(std::ostream &out) const;
+        private:
+                struct Distribution
+                {
+                        Quantile_sketch sketch;
+                        Histogram histogram;
+                };
+                std::vector<Distribution> &distributions(short conformation);
+                std::map<std::string, short> conformations;
+                uint64_t stream;
+                short unanalysed;
+                /* DESCRIPTORS distributions of every conformation (by
+                   code), empty for conformations without rings */
+                std::vector<std::vector<Distribution>> table;
+};
+
+#endif
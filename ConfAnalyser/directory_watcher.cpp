@@ -0,0 +1,177 @@
+#include "directory_watcher.h"
+#include "output_sink.h"
+#include <cerrno>
+#include <dirent.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+#define FILE_EVENTS (IN_CLOSE_WRITE | IN_MOVED_TO)
+#define DIRECTORY_EVENTS (IN_CREATE | IN_MOVED_TO)
+
+
+Directory_watcher::Directory_watcher()
+{
+        fd = -1;
+        error = false;
+        has_wait_mask = false;
+        sigemptyset(&wait_mask);
+}
+
+
+Directory_watcher::~Directory_watcher()
+{
+        if (fd != -1) {
+                close(fd);
+        }
+}
+
+
+bool Directory_watcher::open(const string &directory)
+{
+        fd = inotify_init1(IN_CLOEXEC);
+        if (fd == -1) {
+                diagnostics() << "Could not watch directory " << directory << "...\n";
+                error = true;
+                return false;
+        }
+
+        /* files present before the start are not reported */
+        if (!add_directory(directory, false)) {
+                error = true;
+                return false;
+        }
+
+        return true;
+}
+
+
+bool Directory_watcher::add_directory(const string &directory,
+                                      bool report_files)
+{
+        int wd = inotify_add_watch(fd, directory.c_str(),
+                                   FILE_EVENTS | DIRECTORY_EVENTS | IN_ONLYDIR);
+        if (wd == -1) {
+                diagnostics() << "Could not watch directory " << directory << "...\n";
+                return false;
+        }
+        directories[wd] = directory;
+
+        /* subdirectories are walked only once, when they appear */
+        DIR *dir = opendir(directory.c_str());
+        if (dir == nullptr) {
+                return true;
+        }
+        struct dirent *entry;
+        while ((entry = readdir(dir)) != nullptr) {
+                if (entry->d_name[0] == '.') {
+                        continue;
+                }
+                string path = directory + "/" + entry->d_name;
+                /* some file systems do not fill the type in */
+                unsigned char type = entry->d_type;
+                struct stat info;
+                if (type == DT_UNKNOWN && lstat(path.c_str(), &info) == 0) {
+                        type = S_ISDIR(info.st_mode) ? DT_DIR :
+                               S_ISREG(info.st_mode) ? DT_REG : DT_UNKNOWN;
+                }
+                if (type == DT_DIR) {
+                        add_directory(path, report_files);
+                } else if (report_files && type == DT_REG) {
+                        pending.push_back(path);
+                }
+        }
+        closedir(dir);
+
+        return true;
+}
+
+
+void Directory_watcher::set_wait_mask(const sigset_t &mask)
+{
+        wait_mask = mask;
+        has_wait_mask = true;
+}
+
+
+bool Directory_watcher::read_events()
+{
+        alignas(struct inotify_event) char buffer[65536];
+        ssize_t size = read(fd, buffer, sizeof(buffer));
+        if (size <= 0) {
+                if (size < 0 && errno != EINTR) {
+                        error = true;
+                }
+                return false;
+        }
+
+        for (char *ptr = buffer; ptr < buffer + size;
+             ptr += sizeof(struct inotify_event) +
+                    reinterpret_cast<struct inotify_event*>(ptr)->len) {
+                const struct inotify_event *event =
+                                reinterpret_cast<struct inotify_event*>(ptr);
+                if (event->mask & IN_IGNORED) {
+                        directories.erase(event->wd);
+                        continue;
+                }
+                if (event->mask & IN_Q_OVERFLOW) {
+                        diagnostics() << "Too many changes at once, some files were not analysed!\n";
+                        continue;
+                }
+                if (event->len == 0 || event->name[0] == '.' ||
+                    directories.count(event->wd) == 0) {
+                        continue;
+                }
+
+                string path = directories[event->wd] + "/" + event->name;
+                if (event->mask & IN_ISDIR) {
+                        add_directory(path, true);
+                } else if (event->mask & FILE_EVENTS) {
+                        pending.push_back(path);
+                }
+        }
+
+        return true;
+}
+
+
+bool Directory_watcher::next(string &path)
+{
+        while (true) {
+                if (fd == -1 || error) {
+                        return false;
+                }
+                /* signals are unblocked only inside ppoll (atomically),
+                   which does not wait while files are pending */
+                if (has_wait_mask) {
+                        pollfd events = {fd, POLLIN, 0};
+                        timespec now = {0, 0};
+                        if (ppoll(&events, 1, pending.empty() ? nullptr : &now,
+                                  &wait_mask) < 0) {
+                                if (errno != EINTR) {
+                                        error = true;
+                                }
+                                return false;
+                        }
+                }
+                if (!pending.empty()) {
+                        break;
+                }
+                if (!read_events()) {
+                        return false;
+                }
+        }
+
+        path = pending.front();
+        pending.pop_front();
+        return true;
+}
+
+
+bool Directory_watcher::failed() const
+{
+        return error;
+}
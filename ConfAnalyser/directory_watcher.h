@@ -0,0 +1,43 @@
+#ifndef DIRECTORY_WATCHER_H
+#define DIRECTORY_WATCHER_H
+
+#include <csignal>
+#include <deque>
+#include <map>
+#include <string>
+
+/*
+ * Files written to a directory tree, reported by inotify as they are
+ * closed after writing or moved in, so that nothing has to be rescanned.
+ * Subdirectories created later are watched as well (files already present
+ * in them are reported once). Hidden files (temporary files of copying
+ * tools) are ignored.
+ */
+class Directory_watcher
+{
+        public:
+                Directory_watcher();
+                ~Directory_watcher();
+                bool open(const std::string &directory);
+                /* Signal mask while waiting for changes - signals blocked
+                   by the caller but not in the mask are delivered only
+                   during the wait, so none is lost before it */
+                void set_wait_mask(const sigset_t &mask);
+                /* Next written file, false when interrupted by a signal
+                   or in case of error (see failed()) */
+                bool next(std::string &path);
+                bool failed() const;
+        private:
+                bool add_directory(const std::string &directory,
+                                   bool report_files);
+                bool read_events();
+                int fd;
+                bool error;
+                bool has_wait_mask;
+                sigset_t wait_mask;
+                /* watched directories by their watch descriptors */
+                std::map<int, std::string> directories;
+                std::deque<std::string> pending;
+};
+
+#endif
@@ -1,11 +1,15 @@
 #include "five_atom_ring.h"
 #include "plane_3D.h"
+#include "angle.h"
 #include <cfloat>
 #include <cmath>
+#include <limits>
 
 using namespace std;
 
-Five_atom_ring::Five_atom_ring(string _structure) : Ring(_structure)
+Five_atom_ring::Five_atom_ring(string _structure,
+                               map<string, short> &_conformations)
+        : Ring(_structure, _conformations)
 {
         for (auto &x : C) {
                 x = nullptr;
@@ -16,17 +20,47 @@ Five_atom_ring::Five_atom_ring(string _structure) : Ring(_structure)
 Five_atom_ring::~Five_atom_ring() {}
 
 
-bool Five_atom_ring::find_plane(double tolerance, int dist1, int dist2, int dist3)
+size_t Five_atom_ring::size() const
+{
+        return 5;
+}
+
+
+Atom **Five_atom_ring::ring_atoms()
+{
+        return C;
+}
+
+
+bool Five_atom_ring::set_coordinates(const double *coordinates)
+{
+        for (int i = 0; i < 5; i++) {
+                delete(C[i]);
+                C[i] = new Atom();
+                C[i]->X = coordinates[3*i];
+                C[i]->Y = coordinates[3*i + 1];
+                C[i]->Z = coordinates[3*i + 2];
+        }
+        filled = true;
+
+        return filled;
+}
+
+
+template<typename T>
+bool Five_atom_ring::find_plane(const Point_3D_t<T> *P, T tolerance, int &begin,
+                               int dist1, int dist2, int dist3)
 {
         bool has_plane = false;
-        double distance = DBL_MAX;
+        T distance = numeric_limits<T>::max();
+        begin = 0;
         for (int i = 0; i < 5; i++) {
-                Plane_3D tmp(*(C[i%5]), *(C[(i+dist1)%5]), *(C[(i+dist2)%5]));
-                double _distance = abs(tmp.distance_from(*(C[(i+dist3)%5])));
+                Plane_3D_t<T> tmp(P[i%5], P[(i+dist1)%5], P[(i+dist2)%5]);
+                T _distance = abs(tmp.distance_from(P[(i+dist3)%5]));
                 if (_distance < distance) {
                         begin = i;
                         distance = _distance;
-                        if (tmp.is_on_plane(*(C[(i+dist3)%5]), tolerance)) {
+                        if (tmp.is_on_plane(P[(i+dist3)%5], tolerance)) {
                                 has_plane = true;
                         }
                 }
@@ -34,3 +68,49 @@ bool Five_atom_ring::find_plane(double tolerance, int dist1, int dist2, int dist
 
         return has_plane;
 }
+
+template bool Five_atom_ring::find_plane(const Point_3D_t<float> *P, float tolerance,
+                                        int &begin, int dist1, int dist2, int dist3);
+template bool Five_atom_ring::find_plane(const Point_3D_t<double> *P, double tolerance,
+                                        int &begin, int dist1, int dist2, int dist3);
+
+
+template<typename T>
+void Five_atom_ring::ring_points(const T *coordinates, Point_3D_t<T> *P)
+{
+        for (int i = 0; i < 5; i++) {
+                P[i] = Point_3D_t<T>(coordinates[3*i], coordinates[3*i + 1],
+                                     coordinates[3*i + 2]);
+        }
+}
+
+template void Five_atom_ring::ring_points(const float *coordinates, Point_3D_t<float> *P);
+template void Five_atom_ring::ring_points(const double *coordinates, Point_3D_t<double> *P);
+
+
+void Five_atom_ring::describe()
+{
+        /* search the best plane on its own */
+        int best = 0;
+        double distance = DBL_MAX;
+        for (int i = 0; i < 5; i++) {
+                Plane_3D tmp(*(C[i]), *(C[(i+1)%5]), *(C[(i+2)%5]));
+                double _distance = abs(tmp.distance_from(*(C[(i+3)%5])));
+                if (_distance < distance) {
+                        best = i;
+                        distance = _distance;
+                }
+        }
+
+        Plane_3D left_plane(*(C[best]), *(C[(best+1)%5]), *(C[(best+3)%5]));
+        Plane_3D right_plane(*(C[best]), *(C[(best+2)%5]), *(C[(best+3)%5]));
+        descriptors.plane_distance = distance;
+        descriptors.right_distance = right_plane.distance_from(*(C[(best+4)%5]));
+        descriptors.left_distance = left_plane.distance_from(*(C[(best+4)%5]));
+        descriptors.dihedral = dihedral_angle(*(C[best]), *(C[(best+1)%5]),
+                                              *(C[(best+2)%5]),
+                                              *(C[(best+3)%5]));
+
+        describe_puckering(C, 5);
+        describe_torsions();
+}
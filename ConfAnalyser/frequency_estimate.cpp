@@ -0,0 +1,132 @@
+#include "frequency_estimate.h"
+#include <cmath>
+#include <cstdio>
+
+using namespace std;
+
+/* Conformation of rings not analysed at all, not estimated */
+#define UNANALYSED "UNANALYSED"
+
+
+Frequency_estimate::Frequency_estimate()
+{
+        total = 0;
+        look = 0;
+        z = 0;
+}
+
+
+void Frequency_estimate::set_conformations(const map<string, short> &table)
+{
+        conformations = table;
+        conformations.erase(UNANALYSED);
+        counts.assign(table.size(), 0);
+        total = 0;
+        set_look(look);
+}
+
+
+void Frequency_estimate::set_look(size_t _look)
+{
+        look = _look;
+
+        /* P(|Z| > z) = erfc(z / sqrt(2)) is split among the conformations
+           and the looks, found by bisection */
+        double alpha = (1 - FREQUENCY_LEVEL) /
+                       max(conformations.size(), static_cast<size_t>(1));
+        if (look > 0) {
+                alpha *= 6 / (M_PI * M_PI * look * look);
+        }
+        double low = 0, high = 40;
+        for (int i = 0; i < 100; i++) {
+                z = (low + high) / 2;
+                if (erfc(z / sqrt(2.0)) > alpha) {
+                        low = z;
+                } else {
+                        high = z;
+                }
+        }
+}
+
+
+void Frequency_estimate::add(short conformation)
+{
+        if (conformation >= 0 &&
+            static_cast<size_t>(conformation) < counts.size()) {
+                counts[conformation]++;
+                total++;
+        }
+}
+
+
+size_t Frequency_estimate::get_total() const
+{
+        return total;
+}
+
+
+void Frequency_estimate::interval(short conformation, double &low,
+                                  double &high) const
+{
+        if (total == 0) {
+                low = 0;
+                high = 1;
+                return;
+        }
+
+        double n = total;
+        double p = counts[conformation] / n;
+        double denominator = 1 + z * z / n;
+        double center = (p + z * z / (2 * n)) / denominator;
+        double half = z / denominator *
+                      sqrt(p * (1 - p) / n + z * z / (4 * n * n));
+        low = max(center - half, 0.0);
+        high = min(center + half, 1.0);
+}
+
+
+double Frequency_estimate::max_width() const
+{
+        double width = 0;
+        for (const auto &x : conformations) {
+                double low, high;
+                interval(x.second, low, high);
+                width = max(width, high - low);
+        }
+        return width;
+}
+
+
+void Frequency_estimate::print(ostream &out) const
+{
+        vector<double> low(counts.size(), 0), high(counts.size(), 0);
+        for (const auto &x : conformations) {
+                interval(x.second, low[x.second], high[x.second]);
+        }
+        print_frequencies(out, conformations, counts, low, high);
+}
+
+
+void print_frequencies(ostream &out, const map<string, short> &conformations,
+                       const vector<size_t> &counts, const vector<double> &low,
+                       const vector<double> &high)
+{
+        size_t total = 0;
+        for (auto x : counts) {
+                total += x;
+        }
+
+        char buffer[128];
+        for (const auto &x : conformations) {
+                if (x.first == UNANALYSED ||
+                    static_cast<size_t>(x.second) >= counts.size()) {
+                        continue;
+                }
+                snprintf(buffer, sizeof(buffer), "%-14s%.4f (%.4f - %.4f)\n",
+                         (x.first + ": ").c_str(),
+                         total == 0 ? 0.0 :
+                         static_cast<double>(counts[x.second]) / total,
+                         low[x.second], high[x.second]);
+                out << buffer;
+        }
+}
@@ -0,0 +1,56 @@
+#ifndef FREQUENCY_ESTIMATE_H
+#define FREQUENCY_ESTIMATE_H
+
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/* Confidence level of the intervals */
+#define FREQUENCY_LEVEL 0.95
+
+/* Table of frequencies of conformations with their intervals (low and high
+   indexed by codes of conformations) */
+void print_frequencies(std::ostream &out,
+                       const std::map<std::string, short> &conformations,
+                       const std::vector<size_t> &counts,
+                       const std::vector<double> &low,
+                       const std::vector<double> &high);
+
+/*
+ * Running estimate of frequencies of conformations among sampled rings.
+ * Every conformation of the ring type gets Wilson score interval of its
+ * frequency, the level is Bonferroni corrected for the number of the
+ * conformations, so that all the intervals hold at once (multinomial).
+ * When the sample is looked at repeatedly to decide whether to stop, the
+ * error 1 - level is spent over the looks (6 / (pi k)^2 of it at k-th
+ * look), so that the intervals of all the looks hold at once and those
+ * of the look stopping the sample keep the level.
+ */
+class Frequency_estimate
+{
+        public:
+                Frequency_estimate();
+                void set_conformations(const std::map<std::string, short> &table);
+                /* Intervals of k-th look (from 1) at the sample, 0 for
+                   a sample of fixed size */
+                void set_look(size_t look);
+                void add(short conformation);
+                size_t get_total() const;
+                /* Interval of frequency of the conformation (code) */
+                void interval(short conformation, double &low,
+                              double &high) const;
+                /* Width of the widest interval, 1 if nothing was added */
+                double max_width() const;
+                /* Table of frequencies and their intervals */
+                void print(std::ostream &out) const;
+        private:
+                std::map<std::string, short> conformations;
+                std::vector<size_t> counts;
+                size_t total;
+                size_t look;
+                /* Quantile of standard normal distribution of the level */
+                double z;
+};
+
+#endif
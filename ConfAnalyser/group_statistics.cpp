@@ -0,0 +1,229 @@
+#include "group_statistics.h"
+#include <algorithm>
+#include <cstdio>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+
+using namespace std;
+
+/* separator of fields in keys of groups */
+#define KEY_SEPARATOR '\t'
+/* width of interval of frequency in the table (0.000-0.000) */
+#define INTERVAL_WIDTH static_cast<size_t>(11)
+
+
+Group_statistics::Group_statistics(int _fields,
+                                   const map<string, short> &_conformations)
+        : conformations(_conformations)
+{
+        fields = _fields;
+}
+
+
+int Group_statistics::fields_from_names(const string &names)
+{
+        int result = 0;
+        string name;
+        istringstream ss(names);
+        while (getline(ss, name, ',')) {
+                if (name == "ligand") {
+                        result |= GROUP_LIGAND;
+                } else if (name == "chain") {
+                        result |= GROUP_CHAIN;
+                } else if (name == "entry") {
+                        result |= GROUP_ENTRY;
+                } else {
+                        return 0;
+                }
+        }
+        return result;
+}
+
+
+string Group_statistics::key(const Ring_result &ring) const
+{
+        string result;
+        if (fields & GROUP_LIGAND) {
+                size_t first = ring.ligand.find_first_not_of(' ');
+                size_t last = ring.ligand.find_last_not_of(' ');
+                result += (first == string::npos) ? "" :
+                          ring.ligand.substr(first, last - first + 1);
+                result += KEY_SEPARATOR;
+        }
+        if (fields & GROUP_CHAIN) {
+                result += ring.chain_id;
+                result += KEY_SEPARATOR;
+        }
+        if (fields & GROUP_ENTRY) {
+                /* file name without directories and extensions */
+                size_t sep = ring.structure.find_last_of("/");
+                string entry = (sep == string::npos) ? ring.structure :
+                               ring.structure.substr(sep + 1);
+                result += entry.substr(0, entry.find('.'));
+                result += KEY_SEPARATOR;
+        }
+        return result;
+}
+
+
+void Group_statistics::add(const Ring_result &ring)
+{
+        vector<size_t> &counts = groups[key(ring)];
+        if (counts.empty()) {
+                counts.resize(conformations.size(), 0);
+        }
+        if (static_cast<size_t>(ring.conformation) < counts.size()) {
+                counts[ring.conformation]++;
+        }
+}
+
+
+void Group_statistics::merge(const Group_statistics &other)
+{
+        for (const auto &x : other.groups) {
+                vector<size_t> &counts = groups[x.first];
+                if (counts.empty()) {
+                        counts = x.second;
+                        continue;
+                }
+                for (size_t i = 0; i < counts.size(); i++) {
+                        counts[i] += x.second[i];
+                }
+        }
+}
+
+
+void Group_statistics::add_all(const vector<Ring_result> &rings,
+                               size_t threads)
+{
+        if (threads <= 1 || rings.size() < threads) {
+                for (const auto &x : rings) {
+                        add(x);
+                }
+                return;
+        }
+
+        /* each thread aggregates its own batch without locking */
+        vector<Group_statistics> partial(threads,
+                                         Group_statistics(fields, conformations));
+        vector<thread> workers;
+        size_t batch = (rings.size() + threads - 1) / threads;
+        for (size_t i = 0; i < threads; i++) {
+                workers.emplace_back([&, i]{
+                        size_t end = min(rings.size(), (i + 1) * batch);
+                        for (size_t j = i * batch; j < end; j++) {
+                                partial[i].add(rings[j]);
+                        }
+                });
+        }
+        for (auto &x : workers) {
+                x.join();
+        }
+        for (const auto &x : partial) {
+                merge(x);
+        }
+}
+
+
+void Group_statistics::print(ostream &out, const Bootstrap *bootstrap) const
+{
+        vector<string> headers;
+        if (fields & GROUP_LIGAND) {
+                headers.push_back("LIGAND");
+        }
+        if (fields & GROUP_CHAIN) {
+                headers.push_back("CHAIN");
+        }
+        if (fields & GROUP_ENTRY) {
+                headers.push_back("ENTRY");
+        }
+
+        /* groups are printed sorted, widths fit the longest values */
+        vector<pair<string, const vector<size_t>*>> sorted;
+        for (const auto &x : groups) {
+                sorted.push_back(make_pair(x.first, &x.second));
+        }
+        sort(sorted.begin(), sorted.end());
+
+        vector<size_t> widths;
+        for (const auto &x : headers) {
+                widths.push_back(x.size() + 2);
+        }
+        for (const auto &x : sorted) {
+                istringstream ss(x.first);
+                string value;
+                for (size_t i = 0; getline(ss, value, KEY_SEPARATOR); i++) {
+                        widths[i] = max(widths[i], value.size() + 2);
+                }
+        }
+
+        string title = "BY";
+        for (const auto &x : headers) {
+                title += " " + x;
+        }
+        out << title << '\n' << string(title.size(), '-') << '\n';
+
+        for (size_t i = 0; i < headers.size(); i++) {
+                out << setw(widths[i]) << left << headers[i];
+        }
+        for (const auto &conf : conformations) {
+                out << setw(conf.first.size() + 2) << right << conf.first;
+        }
+        out << setw(10) << right << "TOTAL" << '\n';
+
+        for (const auto &x : sorted) {
+                istringstream ss(x.first);
+                string value;
+                for (size_t i = 0; getline(ss, value, KEY_SEPARATOR); i++) {
+                        out << setw(widths[i]) << left << value;
+                }
+                size_t total = 0;
+                for (const auto &conf : conformations) {
+                        size_t count = (*x.second)[conf.second];
+                        total += count;
+                        out << setw(conf.first.size() + 2) << right << count;
+                }
+                out << setw(10) << right << total << '\n';
+        }
+
+        if (bootstrap == nullptr) {
+                return;
+        }
+
+        /* intervals of all the groups are resampled at once */
+        vector<vector<size_t>> counts;
+        for (const auto &x : sorted) {
+                counts.push_back(*x.second);
+        }
+        vector<vector<double>> low, high;
+        bootstrap->intervals(counts, low, high);
+
+        out << '\n' << title << ", INTERVALS OF FREQUENCIES (95% bootstrap, "
+            << bootstrap->get_resamples() << " resamples)\n"
+            << string(title.size(), '-') << '\n';
+        for (size_t i = 0; i < headers.size(); i++) {
+                out << setw(widths[i]) << left << headers[i];
+        }
+        for (const auto &conf : conformations) {
+                out << setw(max(conf.first.size(), INTERVAL_WIDTH) + 2)
+                    << right << conf.first;
+        }
+        out << '\n';
+
+        char cell[32];
+        for (size_t g = 0; g < sorted.size(); g++) {
+                istringstream ss(sorted[g].first);
+                string value;
+                for (size_t i = 0; getline(ss, value, KEY_SEPARATOR); i++) {
+                        out << setw(widths[i]) << left << value;
+                }
+                for (const auto &conf : conformations) {
+                        snprintf(cell, sizeof(cell), "%.3f-%.3f",
+                                 low[g][conf.second], high[g][conf.second]);
+                        out << setw(max(conf.first.size(), INTERVAL_WIDTH) + 2)
+                            << right << cell;
+                }
+                out << '\n';
+        }
+}
@@ -0,0 +1,45 @@
+#ifndef GROUP_STATISTICS_H
+#define GROUP_STATISTICS_H
+
+#include "molecule.h"
+#include "bootstrap.h"
+#include <map>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/* Fields the rings can be grouped by (combined by |) */
+#define GROUP_LIGAND  1
+#define GROUP_CHAIN   2
+#define GROUP_ENTRY   4
+
+/*
+ * Counts of conformations per group of rings (ligand, chain of the
+ * structure, entry). Batches of rings are aggregated to separate hash
+ * maps in parallel, which are merged at the end.
+ */
+class Group_statistics
+{
+        public:
+                Group_statistics(int _fields,
+                                 const std::map<std::string, short> &_conformations);
+                /* Fields given as comma separated names, 0 if not known */
+                static int fields_from_names(const std::string &names);
+                void add(const Ring_result &ring);
+                void merge(const Group_statistics &other);
+                /* Aggregate rings by given number of threads */
+                void add_all(const std::vector<Ring_result> &rings,
+                             size_t threads);
+                /* Group x conformation frequency table, followed by table
+                   of intervals of the frequencies if bootstrap is given */
+                void print(std::ostream &out,
+                           const Bootstrap *bootstrap = nullptr) const;
+        private:
+                std::string key(const Ring_result &ring) const;
+                int fields;
+                std::map<std::string, short> conformations;
+                std::unordered_map<std::string, std::vector<size_t>> groups;
+};
+
+#endif
@@ -1,10 +1,21 @@
 #ifndef HELPER_FUNCTIONS_H
 #define HELPER_FUNCTIONS_H
 
+#include <cstdint>
 #include <string>
 
 std::string rstrip(const std::string s);
 std::string lstrip(const std::string s);
 std::string strip(const std::string s);
 
+/* SplitMix64 of the position in the stream, every value depends only on
+   the seed and its position, so that batches are filled independently */
+inline uint64_t random_value(uint64_t x)
+{
+        x += 0x9e3779b97f4a7c15ULL;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+}
+
 #endif
@@ -0,0 +1,122 @@
+#include "instrumentation.h"
+#include <atomic>
+#include <iomanip>
+#include <sstream>
+#include <time.h>
+
+using namespace std;
+
+static const char *stage_names[STAGE_COUNT] = {
+        "names", "open", "read", "parse", "match", "analyse", "confidence", "output"
+};
+
+static const char *counter_names[COUNTER_COUNT] = {
+        "files", "analysed", "not_found", "filtered", "unknown_ligand", "missing_atoms",
+        "duplicate_atoms", "other_failure", "precision", "bytes", "atoms"
+};
+
+/* Totals shared by all threads */
+static atomic<uint64_t> stage_wall[STAGE_COUNT];
+static atomic<uint64_t> stage_cpu[STAGE_COUNT];
+static atomic<uint64_t> stage_calls[STAGE_COUNT];
+static atomic<uint64_t> counters[COUNTER_COUNT];
+
+
+#ifdef CONF_INSTRUMENTATION
+
+static uint64_t now_ns(clockid_t clock)
+{
+        struct timespec ts;
+        clock_gettime(clock, &ts);
+        return static_cast<uint64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+
+Stage_timer::Stage_timer(Stage _stage)
+{
+        stage = _stage;
+        wall_start = now_ns(CLOCK_MONOTONIC);
+        cpu_start = now_ns(CLOCK_THREAD_CPUTIME_ID);
+}
+
+
+Stage_timer::~Stage_timer()
+{
+        Instrumentation::add_time(stage, now_ns(CLOCK_MONOTONIC) - wall_start,
+                                  now_ns(CLOCK_THREAD_CPUTIME_ID) - cpu_start);
+}
+
+#endif
+
+
+bool Instrumentation::enabled()
+{
+#ifdef CONF_INSTRUMENTATION
+        return true;
+#else
+        return false;
+#endif
+}
+
+
+void Instrumentation::add_time(Stage stage, uint64_t wall_ns, uint64_t cpu_ns)
+{
+        stage_wall[stage].fetch_add(wall_ns, memory_order_relaxed);
+        stage_cpu[stage].fetch_add(cpu_ns, memory_order_relaxed);
+        stage_calls[stage].fetch_add(1, memory_order_relaxed);
+}
+
+
+void Instrumentation::count(Counter counter, uint64_t n)
+{
+        counters[counter].fetch_add(n, memory_order_relaxed);
+}
+
+
+uint64_t Instrumentation::get(Counter counter)
+{
+        return counters[counter].load(memory_order_relaxed);
+}
+
+
+void Instrumentation::report(ostream &out)
+{
+        /* formatted aside, so that the flags of out are kept */
+        ostringstream table;
+        table << "PROFILE\n-------\n"
+              << setw(10) << left << "STAGE"
+              << setw(14) << right << "WALL [s]"
+              << setw(14) << right << "CPU [s]"
+              << setw(12) << right << "CALLS" << '\n';
+        for (int i = 0; i < STAGE_COUNT; i++) {
+                table << setw(10) << left << stage_names[i]
+                      << setw(14) << right << fixed << setprecision(6)
+                      << stage_wall[i] / 1e9
+                      << setw(14) << right << stage_cpu[i] / 1e9
+                      << setw(12) << right << stage_calls[i] << '\n';
+        }
+        table << '\n';
+        for (int i = 0; i < COUNTER_COUNT; i++) {
+                table << setw(18) << left << string(counter_names[i]) + ": "
+                      << counters[i] << '\n';
+        }
+        out << table.str();
+}
+
+
+void Instrumentation::report_json(ostream &out)
+{
+        out << "{\"stages\":{";
+        for (int i = 0; i < STAGE_COUNT; i++) {
+                out << (i == 0 ? "" : ",") << '"' << stage_names[i]
+                    << "\":{\"wall_ns\":" << stage_wall[i]
+                    << ",\"cpu_ns\":" << stage_cpu[i]
+                    << ",\"calls\":" << stage_calls[i] << '}';
+        }
+        out << "},\"counters\":{";
+        for (int i = 0; i < COUNTER_COUNT; i++) {
+                out << (i == 0 ? "" : ",") << '"' << counter_names[i]
+                    << "\":" << counters[i];
+        }
+        out << "}}\n";
+}
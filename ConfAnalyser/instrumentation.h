@@ -0,0 +1,82 @@
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+
+#include <cstdint>
+#include <ostream>
+
+/*
+ * Per-stage timers and counters of the analysis. They are compiled in only
+ * with CONF_INSTRUMENTATION defined (make profile), otherwise STAGE_TIMER
+ * and COUNT expand to nothing and cost nothing.
+ */
+
+/* Measured stages */
+enum Stage {
+        STAGE_NAMES,            /* reading list of atom names */
+        STAGE_OPEN,             /* opening PDB files */
+        STAGE_READ,             /* reading PDB files to memory */
+        STAGE_PARSE,            /* parsing ATOM/HETATM records */
+        STAGE_MATCH,            /* matching ring atoms by names */
+        STAGE_ANALYSE,          /* recognizing conformations */
+        STAGE_CONFIDENCE,       /* Monte Carlo confidence of conformations */
+        STAGE_OUTPUT,           /* writing results */
+        STAGE_COUNT
+};
+
+/* Counted events */
+enum Counter {
+        COUNTER_FILES,                  /* files from the input list */
+        COUNTER_ANALYSED,               /* files analysed successfully */
+        COUNTER_NOT_FOUND,              /* files that could not be opened */
+        COUNTER_FILTERED,               /* files rejected by their headers */
+        COUNTER_UNKNOWN_LIGAND,         /* ligand not in atom names list */
+        COUNTER_MISSING_ATOMS,          /* not all ring atoms found */
+        COUNTER_DUPLICATE_ATOMS,        /* ring atom found twice */
+        COUNTER_OTHER_FAILURE,          /* any other reason of omission */
+        COUNTER_PRECISION,              /* rings differing in float32/double */
+        COUNTER_BYTES,                  /* bytes read from PDB files */
+        COUNTER_ATOMS,                  /* parsed ATOM/HETATM records */
+        COUNTER_COUNT
+};
+
+class Instrumentation
+{
+        public:
+                /* Is the instrumentation compiled in? */
+                static bool enabled();
+                static void add_time(Stage stage, uint64_t wall_ns,
+                                     uint64_t cpu_ns);
+                static void count(Counter counter, uint64_t n = 1);
+                static uint64_t get(Counter counter);
+                /* Human-readable table or single JSON object */
+                static void report(std::ostream &out);
+                static void report_json(std::ostream &out);
+};
+
+#ifdef CONF_INSTRUMENTATION
+
+/* Measures wall and CPU time of its own scope */
+class Stage_timer
+{
+        public:
+                Stage_timer(Stage _stage);
+                ~Stage_timer();
+        private:
+                Stage stage;
+                uint64_t wall_start;
+                uint64_t cpu_start;
+};
+
+#define STAGE_TIMER_NAME(line) stage_timer_ ## line
+#define STAGE_TIMER_LINE(stage, line) Stage_timer STAGE_TIMER_NAME(line)(stage)
+#define STAGE_TIMER(stage) STAGE_TIMER_LINE(stage, __LINE__)
+#define COUNT(counter, n) Instrumentation::count(counter, n)
+
+#else
+
+#define STAGE_TIMER(stage)
+#define COUNT(counter, n)
+
+#endif
+
+#endif
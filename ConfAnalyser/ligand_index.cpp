@@ -0,0 +1,240 @@
+#include "ligand_index.h"
+#include "conf_analyser.h"
+#include "output_sink.h"
+#include "structure_header.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <sstream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+#define INDEX_MAGIC "CONFIDX2"
+/* Magic of indices without the header records */
+#define OLD_INDEX_MAGIC "CONFIDX1"
+
+
+/* Residue name of ATOM/HETATM/ANISOU record, empty for other records */
+static string record_residue(const char *line, size_t length)
+{
+        if (length < 20 || (memcmp(line, "ATOM  ", 6) != 0 &&
+                            memcmp(line, "HETATM", 6) != 0 &&
+                            memcmp(line, "ANISOU", 6) != 0)) {
+                return "";
+        }
+        string residue(line + 17, 3);
+        size_t first = residue.find_first_not_of(' ');
+        if (first == string::npos) {
+                return "";
+        }
+        size_t last = residue.find_last_not_of(' ');
+        return residue.substr(first, last - first + 1);
+}
+
+
+void Ligand_index::scan(const string &file_name, const string &content,
+                        vector<Ligand_index_entry> &entries)
+{
+        /* entries of this file by ligand, in order of first occurrence */
+        map<string, size_t> found;
+        const char *data = content.data();
+        const char *end = data + content.size();
+        const char *line = data;
+        string block_residue;
+        size_t block_start = 0;
+        /* records of the title section read by header filters come first
+           in every entry of the file */
+        vector<pair<size_t, size_t>> header_ranges;
+        bool title = true;
+
+        while (true) {
+                const char *eol = (line < end) ? static_cast<const char*>(
+                                        memchr(line, '\n', end - line)) : nullptr;
+                const char *next = (eol == nullptr) ? end : eol + 1;
+                string residue = (line < end) ? record_residue(line, next - line) : "";
+
+                /* block of records of one residue ends */
+                if (residue != block_residue || line >= end) {
+                        if (!block_residue.empty()) {
+                                auto itr = found.find(block_residue);
+                                if (itr == found.end()) {
+                                        itr = found.insert(make_pair(block_residue, entries.size())).first;
+                                        entries.push_back(Ligand_index_entry{
+                                                block_residue, file_name,
+                                                content.size(), header_ranges});
+                                }
+                                entries[itr->second].ranges.push_back(make_pair(
+                                        block_start, (line - data) - block_start));
+                        }
+                        block_residue = residue;
+                        block_start = line - data;
+                }
+
+                if (line >= end) {
+                        break;
+                }
+                title = title && !Structure_header::is_coordinate_record(
+                                                line, next - line);
+                if (title && Structure_header::is_header_record(line, next - line)) {
+                        size_t offset = line - data;
+                        if (!header_ranges.empty() &&
+                            header_ranges.back().first + header_ranges.back().second == offset) {
+                                header_ranges.back().second += next - line;
+                        } else {
+                                header_ranges.push_back(make_pair(offset, next - line));
+                        }
+                }
+                line = next;
+        }
+}
+
+
+bool Ligand_index::write(vector<Ligand_index_entry> &entries, ostream &out)
+{
+        stable_sort(entries.begin(), entries.end(),
+                    [](const Ligand_index_entry &a, const Ligand_index_entry &b) {
+                return a.ligand < b.ligand;
+        });
+
+        out << INDEX_MAGIC << '\n';
+        for (const auto &x : entries) {
+                out << x.ligand << '\t' << x.file_name << '\t' << x.file_size << '\t';
+                for (size_t i = 0; i < x.ranges.size(); i++) {
+                        out << (i == 0 ? "" : ",") << x.ranges[i].first << '+'
+                            << x.ranges[i].second;
+                }
+                out << '\n';
+        }
+
+        return !out.fail();
+}
+
+
+bool Ligand_index::load(const string &index_file, const set<string> &ligands)
+{
+        ifstream f(index_file);
+        if (!f.is_open()) {
+                diagnostics() << "Error while opening file " << index_file << '\n';
+                return false;
+        }
+
+        string line;
+        if (getline(f, line) && line == OLD_INDEX_MAGIC) {
+                diagnostics() << index_file << ": ligand index without header records, build it again!\n";
+                return false;
+        }
+        if (f.fail() || line != INDEX_MAGIC) {
+                diagnostics() << index_file << ": not a ligand index!\n";
+                return false;
+        }
+
+        entries.clear();
+        size_t line_number = 1;
+        while (getline(f, line)) {
+                line_number++;
+                size_t tab = line.find('\t');
+                if (tab == string::npos) {
+                        diagnostics() << index_file << ": Wrong syntax on line nr. " << line_number << "...\n";
+                        return false;
+                }
+
+                /* only lines of wanted ligands are parsed further */
+                string ligand = line.substr(0, tab);
+                if (!ligands.empty() && ligands.count(ligand) == 0) {
+                        continue;
+                }
+
+                size_t tab2 = line.find('\t', tab + 1);
+                size_t tab3 = (tab2 == string::npos) ? string::npos :
+                              line.find('\t', tab2 + 1);
+                if (tab3 == string::npos) {
+                        diagnostics() << index_file << ": Wrong syntax on line nr. " << line_number << "...\n";
+                        return false;
+                }
+                Ligand_index_entry entry;
+                entry.ligand = ligand;
+                entry.file_name = line.substr(tab + 1, tab2 - tab - 1);
+                entry.file_size = strtoul(line.c_str() + tab2 + 1, nullptr, 10);
+
+                const char *ptr = line.c_str() + tab3 + 1;
+                while (*ptr != '\0') {
+                        char *end;
+                        size_t offset = strtoul(ptr, &end, 10);
+                        if (*end != '+') {
+                                break;
+                        }
+                        size_t length = strtoul(end + 1, &end, 10);
+                        entry.ranges.push_back(make_pair(offset, length));
+                        ptr = (*end == ',') ? end + 1 : end;
+                        if (*end != ',' && *end != '\0') {
+                                break;
+                        }
+                }
+                if (*ptr != '\0' || entry.ranges.empty()) {
+                        diagnostics() << index_file << ": Wrong syntax on line nr. " << line_number << "...\n";
+                        return false;
+                }
+                entries.push_back(entry);
+        }
+
+        return true;
+}
+
+
+const vector<Ligand_index_entry> &Ligand_index::get_entries() const
+{
+        return entries;
+}
+
+
+bool Ligand_index::read_records(const Ligand_index_entry &entry,
+                                string &content)
+{
+        int fd = open(entry.file_name.c_str(), O_RDONLY);
+        struct stat info;
+        if (fd == -1 || fstat(fd, &info) != 0) {
+                if (fd != -1) {
+                        close(fd);
+                }
+                return false;
+        }
+
+        /* changed file is read whole, the ranges are not valid anymore */
+        if (static_cast<size_t>(info.st_size) != entry.file_size) {
+                close(fd);
+                diagnostics() << entry.file_name << ": changed since indexing, reading whole file\n";
+                return Conf_analyser::read_file(entry.file_name, content);
+        }
+
+        size_t total = 0;
+        for (const auto &x : entry.ranges) {
+                total += x.second;
+        }
+        content.resize(total);
+
+        size_t position = 0;
+        bool success = true;
+        for (const auto &x : entry.ranges) {
+                size_t done = 0;
+                while (done < x.second) {
+                        ssize_t count = pread(fd, &content[position + done],
+                                              x.second - done, x.first + done);
+                        if (count <= 0) {
+                                success = false;
+                                break;
+                        }
+                        done += count;
+                }
+                if (!success) {
+                        break;
+                }
+                position += x.second;
+        }
+        close(fd);
+
+        return success;
+}
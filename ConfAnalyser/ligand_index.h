@@ -0,0 +1,57 @@
+#ifndef LIGAND_INDEX_H
+#define LIGAND_INDEX_H
+
+#include <map>
+#include <ostream>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+/* Records of one ligand in one file: byte ranges (offset, length) of the
+   header records of the file and of the blocks of ATOM/HETATM records of
+   the ligand */
+struct Ligand_index_entry
+{
+        std::string ligand;
+        std::string file_name;
+        size_t file_size;
+        std::vector<std::pair<size_t, size_t>> ranges;
+};
+
+/*
+ * Inverted index from residue names to the files containing them, built
+ * by a single scan of the input (ConfAnalyser index). Targeted runs read
+ * only the indexed records of the wanted ligands. The index is a text
+ * file sorted by ligand:
+ *
+ *   CONFIDX2
+ *   <ligand> <file> <file size> <offset>+<length>[,<offset>+<length>...]
+ *
+ * (fields separated by tabs). The ranges start with the records of the
+ * title section read by header filters (EXPDTA, REMARK 2 RESOLUTION,
+ * REVDAT 1), so that they work on the indexed records too.
+ */
+class Ligand_index
+{
+        public:
+                /* Blocks of records of all the residues of a PDB file */
+                static void scan(const std::string &file_name,
+                                 const std::string &content,
+                                 std::vector<Ligand_index_entry> &entries);
+                /* Write entries sorted by ligand (stable for the files) */
+                static bool write(std::vector<Ligand_index_entry> &entries,
+                                  std::ostream &out);
+                /* Entries of given ligands (all of them if empty) */
+                bool load(const std::string &index_file,
+                          const std::set<std::string> &ligands);
+                const std::vector<Ligand_index_entry> &get_entries() const;
+                /* Indexed records of the entry, whole file if it has been
+                   changed since indexing */
+                static bool read_records(const Ligand_index_entry &entry,
+                                         std::string &content);
+        private:
+                std::vector<Ligand_index_entry> entries;
+};
+
+#endif
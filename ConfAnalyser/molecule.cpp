@@ -3,17 +3,21 @@
 
 using namespace std;
 
-map<string, short> Molecule::conformations = {
-        {"UNANALYSED", 0},
-        {"UNDEFINIED", 1}
-};
+map<string, vector<vector<string>>> Molecule::atom_names;
 
-
-Molecule::Molecule(string _structure)
+Molecule::Molecule(string _structure, map<string, short> &_conformations)
+        : conformations(_conformations)
 {
         structure = _structure;
 	ligand = "";
-        conformation = conformations["UNANALYSED"];
+        chain_id = ' ';
+        residue_number = 0;
+        /* tables of conformations are shared by threads, they are only
+           looked up */
+        auto itr = conformations.find("UNANALYSED");
+        conformation = (itr == conformations.end()) ? 0 : itr->second;
+        descriptors = Ring_descriptors();
+        confidence = -1;
         filled = false;
         analysed = false;
 }
@@ -28,6 +32,33 @@ short Molecule::get_conformation() const
 }
 
 
+const Ring_descriptors &Molecule::get_descriptors() const
+{
+        return descriptors;
+}
+
+
+const map<string, short> &Molecule::get_conformations() const
+{
+        return conformations;
+}
+
+
+Ring_result Molecule::get_result() const
+{
+        Ring_result result;
+        result.structure = structure;
+        result.ligand = ligand;
+        result.chain_id = chain_id;
+        result.residue_number = residue_number;
+        result.conformation = conformation;
+        result.conformation_name = translate_conformation();
+        result.descriptors = descriptors;
+        result.confidence = confidence;
+        return result;
+}
+
+
 string Molecule::translate_conformation() const
 {
         for (auto conf : conformations) {
@@ -45,31 +76,47 @@ ostream& Molecule::print(ostream& out)
         size_t sep = structure.find_last_of("/");
         string tmp = (sep == string::npos) ? structure :
                 structure.substr(sep + 1, structure.size() - sep - 1);
-        return out << tmp << ": " << translate_conformation() << endl;
+        return out << tmp << ": " << translate_conformation() << '\n';
 }
 
 
-void Molecule::statistics(const std::vector<Molecule*> vec)
+void Molecule::statistics(const std::vector<Molecule*> vec, ostream &out)
 {
-        size_t sum = 0;
-        size_t *conf_num = new size_t[conformations.size()]();
+        if (vec.empty()) {
+                return;
+        }
+
+        /* all molecules in the list are of the same type */
+        const map<string, short> &conformations = vec.front()->conformations;
+        vector<size_t> counts(conformations.size(), 0);
 
 	for (auto x : vec) {
-	        sum++;
-                conf_num[x->get_conformation()]++;
+                counts[x->get_conformation()]++;
+        }
+
+        statistics(conformations, counts, out);
+}
+
+
+void Molecule::statistics(const map<string, short> &conformations,
+                          const vector<size_t> &counts, ostream &out)
+{
+        size_t sum = 0;
+        for (auto x : counts) {
+                sum += x;
         }
 
         for (auto conf : conformations) {
-                cout << setw(14) << left << string(conf.first)+": "
-                     << conf_num[conf.second]
+                size_t count = (static_cast<size_t>(conf.second) < counts.size()) ?
+                               counts[conf.second] : 0;
+                out << setw(14) << left << string(conf.first)+": "
+                     << count
                      << " ("
-                     << conf_num[conf.second] / (float)sum * 100
+                     << count / (float)sum * 100
                      << "%)"
-                     << endl;
+                     << '\n';
         }
-        cout << setw(14) << left << "TOTAL: " << sum << endl;
-
-        delete[] conf_num;
+        out << setw(14) << left << "TOTAL: " << sum << '\n';
 }
 
 
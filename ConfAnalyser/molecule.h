@@ -7,30 +7,84 @@
 #include <map>
 #include <string>
 
+/* Largest number of atoms of supported rings */
+#define MAX_RING_SIZE 6
+
+/* Geometric descriptors of the ring gathered during analysis */
+struct Ring_descriptors
+{
+        /* distance of the fourth atom from the best plane of the ring */
+        double plane_distance;
+        /* signed distances of the two remaining atoms from that plane */
+        double right_distance;
+        double left_distance;
+        /* torsion angle used to recognize twisted conformations */
+        double dihedral;
+        /* Cremer-Pople puckering parameters (amplitude in angstroms,
+           angles in degrees, theta is defined for six atom rings only) */
+        double puckering_amplitude;
+        double theta;
+        double phi;
+        /* endocyclic torsion angles in degrees, torsions[i] around the bond
+           of ring atoms i and i+1 (ring_size of them) */
+        size_t ring_size;
+        double torsions[MAX_RING_SIZE];
+};
+
+/* Result of analysis of a single ring, detached from the molecule */
+struct Ring_result
+{
+        std::string structure;
+        std::string ligand;
+        char chain_id;
+        int residue_number;
+        short conformation;
+        std::string conformation_name;
+        Ring_descriptors descriptors;
+        /* fraction of randomly perturbed copies of the ring keeping its
+           conformation, negative if not estimated */
+        double confidence = -1;
+};
+
 class Molecule
 {
         public:
                 Molecule() = delete;
-                Molecule(std::string _structure);
+                Molecule(std::string _structure,
+                         std::map<std::string, short> &_conformations);
                 virtual ~Molecule();
                 short get_conformation() const;
+                const Ring_descriptors &get_descriptors() const;
+                Ring_result get_result() const;
                 virtual std::string translate_conformation() const;
                 virtual std::ostream& print(std::ostream& out);
                 virtual bool initialize(const std::vector<Atom*> &atoms) = 0;
                 virtual bool analyse() = 0;
-                static void statistics(const std::vector<Molecule*> vec);
+                const std::map<std::string, short> &get_conformations() const;
+                static void statistics(const std::vector<Molecule*> vec,
+                                       std::ostream &out = std::cout);
+                /* Summary of counts of conformations indexed by their codes */
+                static void statistics(
+                                const std::map<std::string, short> &conformations,
+                                const std::vector<size_t> &counts,
+                                std::ostream &out = std::cout);
                 friend std::ostream& operator<<(std::ostream& out,
                                                         Molecule &mol);
                 /* List of names of ring atoms in given ligand */
                 static std::map<std::string,
                         std::vector<std::vector<std::string>>> atom_names;
         protected:
-                /* Possible conformations, molecule-specific */
-                static std::map<std::string, short> conformations;
+                /* Possible conformations, molecule-specific (each ring type
+                   owns its own table, so that more types can live together) */
+                std::map<std::string, short> &conformations;
                 /* Data members */
                 std::string structure;
 		std::string ligand;
+                char chain_id;
+                int residue_number;
                 short conformation;
+                Ring_descriptors descriptors;
+                double confidence;
                 bool filled;
                 bool analysed;
 };
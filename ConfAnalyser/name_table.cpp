@@ -0,0 +1,195 @@
+#include "name_table.h"
+#include "molecule.h"
+#include "output_sink.h"
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+#define NAME_TABLE_MAGIC "CONFNAM1"
+#define NAME_TABLE_MAGIC_SIZE 8
+
+
+struct Name_table_header
+{
+        char magic[NAME_TABLE_MAGIC_SIZE];
+        uint32_t ring_size;
+        uint32_t ligand_count;
+        uint32_t name_count;
+        uint32_t pool_size;
+};
+
+
+struct Name_table_ligand
+{
+        uint32_t name_offset;
+        uint32_t name_length;
+        uint32_t first_name;
+        uint32_t variants;
+};
+
+
+struct Name_table_name
+{
+        uint32_t offset;
+        uint32_t length;
+};
+
+
+bool is_name_table(const string &file_name)
+{
+        char magic[NAME_TABLE_MAGIC_SIZE];
+        int fd = open(file_name.c_str(), O_RDONLY);
+        if (fd == -1) {
+                return false;
+        }
+        bool result = read(fd, magic, sizeof(magic)) == sizeof(magic) &&
+                      memcmp(magic, NAME_TABLE_MAGIC, sizeof(magic)) == 0;
+        close(fd);
+
+        return result;
+}
+
+
+bool write_name_table(ostream &out, size_t ring_size)
+{
+        vector<Name_table_ligand> ligands;
+        vector<Name_table_name> names;
+        string pool;
+
+        /* std::map keeps the ligands sorted by name */
+        for (const auto &x : Molecule::atom_names) {
+                if (x.second.size() != ring_size) {
+                        continue;
+                }
+                Name_table_ligand ligand;
+                ligand.name_offset = pool.size();
+                ligand.name_length = x.first.size();
+                ligand.first_name = names.size();
+                ligand.variants = x.second[0].size();
+                pool += x.first;
+
+                /* text list keeps variants per atom, table per ligand */
+                for (size_t variant = 0; variant < ligand.variants; variant++) {
+                        for (size_t atom = 0; atom < ring_size; atom++) {
+                                const string &name = x.second[atom][variant];
+                                names.push_back(Name_table_name{
+                                        static_cast<uint32_t>(pool.size()),
+                                        static_cast<uint32_t>(name.size())});
+                                pool += name;
+                        }
+                }
+                ligands.push_back(ligand);
+        }
+
+        Name_table_header header;
+        memcpy(header.magic, NAME_TABLE_MAGIC, NAME_TABLE_MAGIC_SIZE);
+        header.ring_size = ring_size;
+        header.ligand_count = ligands.size();
+        header.name_count = names.size();
+        header.pool_size = pool.size();
+
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(ligands.data()),
+                  ligands.size() * sizeof(Name_table_ligand));
+        out.write(reinterpret_cast<const char*>(names.data()),
+                  names.size() * sizeof(Name_table_name));
+        out.write(pool.data(), pool.size());
+
+        return !out.fail();
+}
+
+
+bool load_name_table(const string &file_name, size_t ring_size)
+{
+        int fd = open(file_name.c_str(), O_RDONLY);
+        struct stat info;
+        if (fd == -1 || fstat(fd, &info) != 0) {
+                if (fd != -1) {
+                        close(fd);
+                }
+                diagnostics() << "Could not open file " << file_name << "..." << '\n';
+                return false;
+        }
+        size_t size = info.st_size;
+        void *mapping = (size == 0) ? MAP_FAILED :
+                        mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (mapping == MAP_FAILED) {
+                diagnostics() << "Could not open file " << file_name << "..." << '\n';
+                return false;
+        }
+
+        const char *data = static_cast<const char*>(mapping);
+        const Name_table_header *header =
+                        reinterpret_cast<const Name_table_header*>(data);
+        const Name_table_ligand *ligands =
+                        reinterpret_cast<const Name_table_ligand*>(header + 1);
+        const Name_table_name *names = nullptr;
+        const char *pool = nullptr;
+        bool valid = size >= sizeof(Name_table_header) &&
+                     memcmp(header->magic, NAME_TABLE_MAGIC, NAME_TABLE_MAGIC_SIZE) == 0;
+        if (valid) {
+                names = reinterpret_cast<const Name_table_name*>(
+                                ligands + header->ligand_count);
+                pool = reinterpret_cast<const char*>(names + header->name_count);
+                valid = sizeof(Name_table_header) +
+                        static_cast<uint64_t>(header->ligand_count) * sizeof(Name_table_ligand) +
+                        static_cast<uint64_t>(header->name_count) * sizeof(Name_table_name) +
+                        header->pool_size == size;
+        }
+        if (!valid) {
+                diagnostics() << file_name << ": damaged list of atom names!" << '\n';
+                munmap(mapping, size);
+                return false;
+        }
+
+        /* the same check of number of atoms as for the text list */
+        if (header->ring_size != ring_size) {
+                diagnostics() << file_name << ": Wrong number of atom names (expected "
+                              << ring_size << ", compiled for " << header->ring_size
+                              << ")..." << '\n';
+                munmap(mapping, size);
+                return false;
+        }
+
+        /* ligands are sorted, so each one is appended at the end */
+        for (uint32_t i = 0; i < header->ligand_count && valid; i++) {
+                const Name_table_ligand &ligand = ligands[i];
+                valid = static_cast<uint64_t>(ligand.name_offset) + ligand.name_length <= header->pool_size &&
+                        static_cast<uint64_t>(ligand.first_name) + static_cast<uint64_t>(ligand.variants) * ring_size <= header->name_count;
+                if (!valid) {
+                        break;
+                }
+                vector<vector<string>> &entry = Molecule::atom_names.emplace_hint(
+                                Molecule::atom_names.end(),
+                                string(pool + ligand.name_offset, ligand.name_length),
+                                vector<vector<string>>(ring_size))->second;
+                for (size_t atom = 0; atom < ring_size; atom++) {
+                        entry[atom].reserve(entry[atom].size() + ligand.variants);
+                }
+                for (uint32_t variant = 0; variant < ligand.variants && valid; variant++) {
+                        for (size_t atom = 0; atom < ring_size; atom++) {
+                                const Name_table_name &name =
+                                        names[ligand.first_name + variant * ring_size + atom];
+                                valid = static_cast<uint64_t>(name.offset) + name.length <= header->pool_size;
+                                if (!valid) {
+                                        break;
+                                }
+                                entry[atom].emplace_back(pool + name.offset, name.length);
+                        }
+                }
+        }
+        munmap(mapping, size);
+
+        if (!valid) {
+                diagnostics() << file_name << ": damaged list of atom names!" << '\n';
+                return false;
+        }
+
+        return true;
+}
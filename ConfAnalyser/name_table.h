@@ -0,0 +1,31 @@
+#ifndef NAME_TABLE_H
+#define NAME_TABLE_H
+
+#include <ostream>
+#include <string>
+
+/*
+ * Compiled list of atom names (ConfAnalyser compile-names), loaded by
+ * mapping the file to memory instead of parsing the text list. All the
+ * numbers are u32 in native byte order:
+ *
+ *   "CONFNAM1"                                     magic
+ *   ring size, ligand count, name count, pool size
+ *   ligands sorted by name:
+ *      name offset, name length, first name, variant count
+ *   names (variant by variant, ring size names each):
+ *      offset, length
+ *   pool of characters of all the names
+ */
+
+/* True if the file starts as a compiled name table */
+bool is_name_table(const std::string &file_name);
+
+/* Write Molecule::atom_names of rings of given size */
+bool write_name_table(std::ostream &out, size_t ring_size);
+
+/* Fill Molecule::atom_names from the compiled table, which has to be
+   compiled for rings of given size */
+bool load_name_table(const std::string &file_name, size_t ring_size);
+
+#endif
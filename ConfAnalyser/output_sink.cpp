@@ -0,0 +1,137 @@
+#include "output_sink.h"
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace std;
+
+static ostream *diagnostics_stream = &cerr;
+/* redirection of diagnostics of the current thread only */
+static thread_local ostream *thread_diagnostics_stream = nullptr;
+
+
+Output_sink::Output_sink(int _fd, size_t capacity) : buffer(capacity)
+{
+        fd = _fd;
+        owned = false;
+        failed = false;
+        setp(buffer.data(), buffer.data() + buffer.size());
+}
+
+
+Output_sink::~Output_sink()
+{
+        flush();
+        if (owned) {
+                close(fd);
+        }
+}
+
+
+bool Output_sink::open(const string &file_name)
+{
+        int new_fd = ::open(file_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC,
+                            0644);
+        if (new_fd == -1) {
+                return false;
+        }
+
+        flush();
+        if (owned) {
+                close(fd);
+        }
+        fd = new_fd;
+        owned = true;
+        failed = false;
+
+        return true;
+}
+
+
+bool Output_sink::flush()
+{
+        const char *data = pbase();
+        size_t size = pptr() - pbase();
+        while (size > 0 && !failed) {
+                ssize_t written = write(fd, data, size);
+                if (written < 0) {
+                        if (errno == EINTR) {
+                                continue;
+                        }
+                        failed = true;
+                        break;
+                }
+                data += written;
+                size -= written;
+        }
+        setp(buffer.data(), buffer.data() + buffer.size());
+
+        return !failed;
+}
+
+
+bool Output_sink::good() const
+{
+        return !failed;
+}
+
+
+Output_sink::int_type Output_sink::overflow(int_type c)
+{
+        if (!flush()) {
+                return traits_type::eof();
+        }
+        if (!traits_type::eq_int_type(c, traits_type::eof())) {
+                *pptr() = traits_type::to_char_type(c);
+                pbump(1);
+        }
+
+        return traits_type::not_eof(c);
+}
+
+
+streamsize Output_sink::xsputn(const char *s, streamsize n)
+{
+        streamsize done = 0;
+        while (done < n) {
+                if (pptr() == epptr() && !flush()) {
+                        break;
+                }
+                streamsize chunk = min(n - done,
+                                       static_cast<streamsize>(epptr() - pptr()));
+                memcpy(pptr(), s + done, chunk);
+                pbump(chunk);
+                done += chunk;
+        }
+
+        return done;
+}
+
+
+int Output_sink::sync()
+{
+        return flush() ? 0 : -1;
+}
+
+
+ostream &diagnostics()
+{
+        if (thread_diagnostics_stream != nullptr) {
+                return *thread_diagnostics_stream;
+        }
+        return *diagnostics_stream;
+}
+
+
+void set_diagnostics(ostream *out)
+{
+        diagnostics_stream = (out == nullptr) ? &cerr : out;
+}
+
+
+void set_thread_diagnostics(ostream *out)
+{
+        thread_diagnostics_stream = out;
+}
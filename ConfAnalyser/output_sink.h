@@ -0,0 +1,44 @@
+#ifndef OUTPUT_SINK_H
+#define OUTPUT_SINK_H
+
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+/* Buffered output to a file descriptor. Data are written only when the
+   buffer gets full or on explicit flush, so that piping millions of
+   result lines does not cost one write per line. */
+class Output_sink : public std::streambuf
+{
+        public:
+                static const size_t default_capacity = 1 << 20;
+
+                Output_sink(int _fd, size_t capacity = default_capacity);
+                ~Output_sink();
+                /* Redirect the sink to a newly created file */
+                bool open(const std::string &file_name);
+                /* Write buffered data, false in case of failed write */
+                bool flush();
+                bool good() const;
+        protected:
+                virtual int_type overflow(int_type c) override;
+                virtual std::streamsize xsputn(const char *s,
+                                               std::streamsize n) override;
+                virtual int sync() override;
+        private:
+                int fd;
+                bool owned;
+                bool failed;
+                std::vector<char> buffer;
+};
+
+/* Stream for diagnostic messages of the analysis, standard error unless
+   redirected (the stream has to outlive its use) */
+std::ostream &diagnostics();
+void set_diagnostics(std::ostream *out);
+/* Redirect diagnostics of the calling thread only (nullptr cancels it), so
+   that worker threads do not write to the shared stream concurrently */
+void set_thread_diagnostics(std::ostream *out);
+
+#endif
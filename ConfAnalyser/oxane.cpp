@@ -1,37 +1,157 @@
 #include <algorithm>
 #include <array>
-#include <sstream>
+#include <cmath>
 #include <vector>
 #include <string>
 #include <cctype>
+#include <cstring>
+#include <limits>
 #include "oxane.h"
-#include "plane_3D.h"
-#include "angle.h"
 #include "helper_functions.h"
-
-#define ABOVE           0
-#define UNDER           1
-
-#define CHAIR           "CHAIR"
-#define ENVELOPE        "ENVELOPE"
-#define HALF_CHAIR      "HALF CHAIR"
-#define BOAT            "BOAT"
-#define SKEW            "SKEW"
+#include "output_sink.h"
+#include "instrumentation.h"
+#include "torsion_classifier.h"
+
+#define UNDEFINIED      1
+#define FLAT            2
+#define CHAIR           3
+#define ENVELOPE        4
+#define HALF_CHAIR      5
+#define BOAT            6
+#define SKEW            7
+
+/* Ring atoms in IUPAC numbering, carbons 1 to 5 and the ring oxygen */
+#define AT1             0x01
+#define AT2             0x02
+#define AT3             0x04
+#define AT4             0x08
+#define AT5             0x10
+#define ATO             0x20
 
 using namespace std;
 
 
-Oxane::Oxane(string _structure) : Six_atom_ring(_structure)
+map<string, short> Oxane::conformation_table = {
+        {"UNANALYSED", 0},
+        {"UNDEFINIED", UNDEFINIED},
+        {"FLAT", FLAT},
+        {"CHAIR", CHAIR},
+        {"ENVELOPE", ENVELOPE},
+        {"HALF CHAIR", HALF_CHAIR},
+        {"BOAT", BOAT},
+        {"SKEW", SKEW}
+};
+
+
+/* Conformer given by atoms above and under its reference plane */
+struct Oxane_conformer {
+        const char *label;
+        short conformation;
+        unsigned char above;
+        unsigned char under;
+};
+
+
+/* The 38 conformers of pyranoses (IUPAC 2-Carb-7). The ring is viewed from
+ * the side where its numbering goes clockwise, atoms above the reference
+ * plane are written before the letter, atoms under it after the letter.
+ * Chairs fit three reference planes and skews two of them, the other
+ * planes are listed as aliases of the name preferred by IUPAC (the lowest
+ * numbered carbon out of plane). */
+static const Oxane_conformer conformers[] = {
+        {"FLAT", FLAT, 0, 0},
+
+        {"4C1", CHAIR, AT4, AT1},
+        {"1C4", CHAIR, AT1, AT4},
+        {"4C1", CHAIR, AT2, AT5},
+        {"4C1", CHAIR, ATO, AT3},
+        {"1C4", CHAIR, AT5, AT2},
+        {"1C4", CHAIR, AT3, ATO},
+
+        {"3,OB", BOAT, AT3 | ATO, 0},
+        {"B3,O", BOAT, 0, AT3 | ATO},
+        {"1,4B", BOAT, AT1 | AT4, 0},
+        {"B1,4", BOAT, 0, AT1 | AT4},
+        {"2,5B", BOAT, AT2 | AT5, 0},
+        {"B2,5", BOAT, 0, AT2 | AT5},
+
+        {"1S3", SKEW, AT1, AT3},
+        {"3S1", SKEW, AT3, AT1},
+        {"1S5", SKEW, AT1, AT5},
+        {"5S1", SKEW, AT5, AT1},
+        {"OS2", SKEW, ATO, AT2},
+        {"2SO", SKEW, AT2, ATO},
+        {"1S3", SKEW, AT4, ATO},
+        {"3S1", SKEW, ATO, AT4},
+        {"1S5", SKEW, AT4, AT2},
+        {"5S1", SKEW, AT2, AT4},
+        {"OS2", SKEW, AT3, AT5},
+        {"2SO", SKEW, AT5, AT3},
+
+        {"OH1", HALF_CHAIR, ATO, AT1},
+        {"1HO", HALF_CHAIR, AT1, ATO},
+        {"1H2", HALF_CHAIR, AT1, AT2},
+        {"2H1", HALF_CHAIR, AT2, AT1},
+        {"2H3", HALF_CHAIR, AT2, AT3},
+        {"3H2", HALF_CHAIR, AT3, AT2},
+        {"3H4", HALF_CHAIR, AT3, AT4},
+        {"4H3", HALF_CHAIR, AT4, AT3},
+        {"4H5", HALF_CHAIR, AT4, AT5},
+        {"5H4", HALF_CHAIR, AT5, AT4},
+        {"5HO", HALF_CHAIR, AT5, ATO},
+        {"OH5", HALF_CHAIR, ATO, AT5},
+
+        {"OE", ENVELOPE, ATO, 0},
+        {"EO", ENVELOPE, 0, ATO},
+        {"1E", ENVELOPE, AT1, 0},
+        {"E1", ENVELOPE, 0, AT1},
+        {"2E", ENVELOPE, AT2, 0},
+        {"E2", ENVELOPE, 0, AT2},
+        {"3E", ENVELOPE, AT3, 0},
+        {"E3", ENVELOPE, 0, AT3},
+        {"4E", ENVELOPE, AT4, 0},
+        {"E4", ENVELOPE, 0, AT4},
+        {"5E", ENVELOPE, AT5, 0},
+        {"E5", ENVELOPE, 0, AT5}
+};
+
+#define CONFORMERS (sizeof(conformers) / sizeof(conformers[0]))
+
+
+/* Index of the first conformer of the same label for every conformer, so
+   that the aliases of a chair or skew are one class of classify_batch */
+static vector<short> preferred_conformers()
 {
-        conformations.insert({CHAIR, 3});
-        conformations.insert({ENVELOPE, 4});
-        conformations.insert({HALF_CHAIR, 5});
-        conformations.insert({BOAT, 6});
-        conformations.insert({SKEW, 7});
-
-        for (auto x : outOfPlaneAtoms) {
-                x.presence = false;
+        vector<short> result(CONFORMERS, 0);
+        for (size_t i = 0; i < CONFORMERS; i++) {
+                while (strcmp(conformers[result[i]].label,
+                              conformers[i].label) != 0) {
+                        result[i]++;
+                }
         }
+        return result;
+}
+
+static const vector<short> preferred = preferred_conformers();
+
+
+/* Kinds of reference planes - positions of its four atoms relative to the
+ * first one and of the two atoms out of it. Flat rings, chairs, boats and
+ * envelopes have four atoms of two opposite bonds in plane, half chairs
+ * four neighbouring atoms and skews three neighbouring atoms and the one
+ * opposite to the middle one. */
+static const int reference_planes[][5] = {
+        {1, 3, 4, 2, 5},
+        {1, 2, 3, 4, 5},
+        {1, 2, 4, 3, 5}
+};
+
+
+Oxane::Oxane(string _structure)
+        : Six_atom_ring(_structure, conformation_table)
+{
+        conformer = -1;
+        oxygen_position = 0;
 }
 
 
@@ -47,65 +167,19 @@ Oxane::~Oxane()
 
 string Oxane::translate_conformation() const
 {
-        stringstream conf_name;
-
-        bool first_symbol = true;
-
-        for (auto x : outOfPlaneAtoms) {
-                if (x.presence) {
-                        if (x.position == ABOVE) {
-                                if (!first_symbol) {
-                                        conf_name << ",";
-                                }
-                                conf_name << x.atom_name;
-                                first_symbol = false;
-                        }
-                }
+        /* conformations recognized by other engines are not labelled */
+        if (conformer < 0 || conformers[conformer].conformation != conformation) {
+                return Molecule::translate_conformation();
         }
-
-        // TODO redo to switch case once conformtions uses ENUM values
-        //      (switch cases labels must be compile time evaluable constant
-        //      expressions)
-        if (conformation == conformations[CHAIR]) {
-                conf_name << "C";
-        } else if (conformation == conformations[ENVELOPE]) {
-                conf_name << "E";
-        } else if (conformation == conformations[HALF_CHAIR]) {
-                conf_name << "H";
-        } else if (conformation == conformations[BOAT]) {
-                conf_name << "B";
-        } else if (conformation == conformations[SKEW]) {
-                conf_name << "S";
-        } else {
-                for (auto conf : conformations) {
-                        if (conf.second == conformation) {
-                                return conf.first;
-                        }
-                }
-        }
-
-
-        first_symbol = true;
-        for (auto x : outOfPlaneAtoms) {
-                if (x.presence) {
-                        if (x.position == UNDER) {
-                                if (!first_symbol) {
-                                        conf_name << ",";
-                                }
-                                conf_name << x.atom_name;
-                                first_symbol = false;
-                        }
-                }
-        }
-
-        return conf_name.str();
+        return conformers[conformer].label;
 }
 
 
 static bool filler(Atom *x, bool &found, Atom *&C)
 {
         if (found) {
-                cerr << strip(x->get_atom_name()) << " atom found twice!\n";
+                COUNT(COUNTER_DUPLICATE_ATOMS, 1);
+                diagnostics() << strip(x->get_atom_name()) << " atom found twice!\n";
                 return false;
         }
 
@@ -125,8 +199,11 @@ bool Oxane::initialize(const vector<Atom*> &atoms)
 	for (auto x : atoms) {
 	        if (ligand.empty()) {
                         ligand = x->get_residue_name();
+                        chain_id = x->get_chain_id();
+                        residue_number = x->get_residue_number();
                         if (atom_names.find(ligand) == atom_names.end()) {
-                                cerr << "Ligand '" << ligand
+                                COUNT(COUNTER_UNKNOWN_LIGAND, 1);
+                                diagnostics() << "Ligand '" << ligand
                                         << "' not recognized!\n";
                                 return false;
                         }
@@ -141,7 +218,8 @@ bool Oxane::initialize(const vector<Atom*> &atoms)
                                 string element_name = strip(C[atom_index]->get_element_name());
                                 if (element_name == "O") {
                                         if (oxygen_found) {
-                                                cerr << "Oxygen atom found twice";
+                                                COUNT(COUNTER_DUPLICATE_ATOMS, 1);
+                                                diagnostics() << "Oxygen atom found twice";
                                                 return false;
                                         }
                                         oxygen_found = true;
@@ -153,328 +231,169 @@ bool Oxane::initialize(const vector<Atom*> &atoms)
 
         filled = all_of(found.begin(), found.end(), [](bool is_found){return is_found;});
         if (!filled) {
-                cerr << "Not all atoms were found!" << endl;   
+                COUNT(COUNTER_MISSING_ATOMS, 1);
+                diagnostics() << "Not all atoms were found!" << '\n';   
+        }
+        if (filled && !oxygen_found) {
+                COUNT(COUNTER_OTHER_FAILURE, 1);
         }
         if (!oxygen_found) {
-                cerr << "Unable to find oxygen atom position using element_name PDB field.\n";
+                diagnostics() << "Unable to find oxygen atom position using element_name PDB field.\n";
         }
 
         return filled && oxygen_found;
 }
 
 
-bool Oxane::is_flat()
+bool Oxane::set_coordinates(const double *coordinates)
 {
-        has_plane = find_plane(tolerance_in);
-        if (!has_plane) {
-                return false;
-        }
-
-        bool isFlat = false;
-
-        Plane_3D left_plane(*(C[begin]), *(C[(begin+1)%6]), *(C[(begin+4)%6]));
-        Plane_3D right_plane(*(C[begin]), *(C[(begin+1)%6]), *(C[(begin+3)%6]));
-
-        isFlat = left_plane.is_on_plane(*(C[(begin+2)%6]), tolerance_in) &&
-               left_plane.is_on_plane(*(C[(begin+5)%6]), tolerance_in) &&
-               right_plane.is_on_plane(*(C[(begin+2)%6]), tolerance_in) &&
-               right_plane.is_on_plane(*(C[(begin+5)%6]), tolerance_in);
-
-        return isFlat;
+        /* ring oxygen is expected to be the last of the ring atoms */
+        oxygen_position = 5;
+        return Six_atom_ring::set_coordinates(coordinates);
 }
 
 
-bool Oxane::is_chair()
+template<typename T>
+short Oxane::classify_ring(const Point_3D_t<T> *P) const
 {
-        /* code below should be right in theory, but causes really big troubles
-           to analysis...
-
-        // atoms C1, C2, C4, and C5 has to lay in one plane
-        // In fact, any four atom lying opposite each other have to lay in one plane
-        // in CHAIR, but the symmetry of this conformation and numbering rules
-        // stating that oxygen atom has to be nr. 6 force us to set begin to C1
-        begin = oxygen_position % 6 + 1;  // start at C1
-        Plane_3D plane(*(C[begin]), *(C[(begin+1)%6]), *(C[(begin+3)%6]));
-        has_plane = abs(plane.distance_from(*(C[(begin+4)%6]))) < tolerance_in;
-        if (!has_plane) {
-                return false;
+        /* atoms in IUPAC numbering, the ring oxygen is the last one */
+        const Point_3D_t<T> *atoms[6];
+        for (int i = 0; i < 6; i++) {
+                atoms[i] = &P[(oxygen_position + 1 + i) % 6];
         }
-        */
+        Vector_3D_t<T> center, normal;
+        mean_plane(atoms, 6, center, normal);
+
+        /* atoms out of the most accurate plane of each kind, looked up in
+           the table of conformers */
+        for (const auto &x : reference_planes) {
+                int first = 0;
+                T distance = numeric_limits<T>::max();
+                Vector_3D_t<T> plane_normal;
+                for (int i = 0; i < 6; i++) {
+                        Vector_3D_t<T> origin(*(atoms[i]));
+                        Vector_3D_t<T> tmp = Vector_3D_t<T>::cross(
+                                        Vector_3D_t<T>(*(atoms[(i + x[0]) % 6])) - origin,
+                                        Vector_3D_t<T>(*(atoms[(i + x[1]) % 6])) - origin);
+                        tmp = tmp / tmp.length();
+                        T _distance = abs(Vector_3D_t<T>::dot(
+                                        Vector_3D_t<T>(*(atoms[(i + x[2]) % 6])) - origin, tmp));
+                        if (_distance < distance) {
+                                first = i;
+                                distance = _distance;
+                                plane_normal = tmp;
+                        }
+                }
+                if (distance > tolerance_in) {
+                        continue;
+                }
+                /* above is the side of the mean plane normal */
+                if (Vector_3D_t<T>::dot(plane_normal, normal) < 0) {
+                        plane_normal = plane_normal * -1;
+                }
 
-        has_plane = find_plane(tolerance_in);
-        if (!has_plane) {
-                return false;
-        }
+                unsigned char above = 0, under = 0;
+                bool defined = true;
+                for (int j = 3; j < 5; j++) {
+                        int atom = (first + x[j]) % 6;
+                        T height = Vector_3D_t<T>::dot(
+                                        Vector_3D_t<T>(*(atoms[atom])) - Vector_3D_t<T>(*(atoms[first])),
+                                        plane_normal);
+                        if (height > tolerance_out) {
+                                above |= 1 << atom;
+                        } else if (height < -tolerance_out) {
+                                under |= 1 << atom;
+                        } else if (abs(height) > tolerance_in) {
+                                defined = false;
+                        }
+                }
 
-        bool isChair = false;
-
-        Plane_3D left_plane(*(C[begin]), *(C[(begin+1)%6]), *(C[(begin+4)%6]));
-        Plane_3D right_plane(*(C[begin]), *(C[(begin+1)%6]), *(C[(begin+3)%6]));
-        double right_dist = (abs(right_plane.distance_from(*(C[(begin+2)%6]))) <
-                             abs(left_plane.distance_from(*(C[(begin+2)%6])))) ?
-                                right_plane.distance_from(*(C[(begin+2)%6])) :
-                                left_plane.distance_from(*(C[(begin+2)%6]));
-        double left_dist = (abs(right_plane.distance_from(*(C[(begin+5)%6]))) <
-                             abs(left_plane.distance_from(*(C[(begin+5)%6])))) ?
-                                right_plane.distance_from(*(C[(begin+5)%6])) :
-                                left_plane.distance_from(*(C[(begin+5)%6]));
-
-        isChair = (abs(right_dist) > tolerance_out &&
-                   abs(left_dist) > tolerance_out) &&
-                   (right_dist * left_dist < 0);
-
-        if (isChair) {
-                outOfPlaneAtoms[0].presence = true;
-                outOfPlaneAtoms[1].presence = true;
-                outOfPlaneAtoms[0].position = right_dist > 0 ? ABOVE : UNDER;
-                outOfPlaneAtoms[1].position = left_dist > 0 ? ABOVE : UNDER;
-                outOfPlaneAtoms[0].atom_name = to_string(get_index_by_oxygen(2));
-                outOfPlaneAtoms[1].atom_name = to_string(get_index_by_oxygen(5));
+                for (size_t i = 0; defined && i < CONFORMERS; i++) {
+                        if (conformers[i].above == above &&
+                            conformers[i].under == under) {
+                                return preferred[i];
+                        }
+                }
         }
 
-        return isChair;
+        return -1;
 }
 
 
-bool Oxane::is_half_chair()
+template<typename T>
+void Oxane::classify_rings(const T *coordinates, size_t ring_count,
+                           short *classes) const
 {
-        has_plane = find_plane(tolerance_in, 1, 2, 3);
-        if (!has_plane) {
-                return false;
-        }
-
-        bool isHalfChair = false;
-
-        Plane_3D left_plane(*(C[begin]), *(C[(begin+1)%6]), *(C[(begin+3)%6]));
-        Plane_3D right_plane(*(C[begin]), *(C[(begin+1)%6]), *(C[(begin+2)%6]));
-        double right_dist = (abs(right_plane.distance_from(*(C[(begin+4)%6]))) <
-                             abs(left_plane.distance_from(*(C[(begin+4)%6])))) ?
-                                right_plane.distance_from(*(C[(begin+4)%6])) :
-                                left_plane.distance_from(*(C[(begin+4)%6]));
-        double left_dist = (abs(right_plane.distance_from(*(C[(begin+5)%6]))) <
-                             abs(left_plane.distance_from(*(C[(begin+5)%6])))) ?
-                                right_plane.distance_from(*(C[(begin+5)%6])) :
-                                left_plane.distance_from(*(C[(begin+5)%6]));
-
-        isHalfChair = (abs(right_dist) > tolerance_out &&
-                abs(left_dist) > tolerance_out) &&
-               (right_dist * left_dist < 0);
-
-        if (isHalfChair) {
-                outOfPlaneAtoms[0].presence = true;
-                outOfPlaneAtoms[1].presence = true;
-                outOfPlaneAtoms[0].position = right_dist > 0 ? ABOVE : UNDER;
-                outOfPlaneAtoms[1].position = left_dist > 0 ? ABOVE : UNDER;
-                outOfPlaneAtoms[0].atom_name = to_string(get_index_by_oxygen(4));
-                outOfPlaneAtoms[1].atom_name = to_string(get_index_by_oxygen(5));
+        for (size_t i = 0; i < ring_count; i++) {
+                Point_3D_t<T> P[6];
+                ring_points(coordinates + 18 * i, P);
+                classes[i] = classify_ring(P);
         }
-
-        return isHalfChair;
 }
 
 
-bool Oxane::is_boat()
+void Oxane::classify_geometric(const double *coordinates, size_t ring_count,
+                               short *classes) const
 {
-        has_plane = find_plane(tolerance_in);
-        if (!has_plane) {
-                return false;
-        }
-
-        bool isBoat = false;
-
-        Plane_3D left_plane(*(C[begin]), *(C[(begin+1)%6]), *(C[(begin+4)%6]));
-        Plane_3D right_plane(*(C[begin]), *(C[(begin+1)%6]), *(C[(begin+3)%6]));
-        double right_dist = (abs(right_plane.distance_from(*(C[(begin+2)%6]))) <
-                             abs(left_plane.distance_from(*(C[(begin+2)%6])))) ?
-                                right_plane.distance_from(*(C[(begin+2)%6])) :
-                                left_plane.distance_from(*(C[(begin+2)%6]));
-        double left_dist = (abs(right_plane.distance_from(*(C[(begin+5)%6]))) <
-                             abs(left_plane.distance_from(*(C[(begin+5)%6])))) ?
-                                right_plane.distance_from(*(C[(begin+5)%6])) :
-                                left_plane.distance_from(*(C[(begin+5)%6]));
-
-        isBoat = (abs(right_dist) > tolerance_out &&
-                abs(left_dist) > tolerance_out) &&
-               (right_dist * left_dist > 0);
-
-        if (isBoat) {
-                outOfPlaneAtoms[0].presence = true;
-                outOfPlaneAtoms[1].presence = true;
-                outOfPlaneAtoms[0].position = right_dist > 0 ? ABOVE : UNDER;
-                outOfPlaneAtoms[1].position = left_dist > 0 ? ABOVE : UNDER;
-                outOfPlaneAtoms[0].atom_name = to_string(get_index_by_oxygen(2));
-                outOfPlaneAtoms[1].atom_name = to_string(get_index_by_oxygen(5));
-        }
-
-        /* sort outOfPlaneAtoms */
-        sort(outOfPlaneAtoms, outOfPlaneAtoms+2, [](OutOfPlaneAtom x, OutOfPlaneAtom y){return x.atom_name < y.atom_name;});
-
-        return isBoat;
+        classify_rings(coordinates, ring_count, classes);
 }
 
 
-bool Oxane::is_envelope()
+void Oxane::classify_geometric(const float *coordinates, size_t ring_count,
+                               short *classes) const
 {
-        has_plane = find_plane(tolerance_in);
-        if (!has_plane) {
-                return false;
-        }
-
-        bool isEnv = false;
-
-        Plane_3D left_plane(*(C[begin]), *(C[(begin+1)%6]), *(C[(begin+4)%6]));
-        Plane_3D right_plane(*(C[begin]), *(C[(begin+1)%6]), *(C[(begin+3)%6]));
-
-        double right_dist = (abs(right_plane.distance_from(*(C[(begin+2)%6]))) <
-                             abs(left_plane.distance_from(*(C[(begin+2)%6])))) ?
-                                right_plane.distance_from(*(C[(begin+2)%6])) :
-                                left_plane.distance_from(*(C[(begin+2)%6]));
-        double left_dist = (abs(right_plane.distance_from(*(C[(begin+5)%6]))) <
-                             abs(left_plane.distance_from(*(C[(begin+5)%6])))) ?
-                                right_plane.distance_from(*(C[(begin+5)%6])) :
-                                left_plane.distance_from(*(C[(begin+5)%6]));
-
-        isEnv = ((left_plane.is_on_plane(*(C[(begin+2)%6]), tolerance_in) &&
-                right_plane.is_on_plane(*(C[(begin+2)%6]), tolerance_in)) !=
-                (left_plane.is_on_plane(*(C[(begin+5)%6]), tolerance_in) &&
-                right_plane.is_on_plane(*(C[(begin+5)%6]), tolerance_in))) &&
-                ((left_plane.is_on_plane(*(C[(begin+2)%6]), tolerance_in) ==
-                right_plane.is_on_plane(*(C[(begin+2)%6]), tolerance_in)) &&
-                (left_plane.is_on_plane(*(C[(begin+5)%6]), tolerance_in) ==
-                right_plane.is_on_plane(*(C[(begin+5)%6]), tolerance_in)));
-
-        if (isEnv) {
-                outOfPlaneAtoms[0].presence = !left_plane.is_on_plane(*(C[(begin+2)%6]), tolerance_in);
-                outOfPlaneAtoms[1].presence = !left_plane.is_on_plane(*(C[(begin+5)%6]), tolerance_in);
-                outOfPlaneAtoms[0].position = right_dist > 0 ? ABOVE : UNDER;
-                outOfPlaneAtoms[1].position = left_dist > 0 ? ABOVE : UNDER;
-                outOfPlaneAtoms[0].atom_name = to_string(get_index_by_oxygen(2));
-                outOfPlaneAtoms[1].atom_name = to_string(get_index_by_oxygen(5));
-        }
-
-        return isEnv;
+        classify_rings(coordinates, ring_count, classes);
 }
 
 
-bool Oxane::is_skew()
+void Oxane::classify()
 {
-        has_plane = find_plane(tolerance_in, 1, 2, 4);
-        if (!has_plane) {
-                return false;
-        }
+        double coordinates[18];
+        get_coordinates(coordinates);
+        classify_geometric(coordinates, 1, &conformer);
+        conformation = (conformer < 0) ? UNDEFINIED :
+                                         conformers[conformer].conformation;
+}
 
-        bool isSkew = false;
-
-        Plane_3D left_plane(*(C[begin]), *(C[(begin+1)%6]), *(C[(begin+4)%6]));
-        Plane_3D right_plane(*(C[begin]), *(C[(begin+1)%6]), *(C[(begin+2)%6]));
-        double right_dist = (abs(right_plane.distance_from(*(C[(begin+3)%6]))) <
-                             abs(left_plane.distance_from(*(C[(begin+3)%6])))) ?
-                                right_plane.distance_from(*(C[(begin+3)%6])) :
-                                left_plane.distance_from(*(C[(begin+3)%6]));
-        double left_dist = (abs(right_plane.distance_from(*(C[(begin+5)%6]))) <
-                             abs(left_plane.distance_from(*(C[(begin+5)%6])))) ?
-                                right_plane.distance_from(*(C[(begin+5)%6])) :
-                                left_plane.distance_from(*(C[(begin+5)%6]));
-
-        isSkew = (abs(right_dist) > tolerance_out &&
-                abs(left_dist) > tolerance_out) &&
-               (right_dist * left_dist < 0);
-
-        if (isSkew) {
-                outOfPlaneAtoms[0].presence = true;
-                outOfPlaneAtoms[1].presence = true;
-                outOfPlaneAtoms[0].position = right_dist > 0 ? ABOVE : UNDER;
-                outOfPlaneAtoms[1].position = left_dist > 0 ? ABOVE : UNDER;
-                outOfPlaneAtoms[0].atom_name = to_string(get_index_by_oxygen(3));
-                outOfPlaneAtoms[1].atom_name = to_string(get_index_by_oxygen(5));
-        }
 
-        return isSkew;
+short Oxane::analysed_class() const
+{
+        /* conformations recognized by other engines are not labelled */
+        return (engine == ENGINE_GEOMETRIC) ? conformer : conformation;
 }
 
 
-/* Convert to numbering relative to oxygen atom.
- * Oxygen atom is marked as 6, carbons will be marked 1 to 5 */
-short unsigned Oxane::get_index_by_oxygen(short int delta_begin)  {
-        int delta_oxygen = 6 - (oxygen_position);  // real O index vs. desired mark 6
-        return ((begin + delta_begin   // atom number relative to `begin`
-                + delta_oxygen         // shifted relative to oxygen position
-                - 1)                   // -1 so that 6 stays 6 after modulo 6
-                % 6 + 1);              // keep it in range 1 to 6
+string Oxane::class_name(short _class) const
+{
+        if (engine != ENGINE_GEOMETRIC) {
+                return Ring::class_name(_class);
+        }
+        return (_class < 0) ? "UNDEFINIED" : conformers[_class].label;
 }
 
 
-/* As oxane ring can be numbered so that oxygen atom is nr. 6 in both clockwise and
- * anticlockwise directions, every conformation name created based on
- * these numberings has at least one different descriptive name describing the
- * same conformation. For sake of clarity, use always the minimal possible
- * numbering (in case of ambiguity, prefer the clockwise solution).
- *
- * THIS FUNCTION DOES NOT CHECK WHETHER CONFORMATION DESCRIBED BY NAME IS
- * PHYSICALLY RELEVANT - E.G. EVEN THOUGH 4S2 AND 2S4 CONFORMATIONS ARE NOT LISTED
- * AMONG 6 POSSIBLE TYPES OF SKEW CONFORMATION IN THE LITERATURE, THE CONFORMATION
- * NAME WILL BE CORRECTLY GENERATED TO DESCRIBE WHAT IS IN THE PDB FILE */
-void Oxane::fill_out_of_plane_atom_names(OutOfPlaneAtom &right_OOP_atom,
-                                         short unsigned right_OOP_atom_delta_begin,
-                                         OutOfPlaneAtom &left_OOP_atom,
-                                         short unsigned left_OOP_atom_delta_begin) {
-        // primary numbering
-        array<int, 2> clockwise_positions {
-                get_index_by_oxygen(right_OOP_atom_delta_begin),
-                get_index_by_oxygen(left_OOP_atom_delta_begin)
-        };
-
-        // Create alternative numbering:
-        // imagine this act as turning the oxane ring upside down in the only axis that
-        // will keep the oxygen on the position with the number 6 - the one crossing
-        // the central plane from the oxygen edge to the edge of the C3 atom.
-        // Positions above/under will swap and regarding numbering, 4s and 5s will
-        // change to 2s and 1s (and vice versa) while 3s and 6s stay unchanged.
-        array<int, 2> anticlockwise_positions {
-                6-(clockwise_positions[1])%6,
-                6-(clockwise_positions[0])%6
-        };
-
-        // pick the one with lower avarage value
-        if ((clockwise_positions[0] + clockwise_positions[1]) / 2.0
-            <= (anticlockwise_positions[0] + anticlockwise_positions[1]) / 2.0) {
-                right_OOP_atom.atom_name = to_string(clockwise_positions[0]);
-                left_OOP_atom.atom_name = to_string(clockwise_positions[1]);
-        } else {
-                right_OOP_atom.atom_name = to_string(anticlockwise_positions[0]);
-                left_OOP_atom.atom_name = to_string(anticlockwise_positions[1]);
+short Oxane::class_conformation(short _class) const
+{
+        if (engine != ENGINE_GEOMETRIC) {
+                return _class;
         }
+        return (_class < 0) ? UNDEFINIED : conformers[_class].conformation;
 }
 
 
 bool Oxane::analyse()
 {
         if (!filled) {
-                cerr << "Molecule has to be filled before analysis!" << endl;
+                diagnostics() << "Molecule has to be filled before analysis!" << '\n';
                 return false;
         }
         if (analysed) {
-                cerr << "Attempt to analyze the same molecule twice!" << endl;
+                diagnostics() << "Attempt to analyze the same molecule twice!" << '\n';
                 return false;
         }
 
-        /* finding the most accurate plane of 4 atoms within the ring */
-        if (is_flat()) {
-                conformation = conformations["FLAT"];
-        } else if (is_chair()) {
-                conformation = conformations["CHAIR"];
-        } else if (is_half_chair()) {
-                conformation = conformations["HALF CHAIR"];
-        } else if (is_boat()) {
-                conformation = conformations["BOAT"];
-        } else if (is_envelope()) {
-		conformation = conformations["ENVELOPE"];
-        } else if (is_skew()) {
-		conformation = conformations["SKEW"];
-        } else {
-		conformation = conformations["UNDEFINIED"];
-        }
-                
+        recognize();
+        describe();
         analysed = true;
         return true;
 }
@@ -483,8 +402,12 @@ bool Oxane::analyse()
 bool Oxane::is_valid_atom_name(const int atom_number,
                                         const std::string &name) const
 {
-        return (ligand.empty()) ? false :
-                                any_of(atom_names[ligand][atom_number].begin(),
-                                atom_names[ligand][atom_number].end(),
-                                [&name](string &tmp){return tmp == name;});
+        auto itr = atom_names.find(ligand);
+        if (ligand.empty() || itr == atom_names.end() ||
+            static_cast<size_t>(atom_number) >= itr->second.size()) {
+                return false;
+        }
+        const vector<string> &names = itr->second[atom_number];
+        return any_of(names.begin(), names.end(),
+                      [&name](const string &tmp){return tmp == name;});
 }
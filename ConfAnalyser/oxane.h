@@ -5,12 +5,6 @@
 #include <map>
 #include <vector>
 
-struct OutOfPlaneAtom {
-        std::string atom_name;
-        int position;
-        bool presence;
-};
-
 class Oxane : public Six_atom_ring
 {
         public:
@@ -20,32 +14,40 @@ class Oxane : public Six_atom_ring
                 virtual bool analyse();
                 virtual bool initialize(const std::vector<Atom*> &atoms);
                 virtual std::string translate_conformation() const override;
+                virtual bool set_coordinates(const double *coordinates) override;
+                virtual std::string class_name(short _class) const override;
+                virtual short class_conformation(short _class) const override;
+        protected:
+                virtual void classify();
+                virtual short analysed_class() const override;
+                virtual void classify_geometric(const double *coordinates,
+                                                size_t ring_count,
+                                                short *classes) const;
+                virtual void classify_geometric(const float *coordinates,
+                                                size_t ring_count,
+                                                short *classes) const;
         private:
-                /* functions for analyzing */
-                bool is_flat();
-                bool is_half_chair();
-                bool is_chair();
-                bool is_boat(); 
-                bool is_envelope();
-                bool is_skew();
-
+                /* Index of conformer of ring of atoms P (the first one of
+                   its label), negative if not labelled */
+                template<typename T>
+                short classify_ring(const Point_3D_t<T> *P) const;
+                template<typename T>
+                void classify_rings(const T *coordinates, size_t ring_count,
+                                    short *classes) const;
 		/* function verifying atom names for current ligand type */
 		bool is_valid_atom_name(const int atom_number,
 		                        const std::string &name) const;
 
+                /* Possible conformations of this ring type */
+                static std::map<std::string, short> conformation_table;
                 /* Tolerances */
                 static constexpr double tolerance_in = 0.1;
                 static constexpr double tolerance_out = 0.3;
-                
-                /* Info about atoms lying out of plane */
-                OutOfPlaneAtom outOfPlaneAtoms[2];
+
+                /* Index of the conformer (IUPAC label) in the table of
+                   conformers, negative if the ring was not labelled */
+                short conformer;
                 signed short oxygen_position;
-                short unsigned get_index_by_oxygen(short int delta_from_begin);
-                void fill_out_of_plane_atom_names(
-                                OutOfPlaneAtom &right_OOP_atom,
-                                short unsigned right_OOP_atom_delta_begin,
-                                OutOfPlaneAtom &left_OOP_atom,
-                                short unsigned left_OOP_atom_delta_begin);
 };
 
 #endif
@@ -0,0 +1,423 @@
+#include "partial_result.h"
+#include "output_sink.h"
+#include <cstdlib>
+#include <sstream>
+
+using namespace std;
+
+
+/* Fields of a tab separated line */
+static vector<string> split_fields(const string &line)
+{
+        vector<string> fields;
+        size_t start = 0;
+        while (true) {
+                size_t tab = line.find('\t', start);
+                fields.push_back(line.substr(start, tab - start));
+                if (tab == string::npos) {
+                        return fields;
+                }
+                start = tab + 1;
+        }
+}
+
+
+string escape_field(const string &name)
+{
+        string field;
+        for (char c : name) {
+                if (c == '\t') {
+                        field += "\\t";
+                } else if (c == '\n') {
+                        field += "\\n";
+                } else if (c == '\\') {
+                        field += "\\\\";
+                } else {
+                        field += c;
+                }
+        }
+        return field;
+}
+
+
+string unescape_field(const string &field)
+{
+        string name;
+        for (size_t i = 0; i < field.size(); i++) {
+                if (field[i] != '\\' || i + 1 == field.size()) {
+                        name += field[i];
+                        continue;
+                }
+                char c = field[++i];
+                name += (c == 't') ? '\t' : (c == 'n') ? '\n' : c;
+        }
+        return name;
+}
+
+
+static bool parse_number(const string &field, size_t &value)
+{
+        char *end = nullptr;
+        if (field.empty() || field[0] == '-') {
+                return false;
+        }
+        value = strtoul(field.c_str(), &end, 10);
+        return *end == '\0';
+}
+
+
+static bool parse_number(const string &field, long &value)
+{
+        char *end = nullptr;
+        if (field.empty()) {
+                return false;
+        }
+        value = strtol(field.c_str(), &end, 10);
+        return *end == '\0';
+}
+
+
+static bool parse_number(const string &field, double &value)
+{
+        char *end = nullptr;
+        if (field.empty()) {
+                return false;
+        }
+        value = strtod(field.c_str(), &end);
+        return *end == '\0';
+}
+
+
+/* Optional field of a result given as name=value */
+static bool parse_optional(const string &field, Ring_result &result)
+{
+        size_t eq = field.find('=');
+        string name = field.substr(0, eq);
+        string value = (eq == string::npos) ? "" : field.substr(eq + 1);
+
+        /* confidence was written without its name before */
+        if (eq == string::npos) {
+                return parse_number(field, result.confidence);
+        }
+        if (name == "confidence") {
+                return parse_number(value, result.confidence);
+        }
+        if (name == "torsions") {
+                Ring_descriptors &d = result.descriptors;
+                istringstream ss(value);
+                string number;
+                d.ring_size = 0;
+                while (getline(ss, number, ',')) {
+                        if (d.ring_size == MAX_RING_SIZE ||
+                            !parse_number(number, d.torsions[d.ring_size])) {
+                                return false;
+                        }
+                        d.ring_size++;
+                }
+                return true;
+        }
+        /* fields of newer versions are skipped */
+        return true;
+}
+
+
+Partial_result::Partial_result()
+{
+        shards = 0;
+}
+
+
+void Partial_result::set_conformations(const map<string, short> &table)
+{
+        conformations = table;
+        counts.assign(conformations.size(), 0);
+        statistics = Descriptor_statistics(conformations);
+}
+
+
+void Partial_result::set_shard(size_t _shard, size_t _shards)
+{
+        shards = _shards;
+        present.assign(shards, false);
+        if (_shard >= 1 && _shard <= shards) {
+                present[_shard - 1] = true;
+        }
+}
+
+
+void Partial_result::add(size_t index, const Ring_result &result)
+{
+        /* new result of the same file replaces the old one */
+        remove(index);
+        if (static_cast<size_t>(result.conformation) < counts.size()) {
+                counts[result.conformation]++;
+        }
+        results[index] = result;
+}
+
+
+void Partial_result::remove(size_t index)
+{
+        auto itr = results.find(index);
+        if (itr == results.end()) {
+                return;
+        }
+        size_t code = itr->second.conformation;
+        if (code < counts.size() && counts[code] > 0) {
+                counts[code]--;
+        }
+        results.erase(itr);
+}
+
+
+bool Partial_result::merge(const Partial_result &other,
+                           const string &source_name)
+{
+        /* first merged part defines the run */
+        if (shards == 0) {
+                *this = other;
+                return true;
+        }
+
+        if (other.conformations != conformations) {
+                diagnostics() << source_name << ": results of different type of ring!\n";
+                return false;
+        }
+        if (other.shards != shards) {
+                diagnostics() << source_name << ": run split to " << other.shards
+                              << " shards instead of " << shards << "!\n";
+                return false;
+        }
+        for (size_t i = 0; i < shards; i++) {
+                if (present[i] && other.present[i]) {
+                        diagnostics() << source_name << ": shard " << i + 1
+                                      << "/" << shards << " merged twice!\n";
+                        return false;
+                }
+        }
+
+        for (const auto &x : other.results) {
+                if (results.count(x.first) != 0) {
+                        diagnostics() << source_name << ": file nr. " << x.first + 1
+                                      << " of the list merged twice!\n";
+                        return false;
+                }
+        }
+
+        for (size_t i = 0; i < shards; i++) {
+                present[i] = present[i] || other.present[i];
+        }
+        for (size_t i = 0; i < counts.size(); i++) {
+                counts[i] += other.counts[i];
+        }
+        results.insert(other.results.begin(), other.results.end());
+        statistics.merge(other.statistics);
+
+        return true;
+}
+
+
+bool Partial_result::write(ostream &out) const
+{
+        out << PARTIAL_MAGIC << '\n';
+        for (size_t i = 0; i < shards; i++) {
+                if (present[i]) {
+                        out << "shard\t" << i + 1 << '\t' << shards << '\n';
+                }
+        }
+        for (const auto &x : conformations) {
+                out << "conformation\t" << escape_field(x.first) << '\t'
+                    << x.second << '\n';
+        }
+        for (size_t i = 0; i < counts.size(); i++) {
+                out << "count\t" << i << '\t' << counts[i] << '\n';
+        }
+
+        /* descriptors are kept exactly, rounding is left to the output;
+           the precision of the stream is restored at the end */
+        streamsize precision = out.precision(17);
+        for (const auto &x : results) {
+                const Ring_result &r = x.second;
+                const Ring_descriptors &d = r.descriptors;
+                out << "result\t" << x.first << '\t'
+                    << escape_field(r.structure) << '\t'
+                    << escape_field(r.ligand) << '\t'
+                    << escape_field(string(1, r.chain_id)) << '\t'
+                    << r.residue_number << '\t' << r.conformation << '\t'
+                    << escape_field(r.conformation_name) << '\t'
+                    << d.plane_distance << '\t' << d.right_distance << '\t'
+                    << d.left_distance << '\t' << d.dihedral << '\t'
+                    << d.puckering_amplitude << '\t' << d.theta << '\t'
+                    << d.phi;
+                /* optional fields are tagged by their names */
+                if (d.ring_size > 0) {
+                        out << "\ttorsions=";
+                        for (size_t i = 0; i < d.ring_size; i++) {
+                                out << (i == 0 ? "" : ",") << d.torsions[i];
+                        }
+                }
+                if (r.confidence >= 0) {
+                        out << "\tconfidence=" << r.confidence;
+                }
+                out << '\n';
+        }
+        statistics.write(out);
+        out.precision(precision);
+
+        return !out.fail();
+}
+
+
+bool Partial_result::read(istream &in, const string &source_name)
+{
+        string line;
+        size_t line_number = 1;
+        if (!getline(in, line) || line != PARTIAL_MAGIC) {
+                diagnostics() << source_name << ": not a partial result!\n";
+                return false;
+        }
+
+        *this = Partial_result();
+        bool summarized = false;
+        while (getline(in, line)) {
+                line_number++;
+                vector<string> fields = split_fields(line);
+                size_t a, b;
+                bool valid = false;
+
+                if (fields[0] == "shard" && fields.size() == 3) {
+                        valid = parse_number(fields[1], a) &&
+                                parse_number(fields[2], b) &&
+                                a >= 1 && a <= b &&
+                                (shards == 0 || shards == b);
+                        if (valid) {
+                                if (shards == 0) {
+                                        set_shard(a, b);
+                                }
+                                present[a - 1] = true;
+                        }
+                } else if (fields[0] == "conformation" && fields.size() == 3) {
+                        valid = parse_number(fields[2], a);
+                        if (valid) {
+                                conformations[unescape_field(fields[1])] = a;
+                                counts.assign(conformations.size(), 0);
+                        }
+                } else if (fields[0] == "count" && fields.size() == 3) {
+                        valid = parse_number(fields[1], a) &&
+                                parse_number(fields[2], b) &&
+                                a < counts.size();
+                        if (valid) {
+                                counts[a] = b;
+                        }
+                } else if (fields[0] == "result" && fields.size() >= 15) {
+                        Ring_result r;
+                        Ring_descriptors &d = r.descriptors;
+                        long residue;
+                        size_t code;
+                        string chain = unescape_field(fields[4]);
+                        valid = parse_number(fields[1], a) &&
+                                chain.size() == 1 &&
+                                parse_number(fields[5], residue) &&
+                                parse_number(fields[6], code) &&
+                                parse_number(fields[8], d.plane_distance) &&
+                                parse_number(fields[9], d.right_distance) &&
+                                parse_number(fields[10], d.left_distance) &&
+                                parse_number(fields[11], d.dihedral) &&
+                                parse_number(fields[12], d.puckering_amplitude) &&
+                                parse_number(fields[13], d.theta) &&
+                                parse_number(fields[14], d.phi);
+                        for (size_t i = 15; valid && i < fields.size(); i++) {
+                                valid = parse_optional(fields[i], r);
+                        }
+                        if (valid) {
+                                r.structure = unescape_field(fields[2]);
+                                r.ligand = unescape_field(fields[3]);
+                                r.chain_id = chain[0];
+                                r.residue_number = residue;
+                                r.conformation = code;
+                                r.conformation_name = unescape_field(fields[7]);
+                                results[a] = r;
+                        }
+                } else if (fields[0] == "statistics" || fields[0] == "sketch" ||
+                           fields[0] == "histogram") {
+                        /* the table of conformations comes first */
+                        if (!summarized) {
+                                statistics = Descriptor_statistics(conformations);
+                                summarized = true;
+                        }
+                        valid = statistics.read(fields);
+                }
+
+                if (!valid) {
+                        diagnostics() << source_name << ": damaged partial result on line nr. "
+                                      << line_number << "!\n";
+                        return false;
+                }
+        }
+
+        if (shards == 0 || conformations.empty()) {
+                diagnostics() << source_name << ": incomplete partial result!\n";
+                return false;
+        }
+        if (!summarized) {
+                statistics = Descriptor_statistics(conformations);
+                for (const auto &x : results) {
+                        statistics.add(x.second);
+                }
+        }
+
+        return true;
+}
+
+
+const map<string, short> &Partial_result::get_conformations() const
+{
+        return conformations;
+}
+
+
+const vector<size_t> &Partial_result::get_counts() const
+{
+        return counts;
+}
+
+
+vector<Ring_result> Partial_result::get_results() const
+{
+        vector<Ring_result> ordered;
+        ordered.reserve(results.size());
+        for (const auto &x : results) {
+                ordered.push_back(x.second);
+        }
+        return ordered;
+}
+
+
+const map<size_t, Ring_result> &Partial_result::get_indexed_results() const
+{
+        return results;
+}
+
+
+vector<size_t> Partial_result::missing_shards() const
+{
+        vector<size_t> missing;
+        for (size_t i = 0; i < shards; i++) {
+                if (!present[i]) {
+                        missing.push_back(i + 1);
+                }
+        }
+        return missing;
+}
+
+
+const Descriptor_statistics &Partial_result::get_statistics() const
+{
+        return statistics;
+}
+
+
+void Partial_result::set_statistics(const Descriptor_statistics &_statistics)
+{
+        statistics = _statistics;
+}
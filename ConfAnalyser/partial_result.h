@@ -0,0 +1,77 @@
+#ifndef PARTIAL_RESULT_H
+#define PARTIAL_RESULT_H
+
+#include "molecule.h"
+#include "descriptor_statistics.h"
+#include <istream>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/* Format of the first line of partial result */
+#define PARTIAL_MAGIC "CONFPART1"
+
+/*
+ * Result of a part (shard) of a run: counts of conformations and the list
+ * of analysed rings keyed by the position of their file in the input list.
+ * Partial results of any number of shards can be merged into the list and
+ * summary of a single run. The file is a tab separated text:
+ *
+ *   CONFPART1
+ *   shard      <k> <N>
+ *   conformation <name> <code>       (table of the ring type)
+ *   count      <code> <count>
+ *   result     <index> <structure> <ligand> <chain> <residue> <code>
+ *              <conformation> <descriptors...> [<name>=<value>...]
+ *   statistics, sketch, histogram    (Descriptor_statistics)
+ *
+ * Names (structure, ligand, chain, conformation) are escaped by
+ * escape_field. Optional fields of a result (torsions=<t1>,<t2>,...,
+ * confidence=<c>)
+ * are named, unknown names are skipped when reading. Distributions of
+ * descriptors of partial results without them (of older versions) are
+ * summarized from their rings.
+ */
+/* Name written to a field of partial result, with tabs, newlines and
+   backslashes escaped as \t, \n and \\, and the name read back */
+std::string escape_field(const std::string &name);
+std::string unescape_field(const std::string &field);
+
+class Partial_result
+{
+        public:
+                Partial_result();
+                void set_conformations(const std::map<std::string, short> &table);
+                void set_shard(size_t _shard, size_t _shards);
+                /* Result of file on given position, replaces the previous
+                   result of the same position */
+                void add(size_t index, const Ring_result &result);
+                void remove(size_t index);
+                /* Add results of other shard, false if the shards do not
+                   fit together */
+                bool merge(const Partial_result &other,
+                           const std::string &source_name);
+                bool write(std::ostream &out) const;
+                bool read(std::istream &in, const std::string &source_name);
+                const std::map<std::string, short> &get_conformations() const;
+                const std::vector<size_t> &get_counts() const;
+                /* Analysed rings in the order of the input list */
+                std::vector<Ring_result> get_results() const;
+                const std::map<size_t, Ring_result> &get_indexed_results() const;
+                /* Shards of the run whose results were not merged */
+                std::vector<size_t> missing_shards() const;
+                /* Distributions of descriptors of the rings, kept by the
+                   run as they are analysed (not by add) */
+                const Descriptor_statistics &get_statistics() const;
+                void set_statistics(const Descriptor_statistics &_statistics);
+        private:
+                std::map<std::string, short> conformations;
+                std::vector<size_t> counts;
+                std::map<size_t, Ring_result> results;
+                Descriptor_statistics statistics;
+                size_t shards;
+                std::vector<bool> present;
+};
+
+#endif
@@ -4,7 +4,8 @@
 
 using namespace std;
 
-Plane_3D::Plane_3D(double _a, double _b, double _c, double _d)
+template<typename T>
+Plane_3D_t<T>::Plane_3D_t(T _a, T _b, T _c, T _d)
 {
         a = _a;
         b = _b;
@@ -13,23 +14,27 @@ Plane_3D::Plane_3D(double _a, double _b, double _c, double _d)
 }
 
 
-Plane_3D::Plane_3D(const Vector_3D &normal, double _d)
+template<typename T>
+Plane_3D_t<T>::Plane_3D_t(const Vector_3D_t<T> &normal, T _d)
 {
         init(normal, _d);
 }
 
 
-Plane_3D::Plane_3D(const Point_3D &A, const Point_3D &B, const Point_3D &C)
+template<typename T>
+Plane_3D_t<T>::Plane_3D_t(const Point_3D_t<T> &A, const Point_3D_t<T> &B,
+                          const Point_3D_t<T> &C)
 {
-        Vector_3D _u = Vector_3D(B, A);
-        Vector_3D _v = Vector_3D(B, C);
-        Vector_3D normal = Vector_3D::cross(_u, _v);
-        double _d = -(normal.X * A.X + normal.Y * A.Y + normal.Z * A.Z);
+        Vector_3D_t<T> _u = Vector_3D_t<T>(B, A);
+        Vector_3D_t<T> _v = Vector_3D_t<T>(B, C);
+        Vector_3D_t<T> normal = Vector_3D_t<T>::cross(_u, _v);
+        T _d = -(normal.X * A.X + normal.Y * A.Y + normal.Z * A.Z);
         init(normal, _d);
 }
 
 
-void Plane_3D::init(const Vector_3D &normal, double _d)
+template<typename T>
+void Plane_3D_t<T>::init(const Vector_3D_t<T> &normal, T _d)
 {
         a = normal.X;
         b = normal.Y;
@@ -39,13 +44,19 @@ void Plane_3D::init(const Vector_3D &normal, double _d)
 
 
 
-double Plane_3D::distance_from(const Point_3D &poi) const
+template<typename T>
+T Plane_3D_t<T>::distance_from(const Point_3D_t<T> &poi) const
 {
         return (a * poi.X + b * poi.Y + c * poi.Z + d) / sqrt(a*a + b*b + c*c);
 }
 
 
-bool Plane_3D::is_on_plane(const Point_3D &poi, const double tolerance) const
+template<typename T>
+bool Plane_3D_t<T>::is_on_plane(const Point_3D_t<T> &poi, const T tolerance) const
 {
         return abs(distance_from(poi)) <= tolerance;
 }
+
+
+template class Plane_3D_t<float>;
+template class Plane_3D_t<double>;
@@ -4,20 +4,27 @@
 #include "vector_3D.h"
 
 
-class Plane_3D
+template<typename T>
+class Plane_3D_t
 {
         public:
-                Plane_3D(double _a, double _b, double _c, double _d);
-                Plane_3D(const Vector_3D &normal, double _d);
-                Plane_3D(const Point_3D &A,
-                         const Point_3D &B,
-                         const Point_3D &C);
-                double distance_from(const Point_3D &poi) const;
-                bool is_on_plane(const Point_3D &poi, double tolerance) const;
+                Plane_3D_t(T _a, T _b, T _c, T _d);
+                Plane_3D_t(const Vector_3D_t<T> &normal, T _d);
+                Plane_3D_t(const Point_3D_t<T> &A,
+                           const Point_3D_t<T> &B,
+                           const Point_3D_t<T> &C);
+                T distance_from(const Point_3D_t<T> &poi) const;
+                bool is_on_plane(const Point_3D_t<T> &poi, T tolerance) const;
         private:
-                void init(const Vector_3D &normal, const double _d);
-                double a, b, c, d;
+                void init(const Vector_3D_t<T> &normal, const T _d);
+                T a, b, c, d;
 };
 
+extern template class Plane_3D_t<float>;
+extern template class Plane_3D_t<double>;
+
+typedef Plane_3D_t<double> Plane_3D;
+typedef Plane_3D_t<float> Plane_3Df;
+
 
 #endif
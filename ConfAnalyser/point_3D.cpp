@@ -3,7 +3,8 @@
 
 using namespace std;
 
-Point_3D::Point_3D(double X_arg, double Y_arg, double Z_arg)
+template<typename T>
+Point_3D_t<T>::Point_3D_t(T X_arg, T Y_arg, T Z_arg)
 {
         X = X_arg;
         Y = Y_arg;
@@ -11,7 +12,12 @@ Point_3D::Point_3D(double X_arg, double Y_arg, double Z_arg)
 }
 
 
-double Point_3D::distance_from(const Point_3D &A, const Point_3D &B)
+template<typename T>
+T Point_3D_t<T>::distance_from(const Point_3D_t &A, const Point_3D_t &B)
 {
         return hypot(hypot(A.X - B.X, A.Y - B.Y), A.Z - B.Z);
 }
+
+
+template struct Point_3D_t<float>;
+template struct Point_3D_t<double>;
@@ -1,14 +1,23 @@
 #ifndef POINT_3D_H
 #define POINT_3D_H
 
-struct Point_3D
+/* Point of scalar type T, Point_3D (double) is used by the analysers,
+   single precision is instantiated for batch classification */
+template<typename T>
+struct Point_3D_t
 {
         /* Constructor */
-        Point_3D(double X_arg = 0, double Y_arg = 0, double Z_arg = 0);
+        Point_3D_t(T X_arg = 0, T Y_arg = 0, T Z_arg = 0);
         /* Methodes */
-        static double distance_from(const Point_3D &A, const Point_3D &B);
+        static T distance_from(const Point_3D_t &A, const Point_3D_t &B);
         /* Coordinates */
-        double X,Y,Z;
+        T X,Y,Z;
 };
 
+extern template struct Point_3D_t<float>;
+extern template struct Point_3D_t<double>;
+
+typedef Point_3D_t<double> Point_3D;
+typedef Point_3D_t<float> Point_3Df;
+
 #endif
@@ -0,0 +1,336 @@
+#include "quantile_sketch.h"
+#include "helper_functions.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <sstream>
+#include <utility>
+
+using namespace std;
+
+/* Ratio of capacities of neighbouring levels */
+#define CAPACITY_RATIO (2.0 / 3.0)
+/* Smallest capacity of a level */
+#define MIN_CAPACITY 2
+
+
+/* Comma separated numbers of a field */
+static bool parse_values(const string &field, vector<double> &values)
+{
+        values.clear();
+        istringstream ss(field);
+        string number;
+        while (getline(ss, number, ',')) {
+                char *end = nullptr;
+                values.push_back(strtod(number.c_str(), &end));
+                if (number.empty() || *end != '\0') {
+                        return false;
+                }
+        }
+        return true;
+}
+
+
+static bool parse_number(const string &field, uint64_t &value)
+{
+        char *end = nullptr;
+        if (field.empty() || field[0] == '-') {
+                return false;
+        }
+        value = strtoull(field.c_str(), &end, 10);
+        return *end == '\0';
+}
+
+
+static bool parse_number(const string &field, double &value)
+{
+        char *end = nullptr;
+        if (field.empty()) {
+                return false;
+        }
+        value = strtod(field.c_str(), &end);
+        return *end == '\0';
+}
+
+
+Quantile_sketch::Quantile_sketch(uint64_t stream, size_t _k)
+{
+        k = _k;
+        count = 0;
+        size = 0;
+        coins = stream * SKETCH_STREAM;
+        min = NAN;
+        max = NAN;
+        levels.resize(1);
+        limit = capacity(0);
+}
+
+
+size_t Quantile_sketch::capacity(size_t level) const
+{
+        size_t depth = levels.size() - 1 - level;
+        size_t result = static_cast<size_t>(
+                        ceil(k * pow(CAPACITY_RATIO, static_cast<double>(depth))));
+        return std::max(result, static_cast<size_t>(MIN_CAPACITY));
+}
+
+
+void Quantile_sketch::compress()
+{
+        /* levels are compacted from the bottom, so that the promoted values
+           are compacted further in the same pass if needed */
+        for (size_t h = 0; h < levels.size(); h++) {
+                if (levels[h].size() < capacity(h)) {
+                        continue;
+                }
+                if (h + 1 == levels.size()) {
+                        levels.emplace_back();
+                }
+                vector<double> &level = levels[h];
+                vector<double> &next = levels[h + 1];
+                sort(level.begin(), level.end());
+
+                /* odd value out stays in the level */
+                size_t even = level.size() & ~static_cast<size_t>(1);
+                for (size_t i = random_value(coins++) & 1; i < even; i += 2) {
+                        next.push_back(level[i]);
+                }
+                if (even < level.size()) {
+                        level[0] = level[even];
+                        level.resize(1);
+                } else {
+                        level.clear();
+                }
+        }
+
+        size = 0;
+        limit = 0;
+        for (size_t h = 0; h < levels.size(); h++) {
+                size += levels[h].size();
+                limit += capacity(h);
+        }
+}
+
+
+void Quantile_sketch::add(double value)
+{
+        if (count == 0 || value < min) {
+                min = value;
+        }
+        if (count == 0 || value > max) {
+                max = value;
+        }
+        count++;
+        levels[0].push_back(value);
+        size++;
+        if (size >= limit) {
+                compress();
+        }
+}
+
+
+void Quantile_sketch::merge(const Quantile_sketch &other)
+{
+        if (other.count == 0) {
+                return;
+        }
+        if (count == 0 || other.min < min) {
+                min = other.min;
+        }
+        if (count == 0 || other.max > max) {
+                max = other.max;
+        }
+        count += other.count;
+
+        if (levels.size() < other.levels.size()) {
+                levels.resize(other.levels.size());
+        }
+        for (size_t h = 0; h < other.levels.size(); h++) {
+                levels[h].insert(levels[h].end(), other.levels[h].begin(),
+                                 other.levels[h].end());
+        }
+        compress();
+}
+
+
+size_t Quantile_sketch::get_count() const
+{
+        return count;
+}
+
+
+double Quantile_sketch::quantile(double rank) const
+{
+        if (count == 0) {
+                return NAN;
+        }
+        if (rank <= 0) {
+                return min;
+        }
+        if (rank >= 1) {
+                return max;
+        }
+
+        /* retained values weighted by 2^level, the weights sum to count */
+        vector<pair<double, size_t>> values;
+        values.reserve(size);
+        for (size_t h = 0; h < levels.size(); h++) {
+                for (double x : levels[h]) {
+                        values.emplace_back(x, static_cast<size_t>(1) << h);
+                }
+        }
+        sort(values.begin(), values.end());
+
+        double target = rank * count;
+        size_t weight = 0;
+        for (const auto &x : values) {
+                weight += x.second;
+                if (weight >= target) {
+                        return x.first;
+                }
+        }
+        return max;
+}
+
+
+double Quantile_sketch::rank(double value) const
+{
+        if (count == 0) {
+                return NAN;
+        }
+        size_t weight = 0;
+        for (size_t h = 0; h < levels.size(); h++) {
+                for (double x : levels[h]) {
+                        if (x <= value) {
+                                weight += static_cast<size_t>(1) << h;
+                        }
+                }
+        }
+        return static_cast<double>(weight) / count;
+}
+
+
+void Quantile_sketch::write(ostream &out) const
+{
+        out << count << '\t' << coins << '\t' << min << '\t' << max;
+        for (const auto &level : levels) {
+                out << '\t';
+                for (size_t i = 0; i < level.size(); i++) {
+                        out << (i == 0 ? "" : ",") << level[i];
+                }
+        }
+}
+
+
+bool Quantile_sketch::read(const vector<string> &fields, size_t first)
+{
+        uint64_t _count, _coins;
+        double _min, _max;
+        if (fields.size() < first + 5 || !parse_number(fields[first], _count) ||
+            !parse_number(fields[first + 1], _coins) ||
+            !parse_number(fields[first + 2], _min) ||
+            !parse_number(fields[first + 3], _max)) {
+                return false;
+        }
+
+        /* retained values weigh 2^level, their weights sum to the count */
+        vector<vector<double>> _levels(fields.size() - first - 4);
+        uint64_t weight = 0;
+        for (size_t h = 0; h < _levels.size(); h++) {
+                if (!parse_values(fields[first + 4 + h], _levels[h]) ||
+                    h >= 64 || _levels[h].size() > (_count >> h)) {
+                        return false;
+                }
+                weight += static_cast<uint64_t>(_levels[h].size()) << h;
+        }
+        if (weight != _count) {
+                return false;
+        }
+
+        count = _count;
+        coins = _coins;
+        min = _min;
+        max = _max;
+        levels.swap(_levels);
+        size = 0;
+        limit = 0;
+        for (size_t h = 0; h < levels.size(); h++) {
+                size += levels[h].size();
+                limit += capacity(h);
+        }
+        if (size >= limit) {
+                compress();
+        }
+        return true;
+}
+
+
+Histogram::Histogram(double _low, double _high, size_t _bins)
+        : counts(_bins + 2, 0)
+{
+        low = _low;
+        high = _high;
+        bins = _bins;
+}
+
+
+void Histogram::add(double value)
+{
+        if (value < low) {
+                counts[0]++;
+        } else if (value >= high) {
+                counts[bins + 1]++;
+        } else {
+                size_t bin = static_cast<size_t>((value - low) /
+                                                 (high - low) * bins);
+                counts[std::min(bin, bins - 1) + 1]++;
+        }
+}
+
+
+void Histogram::merge(const Histogram &other)
+{
+        for (size_t i = 0; i < counts.size() && i < other.counts.size(); i++) {
+                counts[i] += other.counts[i];
+        }
+}
+
+
+const vector<size_t> &Histogram::get_counts() const
+{
+        return counts;
+}
+
+
+double Histogram::edge(size_t bin) const
+{
+        return low + (high - low) * (bin - 1) / bins;
+}
+
+
+void Histogram::write(ostream &out) const
+{
+        for (size_t i = 0; i < counts.size(); i++) {
+                out << (i == 0 ? "" : ",") << counts[i];
+        }
+}
+
+
+bool Histogram::read(const string &field)
+{
+        vector<size_t> read_counts;
+        istringstream ss(field);
+        string number;
+        while (getline(ss, number, ',')) {
+                uint64_t value;
+                if (!parse_number(number, value)) {
+                        return false;
+                }
+                read_counts.push_back(value);
+        }
+        if (read_counts.size() != counts.size()) {
+                return false;
+        }
+        counts.swap(read_counts);
+        return true;
+}
@@ -0,0 +1,86 @@
+#ifndef QUANTILE_SKETCH_H
+#define QUANTILE_SKETCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/* Size of the largest compactor of sketches, rank error is about 1.7 / K */
+#define SKETCH_K 200
+/* Positions of the generator reserved for one sketch */
+#define SKETCH_STREAM (static_cast<uint64_t>(1) << 24)
+
+/*
+ * Streaming quantile sketch (KLL - Karnin Z., Lang K., Liberty E.: Optimal
+ * quantile approximation in streams, FOCS 2016). Values are kept in levels
+ * of compactors, a full level is sorted and every other of its values
+ * (odd or even ones by random coin) is promoted to the next level with
+ * twice the weight. Capacities of lower levels shrink geometrically, so
+ * the sketch keeps O(K log(n / K)) values of n added. Sketches of parts of
+ * the data merge by joining their levels. Coins are drawn from the given
+ * stream of the counter based generator, so the sketch of the same values
+ * is always the same.
+ */
+class Quantile_sketch
+{
+        public:
+                Quantile_sketch(uint64_t stream = 0, size_t _k = SKETCH_K);
+                void add(double value);
+                void merge(const Quantile_sketch &other);
+                size_t get_count() const;
+                /* Value of the rank (0 - 1), exact minimum and maximum for
+                   ranks 0 and 1, NAN if nothing was added */
+                double quantile(double rank) const;
+                /* Fraction of added values lower than or equal to value */
+                double rank(double value) const;
+                /* State of the sketch as tab separated fields - count,
+                   position of the coins, minimum, maximum and comma
+                   separated values of every level */
+                void write(std::ostream &out) const;
+                /* Restore the state from fields written by write, false if
+                   they are damaged */
+                bool read(const std::vector<std::string> &fields,
+                          size_t first);
+        private:
+                size_t capacity(size_t level) const;
+                void compress();
+                size_t k;
+                size_t count;
+                /* number of retained values and limit of their number */
+                size_t size;
+                size_t limit;
+                uint64_t coins;
+                double min;
+                double max;
+                std::vector<std::vector<double>> levels;
+};
+
+/*
+ * Counts of values in bins of equal width between low and high, values
+ * out of the range are counted in the first and last bin (under, over).
+ */
+class Histogram
+{
+        public:
+                Histogram(double _low = 0, double _high = 1, size_t _bins = 10);
+                void add(double value);
+                void merge(const Histogram &other);
+                /* Counts of bins, under the range first and over it last */
+                const std::vector<size_t> &get_counts() const;
+                /* Lower edge of the bin (1 .. bins) */
+                double edge(size_t bin) const;
+                /* Comma separated counts of the bins */
+                void write(std::ostream &out) const;
+                /* Restore counts written by write, false if the field is
+                   damaged or has other number of bins */
+                bool read(const std::string &field);
+        private:
+                double low;
+                double high;
+                size_t bins;
+                std::vector<size_t> counts;
+};
+
+#endif
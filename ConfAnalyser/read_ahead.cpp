@@ -0,0 +1,122 @@
+#include "read_ahead.h"
+#include "conf_analyser.h"
+#include <sys/stat.h>
+
+using namespace std;
+
+
+Read_ahead::Read_ahead(const vector<string> &_files, size_t _depth,
+                       size_t _memory_budget, size_t threads)
+        : files(_files), slots(_depth == 0 ? 1 : _depth)
+{
+        memory_budget = _memory_budget;
+        memory_used = 0;
+        next_to_read = 0;
+        next_to_reserve = 0;
+        next_to_consume = 0;
+        stopping = false;
+        for (auto &x : slots) {
+                x.state = SLOT_FREE;
+        }
+
+        for (size_t i = 0; i < (threads == 0 ? 1 : threads); i++) {
+                readers.emplace_back(&Read_ahead::reader, this);
+        }
+}
+
+
+Read_ahead::~Read_ahead()
+{
+        {
+                lock_guard<mutex> lock(slots_mutex);
+                stopping = true;
+        }
+        changed.notify_all();
+        for (auto &x : readers) {
+                x.join();
+        }
+}
+
+
+void Read_ahead::reader()
+{
+        unique_lock<mutex> lock(slots_mutex);
+        while (true) {
+                /* wait for a free slot */
+                changed.wait(lock, [this]{
+                        return stopping || next_to_read >= files.size() ||
+                               slots[next_to_read % slots.size()].state == SLOT_FREE;
+                });
+                if (stopping || next_to_read >= files.size()) {
+                        return;
+                }
+
+                size_t index = next_to_read++;
+                Slot &slot = slots[index % slots.size()];
+                slot.state = SLOT_READING;
+                lock.unlock();
+                struct stat info;
+                size_t size = (stat(files[index].c_str(), &info) == 0) ?
+                              info.st_size : 0;
+                lock.lock();
+
+                /* memory is reserved in the order of the list, so that it
+                   is held only by files to be consumed before this one */
+                changed.wait(lock, [&]{
+                        return stopping || (next_to_reserve == index &&
+                               (memory_used + size <= memory_budget ||
+                                memory_used == 0));
+                });
+                if (stopping) {
+                        return;
+                }
+                memory_used += size;
+                next_to_reserve++;
+                changed.notify_all();
+
+                /* buffer of the slot keeps its capacity between files */
+                lock.unlock();
+                slot.entry.file_name = files[index];
+                slot.entry.success = Conf_analyser::read_file(files[index],
+                                                        slot.entry.content);
+                if (!slot.entry.success) {
+                        slot.entry.content.clear();
+                }
+                lock.lock();
+
+                /* the file may have changed since stat */
+                memory_used = memory_used - size + slot.entry.content.size();
+                slot.state = SLOT_READY;
+                changed.notify_all();
+        }
+}
+
+
+const Read_ahead_entry *Read_ahead::next()
+{
+        unique_lock<mutex> lock(slots_mutex);
+        if (next_to_consume >= files.size()) {
+                return nullptr;
+        }
+
+        Slot &slot = slots[next_to_consume % slots.size()];
+        changed.wait(lock, [&slot]{ return slot.state == SLOT_READY; });
+
+        return &slot.entry;
+}
+
+
+void Read_ahead::release(const Read_ahead_entry *entry)
+{
+        {
+                lock_guard<mutex> lock(slots_mutex);
+                Slot &slot = slots[next_to_consume % slots.size()];
+                if (entry != &slot.entry) {
+                        return;
+                }
+                memory_used -= slot.entry.content.size();
+                slot.state = SLOT_FREE;
+                next_to_consume++;
+        }
+        changed.notify_all();
+}
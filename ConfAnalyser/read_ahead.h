@@ -0,0 +1,62 @@
+#ifndef READ_AHEAD_H
+#define READ_AHEAD_H
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/* File loaded to memory by Read_ahead */
+struct Read_ahead_entry
+{
+        std::string file_name;
+        std::string content;
+        bool success;
+};
+
+/*
+ * Pipeline reading files of a list ahead of their processing. Dedicated
+ * I/O threads load up to `depth` following files into reusable buffers
+ * while the consumer works on the current one. Size of a file is reserved
+ * from `memory_budget` bytes before it is read, in the order of the list,
+ * and the reading waits until the reservation fits (a file larger than
+ * the whole budget is read once nothing else is held). Entries are handed
+ * over in the order of the list.
+ */
+class Read_ahead
+{
+        public:
+                Read_ahead(const std::vector<std::string> &_files,
+                           size_t _depth, size_t _memory_budget,
+                           size_t threads = 1);
+                ~Read_ahead();
+                /* Next file of the list, nullptr after the last one; the
+                   entry stays valid until it is released */
+                const Read_ahead_entry *next();
+                void release(const Read_ahead_entry *entry);
+        private:
+                static const int SLOT_FREE = 0;
+                static const int SLOT_READING = 1;
+                static const int SLOT_READY = 2;
+                struct Slot
+                {
+                        Read_ahead_entry entry;
+                        int state;
+                };
+                void reader();
+                const std::vector<std::string> &files;
+                std::vector<Slot> slots;
+                std::vector<std::thread> readers;
+                size_t memory_budget;
+                size_t memory_used;
+                size_t next_to_read;
+                /* first read file without its memory reserved */
+                size_t next_to_reserve;
+                size_t next_to_consume;
+                bool stopping;
+                std::mutex slots_mutex;
+                std::condition_variable changed;
+};
+
+#endif
@@ -0,0 +1,362 @@
+#include "result_diff.h"
+#include "partial_result.h"
+#include "output_sink.h"
+#include "helper_functions.h"
+#include <algorithm>
+#include <iomanip>
+
+using namespace std;
+
+/* Formats of the result sets */
+#define DIFF_PARTIAL 0
+#define DIFF_CSV     1
+
+/* Header of csv results, fields of the key and conformation come first */
+#define CSV_HEADER "file,ligand,chain,residue,conformation_code,conformation"
+/* Initial number of slots of the hash table (power of 2) */
+#define INITIAL_SLOTS 1024
+/* Largest occupied fraction of slots is MAX_LOAD / 4 */
+#define MAX_LOAD 3
+/* Name of absent ring in the matrix of transitions */
+#define ABSENT "-"
+
+/* Entry states */
+#define UNMATCHED 0
+#define MATCHED   1
+#define SEEN      2
+
+
+/* Field without surrounding spaces */
+static string trimmed(const string &field)
+{
+        size_t first = field.find_first_not_of(' ');
+        if (first == string::npos) {
+                return string();
+        }
+        size_t last = field.find_last_not_of(' ');
+        return field.substr(first, last - first + 1);
+}
+
+
+/* First count fields of a line separated by given character, fields of
+   csv may be quoted (with doubled quotes inside) */
+static void split_fields(const string &line, char separator, bool quoted,
+                         size_t count, vector<string> &fields)
+{
+        fields.clear();
+        string field;
+        bool in_quotes = false;
+        for (size_t i = 0; i < line.size() && fields.size() < count; i++) {
+                char c = line[i];
+                if (quoted && c == '"') {
+                        if (in_quotes && i + 1 < line.size() &&
+                            line[i + 1] == '"') {
+                                field += '"';
+                                i++;
+                        } else {
+                                in_quotes = !in_quotes;
+                        }
+                } else if (c == separator && !in_quotes) {
+                        fields.push_back(field);
+                        field.clear();
+                } else {
+                        field += c;
+                }
+        }
+        if (fields.size() < count) {
+                fields.push_back(field);
+        }
+}
+
+
+/* FNV-1a of the key mixed by SplitMix64, 0 marks empty slots */
+static uint64_t key_hash(const Diff_record &record)
+{
+        uint64_t hash = 0xcbf29ce484222325ULL;
+        for (const string *x : {&record.file, &record.ligand, &record.chain,
+                                &record.residue}) {
+                for (unsigned char c : *x) {
+                        hash = (hash ^ c) * 0x100000001b3ULL;
+                }
+                hash = (hash ^ '\t') * 0x100000001b3ULL;
+        }
+        hash = random_value(hash);
+        return hash == 0 ? 1 : hash;
+}
+
+
+/* Key of the ring in lines of differences */
+static void print_key(ostream &out, const Diff_record &record)
+{
+        out << record.file << ' ' << record.ligand << ' '
+            << (record.chain.empty() ? ABSENT : record.chain) << ' '
+            << record.residue;
+}
+
+
+Result_diff::Result_diff()
+{
+        entries = 0;
+        line_number = 0;
+        failed = false;
+        names.push_back(ABSENT);
+}
+
+
+bool Result_diff::open(ifstream &in, const string &file_name, int &format)
+{
+        in.open(file_name);
+        string header;
+        if (!in.is_open() || !getline(in, header)) {
+                diagnostics() << "Error while opening file " << file_name << '\n';
+                return false;
+        }
+        line_number = 1;
+        if (header == PARTIAL_MAGIC) {
+                format = DIFF_PARTIAL;
+        } else if (header.compare(0, string(CSV_HEADER).size(), CSV_HEADER) == 0) {
+                format = DIFF_CSV;
+        } else {
+                diagnostics() << file_name << ": not a partial result nor csv result!\n";
+                return false;
+        }
+        return true;
+}
+
+
+bool Result_diff::read(istream &in, int format, Diff_record &record,
+                       const string &file_name)
+{
+        while (getline(in, line)) {
+                line_number++;
+                /* the same fields of both formats, partial results have
+                   tag and index of the file first */
+                size_t first = 0;
+                if (format == DIFF_PARTIAL) {
+                        if (line.compare(0, 7, "result\t") != 0) {
+                                continue;
+                        }
+                        first = 2;
+                        split_fields(line, '\t', false, first + 6, fields);
+                        for (auto &x : fields) {
+                                x = unescape_field(x);
+                        }
+                } else {
+                        split_fields(line, ',', true, first + 6, fields);
+                }
+
+                if (fields.size() < first + 6) {
+                        diagnostics() << file_name << ':' << line_number
+                                      << ": invalid line of result!\n";
+                        failed = true;
+                        return false;
+                }
+                size_t sep = fields[first].find_last_of('/');
+                record.file = (sep == string::npos) ? fields[first] :
+                              fields[first].substr(sep + 1);
+                record.ligand = trimmed(fields[first + 1]);
+                record.chain = trimmed(fields[first + 2]);
+                record.residue = fields[first + 3];
+                record.conformation = fields[first + 5];
+                return true;
+        }
+        return false;
+}
+
+
+void Result_diff::insert(uint64_t hash, short conformation)
+{
+        /* table is kept at most MAX_LOAD / 4 full */
+        if (4 * (entries + 1) > MAX_LOAD * table.size()) {
+                vector<Entry> old(max(2 * table.size(),
+                                      static_cast<size_t>(INITIAL_SLOTS)),
+                                  Entry{0, 0, UNMATCHED});
+                /* entries are moved to the larger table */
+                old.swap(table);
+                entries = 0;
+                for (const auto &x : old) {
+                        if (x.hash != 0) {
+                                insert(x.hash, x.conformation);
+                        }
+                }
+        }
+
+        /* equal hashes stay in the order of insertion */
+        size_t mask = table.size() - 1;
+        size_t slot = hash & mask;
+        while (table[slot].hash != 0) {
+                slot = (slot + 1) & mask;
+        }
+        table[slot] = Entry{hash, conformation, UNMATCHED};
+        entries++;
+}
+
+
+Result_diff::Entry *Result_diff::find(uint64_t hash, char below)
+{
+        if (table.empty()) {
+                return nullptr;
+        }
+        size_t mask = table.size() - 1;
+        for (size_t slot = hash & mask; table[slot].hash != 0;
+             slot = (slot + 1) & mask) {
+                if (table[slot].hash == hash && table[slot].state < below) {
+                        return &table[slot];
+                }
+        }
+        return nullptr;
+}
+
+
+short Result_diff::code(const string &conformation)
+{
+        auto itr = conformations.find(conformation);
+        if (itr != conformations.end()) {
+                return itr->second;
+        }
+        short result = static_cast<short>(names.size());
+        conformations[conformation] = result;
+        names.push_back(conformation);
+        return result;
+}
+
+
+void Result_diff::count(short from, short to)
+{
+        size_t size = static_cast<size_t>(max(from, to)) + 1;
+        if (size > transitions.size()) {
+                transitions.resize(size);
+                for (auto &x : transitions) {
+                        x.resize(size, 0);
+                }
+        }
+        transitions[from][to]++;
+}
+
+
+bool Result_diff::compare(const string &old_file, const string &new_file,
+                          ostream *list)
+{
+        ifstream in;
+        int format;
+        Diff_record record;
+
+        /* hashes of keys of the old set */
+        if (!open(in, old_file, format)) {
+                return false;
+        }
+        while (read(in, format, record, old_file)) {
+                insert(key_hash(record), code(record.conformation));
+        }
+        if (failed) {
+                return false;
+        }
+        in.close();
+
+        /* changed and added rings */
+        ifstream in_new;
+        if (!open(in_new, new_file, format)) {
+                return false;
+        }
+        while (read(in_new, format, record, new_file)) {
+                short to = code(record.conformation);
+                Entry *entry = find(key_hash(record), MATCHED);
+                if (entry == nullptr) {
+                        count(0, to);
+                        if (list != nullptr) {
+                                *list << "+ ";
+                                print_key(*list, record);
+                                *list << ": " << record.conformation << '\n';
+                        }
+                        continue;
+                }
+                entry->state = MATCHED;
+                count(entry->conformation, to);
+                if (entry->conformation != to && list != nullptr) {
+                        *list << "~ ";
+                        print_key(*list, record);
+                        *list << ": " << names[entry->conformation] << " -> "
+                              << record.conformation << '\n';
+                }
+        }
+        if (failed) {
+                return false;
+        }
+
+        /* removed rings, the old set is read again for their keys */
+        ifstream in_old;
+        if (!open(in_old, old_file, format)) {
+                return false;
+        }
+        while (read(in_old, format, record, old_file)) {
+                Entry *entry = find(key_hash(record), SEEN);
+                if (entry == nullptr) {
+                        continue;
+                }
+                if (entry->state == UNMATCHED) {
+                        count(entry->conformation, 0);
+                        if (list != nullptr) {
+                                *list << "- ";
+                                print_key(*list, record);
+                                *list << ": " << record.conformation << '\n';
+                        }
+                }
+                entry->state = SEEN;
+        }
+
+        return !failed;
+}
+
+
+void Result_diff::print_transitions(ostream &out) const
+{
+        out << "TRANSITIONS (old in rows, new in columns)\n-------\n";
+
+        /* absent rings first, then conformations sorted by names */
+        vector<short> order = {0};
+        for (const auto &x : conformations) {
+                order.push_back(x.second);
+        }
+        size_t width = 0;
+        for (const auto &x : names) {
+                width = max(width, x.size());
+        }
+        width += 2;
+
+        auto cell = [&](short from, short to) {
+                return (static_cast<size_t>(max(from, to)) < transitions.size()) ?
+                       transitions[from][to] : 0;
+        };
+
+        size_t unchanged = 0, changed = 0, added = 0, removed = 0;
+        out << setw(width) << left << "";
+        for (short to : order) {
+                out << setw(max(names[to].size() + 2, static_cast<size_t>(10)))
+                    << right << names[to];
+        }
+        out << '\n';
+        for (short from : order) {
+                out << setw(width) << left << names[from];
+                for (short to : order) {
+                        size_t n = cell(from, to);
+                        out << setw(max(names[to].size() + 2,
+                                        static_cast<size_t>(10)))
+                            << right << n;
+                        if (from == 0) {
+                                added += n;
+                        } else if (to == 0) {
+                                removed += n;
+                        } else if (from == to) {
+                                unchanged += n;
+                        } else {
+                                changed += n;
+                        }
+                }
+                out << '\n';
+        }
+
+        out << "\nUNCHANGED:    " << unchanged
+            << "\nCHANGED:      " << changed
+            << "\nADDED:        " << added
+            << "\nREMOVED:      " << removed << '\n';
+}
@@ -0,0 +1,80 @@
+#ifndef RESULT_DIFF_H
+#define RESULT_DIFF_H
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <istream>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/* Ring of a result set, key of the ring is file name (without directory),
+   ligand, chain and residue number */
+struct Diff_record
+{
+        std::string file;
+        std::string ligand;
+        std::string chain;
+        std::string residue;
+        std::string conformation;
+};
+
+/*
+ * Differences of conformations of rings between two result sets (partial
+ * results or csv results, ConfAnalyser diff). Only 64-bit hashes of keys
+ * of the old set are kept in memory with codes of their conformations -
+ * the new set is streamed against them (changed and added rings) and then
+ * the old one once more (removed rings), so memory does not depend on the
+ * lengths of the keys nor on the new set. Lines of the differences are
+ *
+ *   ~ <file> <ligand> <chain> <residue>: <old> -> <new>
+ *   + <file> <ligand> <chain> <residue>: <new>
+ *   - <file> <ligand> <chain> <residue>: <old>
+ *
+ * followed by matrix of transitions of conformations of all the rings.
+ */
+class Result_diff
+{
+        public:
+                Result_diff();
+                /* Compare the sets, lines of differences are written to list
+                   if given, false on error (written to diagnostics) */
+                bool compare(const std::string &old_file,
+                             const std::string &new_file, std::ostream *list);
+                /* Counts of old x new conformation ("-" for absent rings) */
+                void print_transitions(std::ostream &out) const;
+        private:
+                struct Entry
+                {
+                        uint64_t hash;
+                        short conformation;
+                        /* not yet matched, matched by the new set, seen
+                           again while reading the old set */
+                        char state;
+                };
+                bool open(std::ifstream &in, const std::string &file_name,
+                          int &format);
+                bool read(std::istream &in, int format, Diff_record &record,
+                          const std::string &file_name);
+                void insert(uint64_t hash, short conformation);
+                /* First entry of the hash in state lower than given */
+                Entry *find(uint64_t hash, char below);
+                short code(const std::string &conformation);
+                void count(short from, short to);
+                std::vector<Entry> table;
+                size_t entries;
+                /* codes of conformations by names and names by codes */
+                std::map<std::string, short> conformations;
+                std::vector<std::string> names;
+                /* transitions[from][to], code 0 stands for absent ring */
+                std::vector<std::vector<size_t>> transitions;
+                /* buffers of read lines */
+                std::string line;
+                std::vector<std::string> fields;
+                size_t line_number;
+                bool failed;
+};
+
+#endif
@@ -0,0 +1,360 @@
+#include "result_writer.h"
+#include <cmath>
+#include <cstdio>
+
+using namespace std;
+
+
+/* Leading and trailing spaces of fixed-width PDB fields */
+static string trimmed(const string &s)
+{
+        size_t first = s.find_first_not_of(' ');
+        if (first == string::npos) {
+                return "";
+        }
+        size_t last = s.find_last_not_of(' ');
+        return s.substr(first, last - first + 1);
+}
+
+
+Result_writer::Result_writer(ostream &_out) : out(_out) {}
+
+
+Result_writer::~Result_writer() {}
+
+
+void Result_writer::begin() {}
+
+
+void Result_writer::finish() {}
+
+
+int Result_writer::format_from_name(const string &name)
+{
+        if (name == "text") {
+                return FORMAT_TEXT;
+        } else if (name == "csv") {
+                return FORMAT_CSV;
+        } else if (name == "json") {
+                return FORMAT_JSON;
+        } else if (name == "columnar") {
+                return FORMAT_COLUMNAR;
+        }
+
+        return -1;
+}
+
+
+Result_writer *Result_writer::create(int format, ostream &out)
+{
+        switch (format) {
+                case FORMAT_CSV:
+                        return new Csv_writer(out);
+                case FORMAT_JSON:
+                        return new Json_writer(out);
+                case FORMAT_COLUMNAR:
+                        return new Columnar_writer(out);
+                default:
+                        return nullptr;
+        }
+}
+
+
+void Result_writer::write_number(double number)
+{
+        char buffer[32];
+        int length = snprintf(buffer, sizeof(buffer), "%.4f", number);
+        out.write(buffer, length);
+}
+
+
+Csv_writer::Csv_writer(ostream &_out) : Result_writer(_out) {}
+
+
+void Csv_writer::begin()
+{
+        out << "file,ligand,chain,residue,conformation_code,conformation,"
+               "plane_distance,right_distance,left_distance,dihedral,"
+               "puckering_amplitude,theta,phi,confidence,"
+               "torsion_1,torsion_2,torsion_3,torsion_4,torsion_5,torsion_6\n";
+}
+
+
+void Csv_writer::write_field(const string &field)
+{
+        /* conformation names of oxane contain commas */
+        if (field.find_first_of(",\"\n") == string::npos) {
+                out << field;
+                return;
+        }
+
+        out << '"';
+        for (char c : field) {
+                if (c == '"') {
+                        out << '"';
+                }
+                out << c;
+        }
+        out << '"';
+}
+
+
+void Csv_writer::write(const Ring_result &result)
+{
+        write_field(result.structure);
+        out << ',';
+        write_field(trimmed(result.ligand));
+        out << ',';
+        if (result.chain_id != ' ') {
+                out << result.chain_id;
+        }
+        out << ',' << result.residue_number
+            << ',' << result.conformation << ',';
+        write_field(result.conformation_name);
+        for (double x : {result.descriptors.plane_distance,
+                         result.descriptors.right_distance,
+                         result.descriptors.left_distance,
+                         result.descriptors.dihedral,
+                         result.descriptors.puckering_amplitude,
+                         result.descriptors.theta,
+                         result.descriptors.phi}) {
+                out << ',';
+                write_number(x);
+        }
+        out << ',';
+        if (result.confidence >= 0) {
+                write_number(result.confidence);
+        }
+        /* five atom rings leave the last column empty */
+        for (size_t i = 0; i < MAX_RING_SIZE; i++) {
+                out << ',';
+                if (i < result.descriptors.ring_size) {
+                        write_number(result.descriptors.torsions[i]);
+                }
+        }
+        out << '\n';
+}
+
+
+Json_writer::Json_writer(ostream &_out) : Result_writer(_out) {}
+
+
+void Json_writer::write_string(const string &str)
+{
+        out << '"';
+        for (unsigned char c : str) {
+                if (c == '"' || c == '\\') {
+                        out << '\\' << c;
+                } else if (c < 0x20) {
+                        char buffer[8];
+                        snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+                        out << buffer;
+                } else {
+                        out << c;
+                }
+        }
+        out << '"';
+}
+
+
+void Json_writer::write(const Ring_result &result)
+{
+        out << "{\"file\":";
+        write_string(result.structure);
+        out << ",\"ligand\":";
+        write_string(trimmed(result.ligand));
+        out << ",\"chain\":";
+        write_string(result.chain_id == ' ' ? "" : string(1, result.chain_id));
+        out << ",\"residue\":" << result.residue_number
+            << ",\"conformation_code\":" << result.conformation
+            << ",\"conformation\":";
+        write_string(result.conformation_name);
+        out << ",\"plane_distance\":";
+        write_number(result.descriptors.plane_distance);
+        out << ",\"right_distance\":";
+        write_number(result.descriptors.right_distance);
+        out << ",\"left_distance\":";
+        write_number(result.descriptors.left_distance);
+        out << ",\"dihedral\":";
+        write_number(result.descriptors.dihedral);
+        out << ",\"puckering_amplitude\":";
+        write_number(result.descriptors.puckering_amplitude);
+        out << ",\"theta\":";
+        write_number(result.descriptors.theta);
+        out << ",\"phi\":";
+        write_number(result.descriptors.phi);
+        out << ",\"torsions\":[";
+        for (size_t i = 0; i < result.descriptors.ring_size; i++) {
+                if (i > 0) {
+                        out << ',';
+                }
+                write_number(result.descriptors.torsions[i]);
+        }
+        out << ']';
+        if (result.confidence >= 0) {
+                out << ",\"confidence\":";
+                write_number(result.confidence);
+        }
+        out << "}\n";
+}
+
+
+void Json_writer::write_error(const string &file, const string &message)
+{
+        out << "{\"file\":";
+        write_string(file);
+        out << ",\"error\":";
+        write_string(message);
+        out << "}\n";
+}
+
+
+Columnar_writer::Columnar_writer(ostream &_out) : Result_writer(_out) {}
+
+
+Columnar_writer::~Columnar_writer() {}
+
+
+template<typename T>
+void Columnar_writer::write_raw(const T &value)
+{
+        out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+
+template<typename T>
+void Columnar_writer::write_column(const vector<T> &column)
+{
+        out.write(reinterpret_cast<const char*>(column.data()),
+                  column.size() * sizeof(T));
+}
+
+
+void Columnar_writer::write_column(const vector<string> &column)
+{
+        uint32_t offset = 0;
+        write_raw(offset);
+        for (const auto &x : column) {
+                offset += x.size();
+                write_raw(offset);
+        }
+        for (const auto &x : column) {
+                out.write(x.data(), x.size());
+        }
+}
+
+
+void Columnar_writer::begin()
+{
+        static const pair<const char*, uint8_t> schema[] = {
+                {"file", TYPE_STRING},
+                {"ligand", TYPE_STRING},
+                {"chain", TYPE_INT8},
+                {"residue", TYPE_INT32},
+                {"conformation_code", TYPE_INT16},
+                {"conformation", TYPE_STRING},
+                {"plane_distance", TYPE_FLOAT64},
+                {"right_distance", TYPE_FLOAT64},
+                {"left_distance", TYPE_FLOAT64},
+                {"dihedral", TYPE_FLOAT64},
+                {"puckering_amplitude", TYPE_FLOAT64},
+                {"theta", TYPE_FLOAT64},
+                {"phi", TYPE_FLOAT64},
+                {"confidence", TYPE_FLOAT64},
+                {"torsion_1", TYPE_FLOAT64},
+                {"torsion_2", TYPE_FLOAT64},
+                {"torsion_3", TYPE_FLOAT64},
+                {"torsion_4", TYPE_FLOAT64},
+                {"torsion_5", TYPE_FLOAT64},
+                {"torsion_6", TYPE_FLOAT64}
+        };
+
+        out.write("CONFCOL1", 8);
+        write_raw(static_cast<uint32_t>(sizeof(schema) / sizeof(schema[0])));
+        for (auto x : schema) {
+                string name(x.first);
+                write_raw(static_cast<uint8_t>(name.size()));
+                out.write(name.data(), name.size());
+                write_raw(x.second);
+        }
+}
+
+
+void Columnar_writer::write(const Ring_result &result)
+{
+        structure.push_back(result.structure);
+        ligand.push_back(trimmed(result.ligand));
+        chain_id.push_back(result.chain_id);
+        residue_number.push_back(result.residue_number);
+        conformation.push_back(result.conformation);
+        conformation_name.push_back(result.conformation_name);
+        plane_distance.push_back(result.descriptors.plane_distance);
+        right_distance.push_back(result.descriptors.right_distance);
+        left_distance.push_back(result.descriptors.left_distance);
+        dihedral.push_back(result.descriptors.dihedral);
+        puckering_amplitude.push_back(result.descriptors.puckering_amplitude);
+        theta.push_back(result.descriptors.theta);
+        phi.push_back(result.descriptors.phi);
+        /* NaN if not estimated */
+        confidence.push_back(result.confidence >= 0 ? result.confidence : NAN);
+        for (size_t i = 0; i < MAX_RING_SIZE; i++) {
+                torsions[i].push_back(i < result.descriptors.ring_size ?
+                                      result.descriptors.torsions[i] : NAN);
+        }
+
+        if (structure.size() >= block_rows) {
+                flush_block();
+        }
+}
+
+
+void Columnar_writer::flush_block()
+{
+        if (structure.empty()) {
+                return;
+        }
+
+        write_raw(static_cast<uint32_t>(structure.size()));
+        write_column(structure);
+        write_column(ligand);
+        write_column(chain_id);
+        write_column(residue_number);
+        write_column(conformation);
+        write_column(conformation_name);
+        write_column(plane_distance);
+        write_column(right_distance);
+        write_column(left_distance);
+        write_column(dihedral);
+        write_column(puckering_amplitude);
+        write_column(theta);
+        write_column(phi);
+        write_column(confidence);
+        for (const auto &x : torsions) {
+                write_column(x);
+        }
+
+        structure.clear();
+        ligand.clear();
+        chain_id.clear();
+        residue_number.clear();
+        conformation.clear();
+        conformation_name.clear();
+        plane_distance.clear();
+        right_distance.clear();
+        left_distance.clear();
+        dihedral.clear();
+        puckering_amplitude.clear();
+        theta.clear();
+        phi.clear();
+        confidence.clear();
+        for (auto &x : torsions) {
+                x.clear();
+        }
+}
+
+
+void Columnar_writer::finish()
+{
+        flush_block();
+        write_raw(static_cast<uint32_t>(0));
+}
@@ -0,0 +1,114 @@
+#ifndef RESULT_WRITER_H
+#define RESULT_WRITER_H
+
+#include "molecule.h"
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/* Supported output formats */
+#define FORMAT_TEXT      0
+#define FORMAT_CSV       1
+#define FORMAT_JSON      2
+#define FORMAT_COLUMNAR  3
+
+/* Writer of machine-readable per-ring results. Records are terminated by
+   '\n' only, flushing is left to the underlying stream. */
+class Result_writer
+{
+        public:
+                Result_writer(std::ostream &_out);
+                virtual ~Result_writer();
+                virtual void begin();
+                virtual void write(const Ring_result &result) = 0;
+                virtual void finish();
+                /* Format given by its name, -1 if not known */
+                static int format_from_name(const std::string &name);
+                /* Writer of given format, nullptr for FORMAT_TEXT */
+                static Result_writer *create(int format, std::ostream &out);
+        protected:
+                /* Fixed-point number without the overhead of ostream */
+                void write_number(double number);
+                std::ostream &out;
+};
+
+
+/* Comma separated values with a header line */
+class Csv_writer : public Result_writer
+{
+        public:
+                Csv_writer(std::ostream &_out);
+                virtual void begin() override;
+                virtual void write(const Ring_result &result) override;
+        private:
+                void write_field(const std::string &field);
+};
+
+
+/* One JSON object per line */
+class Json_writer : public Result_writer
+{
+        public:
+                Json_writer(std::ostream &_out);
+                virtual void write(const Ring_result &result) override;
+                /* Object of a file which could not be analysed */
+                void write_error(const std::string &file,
+                                 const std::string &message);
+        private:
+                void write_string(const std::string &str);
+};
+
+
+/*
+ * Compact binary columnar format (native byte order):
+ *
+ *   "CONFCOL1"                                  magic
+ *   u32 column count, per column:
+ *      u8 name length, name, u8 type            schema
+ *   blocks of up to block_rows rows:
+ *      u32 row count, per column:
+ *         string  - u32 offsets[rows + 1], bytes
+ *         i8/i16/i32/f64 - rows values
+ *   u32 0                                       end of data
+ */
+class Columnar_writer : public Result_writer
+{
+        public:
+                /* Column types */
+                static const uint8_t TYPE_STRING = 0;
+                static const uint8_t TYPE_INT8 = 1;
+                static const uint8_t TYPE_INT16 = 2;
+                static const uint8_t TYPE_INT32 = 3;
+                static const uint8_t TYPE_FLOAT64 = 4;
+
+                Columnar_writer(std::ostream &_out);
+                virtual ~Columnar_writer();
+                virtual void begin() override;
+                virtual void write(const Ring_result &result) override;
+                virtual void finish() override;
+        private:
+                static const size_t block_rows = 65536;
+                void flush_block();
+                template<typename T> void write_raw(const T &value);
+                template<typename T> void write_column(const std::vector<T> &column);
+                void write_column(const std::vector<std::string> &column);
+                /* Columns of current block */
+                std::vector<std::string> structure;
+                std::vector<std::string> ligand;
+                std::vector<int8_t> chain_id;
+                std::vector<int32_t> residue_number;
+                std::vector<int16_t> conformation;
+                std::vector<std::string> conformation_name;
+                std::vector<double> plane_distance;
+                std::vector<double> right_distance;
+                std::vector<double> left_distance;
+                std::vector<double> dihedral;
+                std::vector<double> puckering_amplitude;
+                std::vector<double> theta;
+                std::vector<double> phi;
+                std::vector<double> confidence;
+                std::vector<double> torsions[MAX_RING_SIZE];
+};
+
+#endif
@@ -1,10 +1,270 @@
+#define _USE_MATH_DEFINES
+
 #include "ring.h"
+#include "torsion_classifier.h"
+#include "helper_functions.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
 
 using namespace std;
 
-Ring::Ring(string _structure) : Molecule(_structure)
+/* Trials of Monte Carlo estimate sharing one batch of noise (even) */
+#define CONFIDENCE_BATCH 256
+/* Deviation of atoms without temperature factor, in angstroms */
+#define DEFAULT_SIGMA 0.1
+
+Ring::Ring(string _structure, map<string, short> &_conformations)
+        : Molecule(_structure, _conformations)
+{
+        engine = ENGINE_GEOMETRIC;
+}
+
+
+void Ring::set_engine(int _engine)
+{
+        engine = _engine;
+}
+
+
+void Ring::recognize()
+{
+        if (engine == ENGINE_TORSION) {
+                classify_by_torsions();
+        } else {
+                classify();
+        }
+}
+
+
+void Ring::get_coordinates(double *coordinates)
+{
+        Atom **atoms = ring_atoms();
+        for (size_t j = 0; j < size(); j++) {
+                coordinates[3*j] = atoms[j]->X;
+                coordinates[3*j + 1] = atoms[j]->Y;
+                coordinates[3*j + 2] = atoms[j]->Z;
+        }
+}
+
+
+void Ring::classify_by_torsions()
 {
-        conformations.insert({"FLAT", 2});
-        has_plane = false;
-        begin = 0;
+        double coordinates[3 * MAX_RING_SIZE];
+        double torsions[MAX_RING_SIZE];
+        get_coordinates(coordinates);
+        ring_torsions(coordinates, 1, size(), torsions);
+        conformation = pattern_conformation(torsion_pattern(torsions, size()),
+                                            conformations);
+}
+
+
+template<typename T>
+void Ring::classify_rings(const T *coordinates, size_t ring_count,
+                          short *classes) const
+{
+        if (engine != ENGINE_TORSION) {
+                classify_geometric(coordinates, ring_count, classes);
+                return;
+        }
+
+        /* codes of the patterns are looked up once for the whole batch */
+        short codes[PATTERNS];
+        for (int i = 0; i < PATTERNS; i++) {
+                codes[i] = pattern_conformation(i, conformations);
+        }
+        vector<T> torsions(ring_count * size());
+        ring_torsions(coordinates, ring_count, size(), torsions.data());
+        for (size_t i = 0; i < ring_count; i++) {
+                classes[i] = codes[torsion_pattern(&torsions[i * size()],
+                                                   size())];
+        }
+}
+
+
+void Ring::classify_batch(const double *coordinates, size_t ring_count,
+                          short *classes) const
+{
+        classify_rings(coordinates, ring_count, classes);
+}
+
+
+void Ring::classify_batch(const float *coordinates, size_t ring_count,
+                          short *classes) const
+{
+        classify_rings(coordinates, ring_count, classes);
+}
+
+
+string Ring::class_name(short _class) const
+{
+        for (const auto &x : conformations) {
+                if (x.second == _class) {
+                        return x.first;
+                }
+        }
+        return string();
+}
+
+
+short Ring::class_conformation(short _class) const
+{
+        return _class;
+}
+
+
+short Ring::analysed_class() const
+{
+        return conformation;
+}
+
+
+void Ring::describe_torsions()
+{
+        double coordinates[3 * MAX_RING_SIZE];
+        get_coordinates(coordinates);
+        descriptors.ring_size = size();
+        ring_torsions(coordinates, 1, size(), descriptors.torsions);
+}
+
+
+/* Cremer D., Pople J. A.: A General Definition of Ring Puckering
+   Coordinates, J. Am. Chem. Soc. 1975, 97, 1354-1358 */
+template<typename T>
+void Ring::mean_plane(const Point_3D_t<T> * const *atoms, size_t count,
+                      Vector_3D_t<T> &center, Vector_3D_t<T> &normal)
+{
+        /* geometrical center of the ring */
+        center = Vector_3D_t<T>();
+        for (size_t j = 0; j < count; j++) {
+                center = center + Vector_3D_t<T>(*(atoms[j]));
+        }
+        center = center / count;
+
+        /* mean plane given by its normal */
+        Vector_3D_t<T> r_sin, r_cos;
+        for (size_t j = 0; j < count; j++) {
+                Vector_3D_t<T> r = Vector_3D_t<T>(*(atoms[j])) - center;
+                r_sin = r_sin + r * sin(2 * M_PI * j / count);
+                r_cos = r_cos + r * cos(2 * M_PI * j / count);
+        }
+        normal = Vector_3D_t<T>::cross(r_sin, r_cos);
+        normal = normal / normal.length();
+}
+
+template void Ring::mean_plane(const Point_3D_t<float> * const *atoms,
+                               size_t count, Vector_3D_t<float> &center,
+                               Vector_3D_t<float> &normal);
+template void Ring::mean_plane(const Point_3D_t<double> * const *atoms,
+                               size_t count, Vector_3D_t<double> &center,
+                               Vector_3D_t<double> &normal);
+
+
+void Ring::describe_puckering(Atom * const *atoms, size_t count)
+{
+        const Point_3D *points[MAX_RING_SIZE] = {nullptr};
+        for (size_t j = 0; j < count; j++) {
+                points[j] = atoms[j];
+        }
+        Vector_3D center, normal;
+        mean_plane(points, count, center, normal);
+
+        /* displacements of atoms from the mean plane */
+        double q_cos = 0, q_sin = 0, q_half = 0, amplitude = 0;
+        for (size_t j = 0; j < count; j++) {
+                double z = Vector_3D::dot(Vector_3D(*(atoms[j])) - center,
+                                          normal);
+                q_cos += z * cos(4 * M_PI * j / count);
+                q_sin -= z * sin(4 * M_PI * j / count);
+                q_half += (j % 2 == 0) ? z : -z;
+                amplitude += z * z;
+        }
+        double q2 = sqrt(2.0 / count) * hypot(q_cos, q_sin);
+
+        descriptors.puckering_amplitude = sqrt(amplitude);
+        descriptors.phi = atan2(q_sin, q_cos) * 180 / M_PI;
+        if (descriptors.phi < 0) {
+                descriptors.phi += 360;
+        }
+        descriptors.theta = (count % 2 == 0) ?
+                atan2(q2, sqrt(1.0 / count) * q_half) * 180 / M_PI : 0;
+}
+
+
+/* Batch of standard normal values (Box-Muller transform), count is even */
+static void gaussian_noise(double *noise, size_t count, uint64_t position)
+{
+        for (size_t i = 0; i < count; i++) {
+                /* uniform in (0, 1) */
+                noise[i] = ((random_value(position + i) >> 11) + 0.5) /
+                           9007199254740992.0;
+        }
+        for (size_t i = 0; i < count; i += 2) {
+                double radius = sqrt(-2 * log(noise[i]));
+                double angle = 2 * M_PI * noise[i + 1];
+                noise[i] = radius * cos(angle);
+                noise[i + 1] = radius * sin(angle);
+        }
+}
+
+
+void Ring::estimate_confidence(size_t trials, double sigma)
+{
+        if (!analysed || trials == 0) {
+                return;
+        }
+
+        size_t count = size();
+        Atom **atoms = ring_atoms();
+        vector<double> original(3 * count), sigmas(count);
+        for (size_t j = 0; j < count; j++) {
+                original[3*j] = atoms[j]->X;
+                original[3*j + 1] = atoms[j]->Y;
+                original[3*j + 2] = atoms[j]->Z;
+                /* B = 8 pi^2 <u^2> for isotropic displacement u */
+                if (sigma >= 0) {
+                        sigmas[j] = sigma;
+                } else if (atoms[j]->has_temp_factor()) {
+                        sigmas[j] = sqrt(max(atoms[j]->get_temp_factor(), 0.0) /
+                                         (8 * M_PI * M_PI));
+                } else {
+                        sigmas[j] = DEFAULT_SIGMA;
+                }
+        }
+        short expected = analysed_class();
+
+        /* stream of noise is given by the structure, estimates do not
+           depend on order of processing (FNV-1a) */
+        uint64_t seed = 14695981039346656037ULL;
+        for (unsigned char c : structure) {
+                seed = (seed ^ c) * 1099511628211ULL;
+        }
+        seed = random_value(seed + residue_number);
+
+        /* noise of whole batch is drawn at once, the displaced rings are
+           classified together without touching the atoms */
+        vector<double> noise(CONFIDENCE_BATCH * 3 * count);
+        vector<double> displaced(noise.size());
+        vector<short> classes(CONFIDENCE_BATCH);
+        size_t kept = 0;
+        for (size_t done = 0; done < trials; done += CONFIDENCE_BATCH) {
+                size_t batch = min(static_cast<size_t>(CONFIDENCE_BATCH),
+                                   trials - done);
+                gaussian_noise(noise.data(), noise.size(),
+                               seed + done * 3 * count);
+                for (size_t t = 0; t < batch; t++) {
+                        const double *delta = &noise[3 * count * t];
+                        double *ring = &displaced[3 * count * t];
+                        for (size_t j = 0; j < count; j++) {
+                                ring[3*j] = original[3*j] + sigmas[j] * delta[3*j];
+                                ring[3*j + 1] = original[3*j + 1] + sigmas[j] * delta[3*j + 1];
+                                ring[3*j + 2] = original[3*j + 2] + sigmas[j] * delta[3*j + 2];
+                        }
+                }
+                classify_batch(displaced.data(), batch, classes.data());
+                kept += count_if(classes.begin(), classes.begin() + batch,
+                                 [expected](short x){return x == expected;});
+        }
+
+        confidence = static_cast<double>(kept) / trials;
 }
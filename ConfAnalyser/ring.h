@@ -2,22 +2,79 @@
 #define RING_H
 
 #include "molecule.h"
+#include "vector_3D.h"
 #include <string>
 
 class Ring: public Molecule 
 {
         public:
                 Ring() = delete;
-                Ring(std::string _structure);
+                Ring(std::string _structure,
+                     std::map<std::string, short> &_conformations);
+                /* Number of atoms forming the ring */
+                virtual size_t size() const = 0;
+                /* Fill ring atoms directly with coordinates (X, Y, Z of every
+                   atom in the order of the atom names list) */
+                virtual bool set_coordinates(const double *coordinates) = 0;
+                /* Monte Carlo estimate of confidence of the analysed
+                   conformation: the ring is classified again trials times
+                   with atoms displaced by gaussian noise of deviation sigma
+                   (in angstroms, derived from temperature factors of the
+                   atoms if negative) */
+                void estimate_confidence(size_t trials, double sigma);
+                /* Engine recognizing conformations (ENGINE_*) */
+                void set_engine(int _engine);
+                /* Coordinates of ring atoms (X, Y, Z of every atom) */
+                void get_coordinates(double *coordinates);
+                /* Classes of ring_count rings of this type given by
+                   coordinates (as by set_coordinates, rings one after
+                   another) by the engine of the ring - codes of
+                   conformations, or indices of conformers for ring types
+                   labelled by atoms. Atoms of the ring are left untouched. */
+                void classify_batch(const double *coordinates,
+                                    size_t ring_count, short *classes) const;
+                void classify_batch(const float *coordinates,
+                                    size_t ring_count, short *classes) const;
+                /* Name of class given by classify_batch */
+                virtual std::string class_name(short _class) const;
+                /* Code of conformation of class given by classify_batch */
+                virtual short class_conformation(short _class) const;
         protected:
-                /* Functions for analyzing */
-                virtual bool find_plane(double tolerance, int dist1, int dist2, int dist3) = 0;
+                /* Classification by the engine, sets conformation */
+                void recognize();
+                /* Conformation by pattern of endocyclic torsions */
+                void classify_by_torsions();
+                /* Classification of current coordinates, sets conformation */
+                virtual void classify() = 0;
+                /* Atoms forming the ring, size() of them */
+                virtual Atom **ring_atoms() = 0;
+                /* Class of the analysed ring as given by classify_batch */
+                virtual short analysed_class() const;
+                /* Classes of rings given by coordinates by the geometric
+                   engine */
+                virtual void classify_geometric(const double *coordinates,
+                                                size_t ring_count,
+                                                short *classes) const = 0;
+                virtual void classify_geometric(const float *coordinates,
+                                                size_t ring_count,
+                                                short *classes) const = 0;
+                /* Fill geometric descriptors of the analysed ring */
+                virtual void describe() = 0;
+                void describe_puckering(Atom * const *atoms, size_t count);
+                /* Geometrical center and unit normal of the mean plane
+                   (Cremer-Pople), viewed from the side of the normal the
+                   atoms go clockwise */
+                template<typename T>
+                static void mean_plane(const Point_3D_t<T> * const *atoms,
+                                       size_t count, Vector_3D_t<T> &center,
+                                       Vector_3D_t<T> &normal);
+                void describe_torsions();
 
-                /* Is the plane there? */
-                bool has_plane;
-
-                /* First atom of the plane */
-                int begin;
+                int engine;
+        private:
+                template<typename T>
+                void classify_rings(const T *coordinates, size_t ring_count,
+                                    short *classes) const;
 };
 
 #endif
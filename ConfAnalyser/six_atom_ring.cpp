@@ -1,11 +1,15 @@
 #include "six_atom_ring.h"
 #include "plane_3D.h"
+#include "angle.h"
 #include <cfloat>
 #include <cmath>
+#include <limits>
 
 using namespace std;
 
-Six_atom_ring::Six_atom_ring(string _structure) : Ring(_structure)
+Six_atom_ring::Six_atom_ring(string _structure,
+                               map<string, short> &_conformations)
+        : Ring(_structure, _conformations)
 {
         for (auto &x : C) {
                 x = nullptr;
@@ -16,6 +20,33 @@ Six_atom_ring::Six_atom_ring(string _structure) : Ring(_structure)
 Six_atom_ring::~Six_atom_ring() {}
 
 
+size_t Six_atom_ring::size() const
+{
+        return 6;
+}
+
+
+Atom **Six_atom_ring::ring_atoms()
+{
+        return C;
+}
+
+
+bool Six_atom_ring::set_coordinates(const double *coordinates)
+{
+        for (int i = 0; i < 6; i++) {
+                delete(C[i]);
+                C[i] = new Atom();
+                C[i]->X = coordinates[3*i];
+                C[i]->Y = coordinates[3*i + 1];
+                C[i]->Z = coordinates[3*i + 2];
+        }
+        filled = true;
+
+        return filled;
+}
+
+
 // Old version
 /*bool Six_atom_ring::find_plane(double tolerance)
 {
@@ -37,17 +68,20 @@ Six_atom_ring::~Six_atom_ring() {}
 }*/
 
 
-bool Six_atom_ring::find_plane(double tolerance, int dist1, int dist2, int dist3)
+template<typename T>
+bool Six_atom_ring::find_plane(const Point_3D_t<T> *P, T tolerance, int &begin,
+                               int dist1, int dist2, int dist3)
 {
         bool has_plane = false;
-        double distance = DBL_MAX;
+        T distance = numeric_limits<T>::max();
+        begin = 0;
         for (int i = 0; i < 6; i++) {
-                Plane_3D tmp(*(C[i%6]), *(C[(i+dist1)%6]), *(C[(i+dist2)%6]));
-                double _distance = abs(tmp.distance_from(*(C[(i+dist3)%6])));
+                Plane_3D_t<T> tmp(P[i%6], P[(i+dist1)%6], P[(i+dist2)%6]);
+                T _distance = abs(tmp.distance_from(P[(i+dist3)%6]));
                 if (_distance < distance) {
                         begin = i;
                         distance = _distance;
-                        if (tmp.is_on_plane(*(C[(i+dist3)%6]), tolerance)) {
+                        if (tmp.is_on_plane(P[(i+dist3)%6], tolerance)) {
                                 has_plane = true;
                         }
                 }
@@ -55,3 +89,49 @@ bool Six_atom_ring::find_plane(double tolerance, int dist1, int dist2, int dist3
 
         return has_plane;
 }
+
+template bool Six_atom_ring::find_plane(const Point_3D_t<float> *P, float tolerance,
+                                        int &begin, int dist1, int dist2, int dist3);
+template bool Six_atom_ring::find_plane(const Point_3D_t<double> *P, double tolerance,
+                                        int &begin, int dist1, int dist2, int dist3);
+
+
+template<typename T>
+void Six_atom_ring::ring_points(const T *coordinates, Point_3D_t<T> *P)
+{
+        for (int i = 0; i < 6; i++) {
+                P[i] = Point_3D_t<T>(coordinates[3*i], coordinates[3*i + 1],
+                                     coordinates[3*i + 2]);
+        }
+}
+
+template void Six_atom_ring::ring_points(const float *coordinates, Point_3D_t<float> *P);
+template void Six_atom_ring::ring_points(const double *coordinates, Point_3D_t<double> *P);
+
+
+void Six_atom_ring::describe()
+{
+        /* search the best plane on its own */
+        int best = 0;
+        double distance = DBL_MAX;
+        for (int i = 0; i < 6; i++) {
+                Plane_3D tmp(*(C[i]), *(C[(i+1)%6]), *(C[(i+3)%6]));
+                double _distance = abs(tmp.distance_from(*(C[(i+4)%6])));
+                if (_distance < distance) {
+                        best = i;
+                        distance = _distance;
+                }
+        }
+
+        Plane_3D plane(*(C[best]), *(C[(best+1)%6]), *(C[(best+3)%6]));
+        descriptors.plane_distance = distance;
+        descriptors.right_distance = plane.distance_from(*(C[(best+2)%6]));
+        descriptors.left_distance = plane.distance_from(*(C[(best+5)%6]));
+        descriptors.dihedral = dihedral_angle(*(C[(best+1)%6]),
+                                              *(C[(best+3)%6]),
+                                              *(C[(best+4)%6]),
+                                              *(C[best]));
+
+        describe_puckering(C, 6);
+        describe_torsions();
+}
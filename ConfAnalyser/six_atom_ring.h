@@ -8,11 +8,26 @@ class Six_atom_ring: public Ring
 {
         public:
                 Six_atom_ring() = delete;
-                Six_atom_ring(std::string _structure);
+                Six_atom_ring(std::string _structure,
+                               std::map<std::string, short> &_conformations);
                 virtual ~Six_atom_ring() = 0;
+                virtual size_t size() const;
+                virtual bool set_coordinates(const double *coordinates);
         protected:
                 /* functions for analyzing */
-                virtual bool find_plane(double tolerance, int dist1 = 1, int dist2 = 3, int dist3 = 4);
+                /* The most accurate plane of atoms i, i+dist1, i+dist2 of
+                   ring of atoms P by distance of atom i+dist3 from it, begin
+                   is set to i; true if the atom is within tolerance */
+                template<typename T>
+                static bool find_plane(const Point_3D_t<T> *P, T tolerance,
+                                       int &begin, int dist1 = 1,
+                                       int dist2 = 3, int dist3 = 4);
+                /* Points of ring given by coordinates */
+                template<typename T>
+                static void ring_points(const T *coordinates,
+                                        Point_3D_t<T> *P);
+                virtual void describe();
+                virtual Atom **ring_atoms();
                 /* atom coordinates */
                 Atom *C[6];
 };
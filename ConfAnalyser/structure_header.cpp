@@ -0,0 +1,224 @@
+#include "structure_header.h"
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+using namespace std;
+
+
+/* Methods of --method and their names in EXPDTA records */
+static const pair<const char*, const char*> method_names[] = {
+        {"XRAY",     "X-RAY DIFFRACTION"},
+        {"NMR",      "NMR"},
+        {"EM",       "ELECTRON MICROSCOPY"},
+        {"NEUTRON",  "NEUTRON DIFFRACTION"},
+        {"FIBER",    "FIBER DIFFRACTION"},
+        {"ED",       "ELECTRON CRYSTALLOGRAPHY"}
+};
+
+
+static string trimmed(const string &s)
+{
+        size_t first = s.find_first_not_of(' ');
+        if (first == string::npos) {
+                return "";
+        }
+        size_t last = s.find_last_not_of(" \r");
+        return s.substr(first, last - first + 1);
+}
+
+
+static bool starts_with(const char *line, size_t length, const char *prefix)
+{
+        size_t prefix_length = strlen(prefix);
+        return length >= prefix_length && memcmp(line, prefix, prefix_length) == 0;
+}
+
+
+/* DD-MMM-YY of PDB to YYYY-MM-DD, empty if not valid */
+static string pdb_date(const string &date)
+{
+        static const char *months[] = {"JAN", "FEB", "MAR", "APR", "MAY", "JUN",
+                                       "JUL", "AUG", "SEP", "OCT", "NOV", "DEC"};
+        if (date.size() != 9 || date[2] != '-' || date[6] != '-' ||
+            !isdigit(date[0]) || !isdigit(date[1]) ||
+            !isdigit(date[7]) || !isdigit(date[8])) {
+                return "";
+        }
+        for (int i = 0; i < 12; i++) {
+                if (date.compare(3, 3, months[i]) == 0) {
+                        /* first structures of PDB come from 1970s */
+                        int year = atoi(date.substr(7, 2).c_str());
+                        year += (year >= 70) ? 1900 : 2000;
+                        char buffer[16];
+                        snprintf(buffer, sizeof(buffer), "%04d-%02d-%s",
+                                 year, i + 1, date.substr(0, 2).c_str());
+                        return buffer;
+                }
+        }
+        return "";
+}
+
+
+static bool valid_date(const string &date)
+{
+        if (date.size() != 10 || date[4] != '-' || date[7] != '-') {
+                return false;
+        }
+        for (size_t i = 0; i < date.size(); i++) {
+                if (i != 4 && i != 7 && !isdigit(date[i])) {
+                        return false;
+                }
+        }
+        return true;
+}
+
+
+Structure_header Structure_header::parse(const char *data, size_t size)
+{
+        Structure_header header;
+        header.resolution = -1;
+
+        const char *end = data + size;
+        while (data < end) {
+                const char *eol = static_cast<const char*>(
+                                        memchr(data, '\n', end - data));
+                if (eol == nullptr) {
+                        eol = end;
+                }
+                size_t length = eol - data;
+
+                /* title section precedes all the coordinates */
+                if (is_coordinate_record(data, length)) {
+                        break;
+                }
+
+                if (starts_with(data, length, "EXPDTA") && length > 10) {
+                        /* continuation lines extend the list, lines are
+                           broken between words */
+                        string method = trimmed(string(data + 10, length - 10));
+                        if (!header.method.empty() && !method.empty()) {
+                                header.method += ' ';
+                        }
+                        header.method += method;
+                } else if (starts_with(data, length, "REMARK   2 RESOLUTION.")) {
+                        const char *value = data + 22;
+                        char *value_end;
+                        double resolution = strtod(value, &value_end);
+                        if (value_end != value && value_end <= eol) {
+                                header.resolution = resolution;
+                        }
+                } else if (starts_with(data, length, "REVDAT   1 ") && length >= 22) {
+                        header.release_date = pdb_date(string(data + 13, 9));
+                }
+
+                data = eol + 1;
+        }
+
+        return header;
+}
+
+
+bool Structure_header::is_header_record(const char *line, size_t length)
+{
+        return starts_with(line, length, "EXPDTA") ||
+               starts_with(line, length, "REMARK   2 RESOLUTION.") ||
+               starts_with(line, length, "REVDAT   1 ");
+}
+
+
+bool Structure_header::is_coordinate_record(const char *line, size_t length)
+{
+        return starts_with(line, length, "ATOM  ") ||
+               starts_with(line, length, "HETATM") ||
+               starts_with(line, length, "MODEL ");
+}
+
+
+Header_filter::Header_filter()
+{
+        max_resolution = -1;
+}
+
+
+bool Header_filter::enabled() const
+{
+        return max_resolution >= 0 || !methods.empty() ||
+               !released_after.empty() || !released_before.empty();
+}
+
+
+void Header_filter::set_max_resolution(double _max_resolution)
+{
+        max_resolution = _max_resolution;
+}
+
+
+bool Header_filter::set_methods(const string &names)
+{
+        string name;
+        istringstream ss(names);
+        methods.clear();
+        while (getline(ss, name, ',')) {
+                bool known = false;
+                for (const auto &x : method_names) {
+                        if (name == x.first) {
+                                methods.push_back(x.second);
+                                known = true;
+                        }
+                }
+                if (!known) {
+                        return false;
+                }
+        }
+        return !methods.empty();
+}
+
+
+bool Header_filter::set_released_after(const string &date)
+{
+        released_after = date;
+        return valid_date(date);
+}
+
+
+bool Header_filter::set_released_before(const string &date)
+{
+        released_before = date;
+        return valid_date(date);
+}
+
+
+string Header_filter::check(const Structure_header &header) const
+{
+        if (max_resolution >= 0 &&
+            (header.resolution < 0 || header.resolution > max_resolution)) {
+                return header.resolution < 0 ? "resolution not given" :
+                       "resolution " + to_string(header.resolution).substr(0, 4) + " A";
+        }
+
+        if (!methods.empty()) {
+                bool found = false;
+                for (const auto &x : methods) {
+                        found = found || header.method.find(x) != string::npos;
+                }
+                if (!found) {
+                        return header.method.empty() ? "method not given" :
+                               "method " + header.method;
+                }
+        }
+
+        if (!released_after.empty() || !released_before.empty()) {
+                if (header.release_date.empty()) {
+                        return "release date not given";
+                }
+                if ((!released_after.empty() && header.release_date < released_after) ||
+                    (!released_before.empty() && header.release_date > released_before)) {
+                        return "released " + header.release_date;
+                }
+        }
+
+        return "";
+}
@@ -0,0 +1,52 @@
+#ifndef STRUCTURE_HEADER_H
+#define STRUCTURE_HEADER_H
+
+#include <string>
+#include <vector>
+
+/* Experimental data from the title section of PDB file */
+struct Structure_header
+{
+        /* EXPDTA, more methods are separated by ';' */
+        std::string method;
+        /* REMARK 2 in angstroms, negative if not given or not applicable */
+        double resolution;
+        /* initial release (REVDAT 1) as YYYY-MM-DD, empty if not given */
+        std::string release_date;
+
+        /* Records preceding the coordinate section, which ends the scan */
+        static Structure_header parse(const char *data, size_t size);
+        /* Record (line of given length) read by parse */
+        static bool is_header_record(const char *line, size_t length);
+        /* Record of the coordinate section */
+        static bool is_coordinate_record(const char *line, size_t length);
+};
+
+/*
+ * Filter of structures by their headers, so that unwanted files are
+ * rejected before their ATOM/HETATM records are parsed. Structures
+ * without the requested information do not pass.
+ */
+class Header_filter
+{
+        public:
+                Header_filter();
+                bool enabled() const;
+                void set_max_resolution(double _max_resolution);
+                /* Comma separated methods, e.g. XRAY,NMR; false if some of
+                   them is not known */
+                bool set_methods(const std::string &names);
+                /* Dates as YYYY-MM-DD, empty for no limit; false if the
+                   date is not valid */
+                bool set_released_after(const std::string &date);
+                bool set_released_before(const std::string &date);
+                /* Reason of rejection, empty if the structure passes */
+                std::string check(const Structure_header &header) const;
+        private:
+                double max_resolution;
+                std::vector<std::string> methods;
+                std::string released_after;
+                std::string released_before;
+};
+
+#endif
@@ -0,0 +1,261 @@
+#include "tar_reader.h"
+#include <cstring>
+#include <zlib.h>
+
+using namespace std;
+
+
+/* Numeric field of tar header, octal or GNU base-256 */
+static size_t header_number(const char *field, size_t length)
+{
+        size_t value = 0;
+        if (static_cast<unsigned char>(field[0]) & 0x80) {
+                for (size_t i = 1; i < length; i++) {
+                        value = (value << 8) | static_cast<unsigned char>(field[i]);
+                }
+                return value;
+        }
+
+        for (size_t i = 0; i < length && field[i] != '\0'; i++) {
+                if (field[i] >= '0' && field[i] <= '7') {
+                        value = value * 8 + (field[i] - '0');
+                }
+        }
+        return value;
+}
+
+
+/* NUL terminated or full-length string field of tar header */
+static string header_string(const char *field, size_t length)
+{
+        return string(field, strnlen(field, length));
+}
+
+
+/* Checksum of tar header is the sum of its bytes with the checksum field
+   counted as spaces, some old archivers summed signed chars */
+static bool header_checksum_valid(const char *header, size_t length)
+{
+        size_t stored = header_number(header + 148, 8);
+        size_t sum = 0;
+        long signed_sum = 0;
+        for (size_t i = 0; i < length; i++) {
+                char byte = (i >= 148 && i < 156) ? ' ' : header[i];
+                sum += static_cast<unsigned char>(byte);
+                signed_sum += static_cast<signed char>(byte);
+        }
+        return stored == sum || static_cast<long>(stored) == signed_sum;
+}
+
+
+/* Value of "path" record of pax extended header */
+static string pax_path(const string &records)
+{
+        size_t pos = 0;
+        while (pos < records.size()) {
+                size_t space = records.find(' ', pos);
+                if (space == string::npos) {
+                        break;
+                }
+                size_t length = strtoul(records.c_str() + pos, nullptr, 10);
+                if (length == 0 || pos + length > records.size()) {
+                        break;
+                }
+                string record = records.substr(space + 1, pos + length - space - 2);
+                if (record.compare(0, 5, "path=") == 0) {
+                        return record.substr(5);
+                }
+                pos += length;
+        }
+        return "";
+}
+
+
+Tar_reader::Tar_reader()
+{
+        archive = nullptr;
+        error = false;
+        damaged = false;
+}
+
+
+Tar_reader::~Tar_reader()
+{
+        close();
+}
+
+
+bool Tar_reader::open(const string &file_name)
+{
+        close();
+        error = false;
+        damaged = false;
+
+        /* gzip reads uncompressed archives transparently */
+        archive = gzopen(file_name.c_str(), "rb");
+        if (archive == nullptr) {
+                error = true;
+                return false;
+        }
+        gzbuffer(archive, 1 << 20);
+
+        return true;
+}
+
+
+void Tar_reader::close()
+{
+        if (archive != nullptr) {
+                gzclose(archive);
+                archive = nullptr;
+        }
+}
+
+
+bool Tar_reader::failed() const
+{
+        return error;
+}
+
+
+bool Tar_reader::member_damaged() const
+{
+        return damaged;
+}
+
+
+bool Tar_reader::read_exactly(char *buffer, size_t size)
+{
+        while (size > 0) {
+                int chunk = size > (1u << 30) ? (1 << 30) : static_cast<int>(size);
+                int count = gzread(archive, buffer, chunk);
+                if (count <= 0) {
+                        return false;
+                }
+                buffer += count;
+                size -= count;
+        }
+        return true;
+}
+
+
+bool Tar_reader::read_member(size_t size, string &data)
+{
+        size_t padded = (size + block_size - 1) / block_size * block_size;
+        data.resize(padded);
+        if (padded > 0 && !read_exactly(&data[0], padded)) {
+                error = true;
+                return false;
+        }
+        data.resize(size);
+        return true;
+}
+
+
+bool Tar_reader::gunzip(const string &in, string &out)
+{
+        z_stream stream;
+        memset(&stream, 0, sizeof(stream));
+        /* automatic detection of gzip header */
+        if (inflateInit2(&stream, 15 + 32) != Z_OK) {
+                return false;
+        }
+
+        out.resize(in.size() * 4 + 4096);
+        stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in.data()));
+        stream.avail_in = in.size();
+        int status = Z_OK;
+        while (status == Z_OK) {
+                if (stream.total_out == out.size()) {
+                        out.resize(out.size() * 2);
+                }
+                stream.next_out = reinterpret_cast<Bytef*>(&out[stream.total_out]);
+                stream.avail_out = out.size() - stream.total_out;
+                status = inflate(&stream, Z_NO_FLUSH);
+        }
+        out.resize(stream.total_out);
+        inflateEnd(&stream);
+
+        return status == Z_STREAM_END;
+}
+
+
+bool Tar_reader::next(string &name, string &content)
+{
+        if (archive == nullptr || error) {
+                return false;
+        }
+
+        char header[block_size];
+        string long_name;
+        damaged = false;
+        while (read_exactly(header, block_size)) {
+                /* archive ends by zero blocks */
+                if (header[0] == '\0') {
+                        return false;
+                }
+                if (!header_checksum_valid(header, block_size)) {
+                        error = true;
+                        return false;
+                }
+
+                size_t size = header_number(header + 124, 12);
+                char type = header[156];
+
+                /* GNU long name and pax header describe the next member */
+                if (type == 'L' || type == 'x') {
+                        string data;
+                        if (!read_member(size, data)) {
+                                return false;
+                        }
+                        long_name = (type == 'L') ?
+                                    header_string(data.data(), data.size()) :
+                                    pax_path(data);
+                        continue;
+                }
+
+                /* long name of other member (e.g. directory) is dropped
+                   with it */
+                if (type != '0' && type != '\0') {
+                        string skipped;
+                        if (!read_member(size, skipped)) {
+                                return false;
+                        }
+                        long_name.clear();
+                        continue;
+                }
+
+                if (!long_name.empty()) {
+                        name.swap(long_name);
+                        long_name.clear();
+                } else {
+                        name = header_string(header, 100);
+                        string prefix = header_string(header + 345, 155);
+                        if (memcmp(header + 257, "ustar", 5) == 0 &&
+                            !prefix.empty()) {
+                                name = prefix + "/" + name;
+                        }
+                }
+
+                if (!read_member(size, content)) {
+                        return false;
+                }
+
+                /* compressed member */
+                if (content.size() >= 2 &&
+                    static_cast<unsigned char>(content[0]) == 0x1f &&
+                    static_cast<unsigned char>(content[1]) == 0x8b) {
+                        packed.swap(content);
+                        if (!gunzip(packed, content)) {
+                                content.clear();
+                                damaged = true;
+                        }
+                }
+
+                return true;
+        }
+
+        /* archive without the terminating blocks */
+        error = true;
+        return false;
+}
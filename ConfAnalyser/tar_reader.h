@@ -0,0 +1,40 @@
+#ifndef TAR_READER_H
+#define TAR_READER_H
+
+#include <string>
+
+struct gzFile_s;
+
+/*
+ * Sequential reader of regular files stored in a tar archive (ustar, GNU
+ * long names and pax path records). The archive may be compressed by gzip,
+ * members compressed by gzip themselves (e.g. pdb1abc.ent.gz) are
+ * decompressed in memory, so nothing has to be extracted to the disk.
+ */
+class Tar_reader
+{
+        public:
+                Tar_reader();
+                ~Tar_reader();
+                bool open(const std::string &file_name);
+                void close();
+                /* Next regular file of the archive, false at the end of the
+                   archive or in case of error (see failed()) */
+                bool next(std::string &name, std::string &content);
+                bool failed() const;
+                /* Member returned by last next() could not be
+                   decompressed, its content is empty */
+                bool member_damaged() const;
+        private:
+                static const size_t block_size = 512;
+                bool read_exactly(char *buffer, size_t size);
+                bool read_member(size_t size, std::string &data);
+                static bool gunzip(const std::string &in, std::string &out);
+                gzFile_s *archive;
+                bool error;
+                bool damaged;
+                /* buffer of compressed members, reused between members */
+                std::string packed;
+};
+
+#endif
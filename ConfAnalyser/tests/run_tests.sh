@@ -0,0 +1,68 @@
+#!/bin/sh
+#
+# Regression tests of ConfAnalyser, run by 'make test'. Every test writes
+# the output of the program (standard output and diagnostics) to
+# <test>.out in a temporary directory and compares it with
+# expected/<test>.out. Paths of the data are relative to this directory.
+#
+# usage: run_tests.sh path/to/ConfAnalyser
+
+BIN=$(cd "$(dirname "$1")" && pwd)/$(basename "$1")
+cd "$(dirname "$0")" || exit 1
+OUT=$(mktemp -d) || exit 1
+trap 'rm -rf "$OUT"' EXIT
+FAILED=0
+
+
+check()
+{
+        if diff -u "expected/$1.out" "$OUT/$1.out"; then
+                echo "PASS $1"
+        else
+                echo "FAIL $1"
+                FAILED=1
+        fi
+}
+
+
+# Header filters on the records of --index are the same as on whole files
+"$BIN" index -i data/headers.txt -o "$OUT/headers.idx" 2> "$OUT/index.err"
+for input in "--index=$OUT/headers.idx" "-i data/headers.txt"; do
+        "$BIN" $input -n data/names.txt --cyclohexane --max_resolution=2.0 \
+               --method=XRAY -l 2>&1
+done > "$OUT/index_header_filter.out"
+check index_header_filter
+
+# Confidence of conformations of both engines, the expected values were
+# computed by moving the atoms of the ring and reclassifying it per trial
+for engine in geometric torsion; do
+        for sigma in "" --noise_sigma=0.05; do
+                "$BIN" -i data/confidence_chx.txt -n data/names.txt \
+                       --cyclohexane --engine=$engine --confidence=1000 \
+                       $sigma -f csv -l 2>&1
+                "$BIN" -i data/confidence_glc.txt -n data/names_glc.txt \
+                       --oxane --engine=$engine --confidence=1000 \
+                       $sigma -f csv -l 2>&1
+        done
+done > "$OUT/confidence.out"
+check confidence
+
+# Members of tar archive: long name of a directory does not stick to the
+# next member, damaged compressed member and damaged header are reported
+"$BIN" -t data/archive.tar -n data/names.txt --cyclohexane -l \
+       > "$OUT/archive.out" 2>&1
+cp data/archive.tar "$OUT/damaged.tar"
+printf 'X' | dd of="$OUT/damaged.tar" bs=1 seek=1546 conv=notrunc 2> /dev/null
+"$BIN" -t "$OUT/damaged.tar" -n data/names.txt --cyclohexane -l 2>&1 |
+        sed "s|$OUT/||" >> "$OUT/archive.out"
+check archive
+
+# Random sample is checked at the same sizes for any number of threads,
+# the second check (32 files) stops it
+for jobs in 1 3; do
+        "$BIN" -i data/sample.txt -n data/names.txt --cyclohexane -s \
+               --sample=0.45 -j$jobs 2>&1
+done > "$OUT/sample.out"
+check sample
+
+exit $FAILED
@@ -0,0 +1,164 @@
+#define _USE_MATH_DEFINES
+
+#include "torsion_classifier.h"
+#include "molecule.h"
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+using namespace std;
+
+
+template<typename T>
+void ring_torsions(const T *coordinates, size_t ring_count,
+                   size_t ring_size, T *torsions)
+{
+        const size_t n = ring_size;
+        for (size_t r = 0; r < ring_count; r++) {
+                const T *a = coordinates + 3 * n * r;
+                T *t = torsions + n * r;
+
+                /* bonds b[i] from atom i to atom i+1 */
+                T bx[MAX_RING_SIZE], by[MAX_RING_SIZE], bz[MAX_RING_SIZE];
+                for (size_t i = 0; i < n; i++) {
+                        size_t j = (i + 1 == n) ? 0 : i + 1;
+                        bx[i] = a[3*j] - a[3*i];
+                        by[i] = a[3*j + 1] - a[3*i + 1];
+                        bz[i] = a[3*j + 2] - a[3*i + 2];
+                }
+
+                /* normals m[i] = b[i] x b[i+1] of planes of atoms i..i+2 */
+                T mx[MAX_RING_SIZE], my[MAX_RING_SIZE], mz[MAX_RING_SIZE];
+                for (size_t i = 0; i < n; i++) {
+                        size_t j = (i + 1 == n) ? 0 : i + 1;
+                        mx[i] = by[i] * bz[j] - bz[i] * by[j];
+                        my[i] = bz[i] * bx[j] - bx[i] * bz[j];
+                        mz[i] = bx[i] * by[j] - by[i] * bx[j];
+                }
+
+                /* torsion around b[i] between planes m[i-1] and m[i]:
+                   atan2(|b[i]| b[i-1] . m[i], m[i-1] . m[i]) */
+                for (size_t i = 0; i < n; i++) {
+                        size_t h = (i == 0) ? n - 1 : i - 1;
+                        T length = sqrt(bx[i] * bx[i] + by[i] * by[i] +
+                                        bz[i] * bz[i]);
+                        T y = length * (bx[h] * mx[i] + by[h] * my[i] +
+                                        bz[h] * mz[i]);
+                        T x = mx[h] * mx[i] + my[h] * my[i] + mz[h] * mz[i];
+                        t[i] = atan2(y, x) * static_cast<T>(180 / M_PI);
+                }
+        }
+}
+
+
+template<typename T>
+int torsion_pattern(const T *torsions, size_t ring_size)
+{
+        const size_t n = ring_size;
+        bool zero[MAX_RING_SIZE];
+        bool positive[MAX_RING_SIZE];
+        size_t zeros = 0;
+        for (size_t i = 0; i < n; i++) {
+                zero[i] = fabs(torsions[i]) < static_cast<T>(TORSION_ZERO);
+                positive[i] = torsions[i] > 0;
+                zeros += zero[i];
+        }
+
+        if (zeros == n) {
+                return PATTERN_FLAT;
+        }
+
+        if (zeros == 0) {
+                /* bonds after which the sign is kept */
+                size_t kept = 0;
+                size_t first_kept = 0;
+                for (size_t i = 0; i < n; i++) {
+                        if (positive[i] == positive[(i + 1) % n]) {
+                                first_kept = (kept == 0) ? i : first_kept;
+                                kept++;
+                        }
+                }
+                if (n % 2 == 1) {
+                        return PATTERN_TWIST;
+                }
+                if (kept == 0) {
+                        return PATTERN_CHAIR;
+                }
+                /* + - + + - + : signs kept on two opposite bonds */
+                if (kept == 2 && n == 6 &&
+                    positive[(first_kept + 3) % n] ==
+                    positive[(first_kept + 4) % n]) {
+                        return PATTERN_TWIST;
+                }
+                return PATTERN_UNDEFINED;
+        }
+
+        if (zeros == 1) {
+                return (n == 5) ? PATTERN_ENVELOPE : PATTERN_HALF_CHAIR;
+        }
+
+        if (zeros == 2 && n == 6) {
+                size_t p = 0;
+                while (!zero[p]) {
+                        p++;
+                }
+                /* 0 + - 0 + - : zero torsions on opposite bonds */
+                if (zero[(p + 3) % n] &&
+                    positive[(p + 1) % n] != positive[(p + 2) % n] &&
+                    positive[(p + 4) % n] != positive[(p + 5) % n]) {
+                        return PATTERN_BOAT;
+                }
+                /* two neighbouring zero torsions, four atoms in plane */
+                if (zero[(p + 1) % n] || zero[(p + 5) % n]) {
+                        return PATTERN_ENVELOPE;
+                }
+        }
+
+        return PATTERN_UNDEFINED;
+}
+
+
+template void ring_torsions(const float *coordinates, size_t ring_count,
+                            size_t ring_size, float *torsions);
+template void ring_torsions(const double *coordinates, size_t ring_count,
+                            size_t ring_size, double *torsions);
+template int torsion_pattern(const float *torsions, size_t ring_size);
+template int torsion_pattern(const double *torsions, size_t ring_size);
+
+
+/* Conformations matching patterns of torsions, the first one found in
+   table of the ring type is used */
+static const vector<const char*> pattern_names[] = {
+        {"UNDEFINIED"},
+        {"FLAT"},
+        {"CHAIR"},
+        {"HALF CHAIR"},
+        {"BOAT"},
+        {"TWISTED BOAT", "SKEW", "TWIST"},
+        /* geometric engine calls envelope of cyclohexane half chair */
+        {"ENVELOPE", "HALF CHAIR"}
+};
+
+
+short pattern_conformation(int pattern, const map<string, short> &conformations)
+{
+        for (const char *name : pattern_names[pattern]) {
+                auto itr = conformations.find(name);
+                if (itr != conformations.end()) {
+                        return itr->second;
+                }
+        }
+        return conformations.at("UNDEFINIED");
+}
+
+
+int engine_from_name(const char *name)
+{
+        if (strcmp(name, "geometric") == 0) {
+                return ENGINE_GEOMETRIC;
+        }
+        if (strcmp(name, "torsion") == 0) {
+                return ENGINE_TORSION;
+        }
+        return -1;
+}
@@ -0,0 +1,52 @@
+#ifndef TORSION_CLASSIFIER_H
+#define TORSION_CLASSIFIER_H
+
+#include <cstddef>
+#include <map>
+#include <string>
+
+/* Engines recognizing conformations */
+#define ENGINE_GEOMETRIC  0   /* planes of ring atoms (default) */
+#define ENGINE_TORSION    1   /* patterns of endocyclic torsions */
+
+/* Patterns of endocyclic torsions */
+#define PATTERN_UNDEFINED   0
+#define PATTERN_FLAT        1
+#define PATTERN_CHAIR       2
+#define PATTERN_HALF_CHAIR  3
+#define PATTERN_BOAT        4
+#define PATTERN_TWIST       5   /* twisted boat (skew) or twist */
+#define PATTERN_ENVELOPE    6   /* envelope (sofa of six atom rings) */
+/* Number of patterns */
+#define PATTERNS            7
+
+/* Torsions smaller than this (in degrees) are considered zero */
+#define TORSION_ZERO 10.0
+
+/*
+ * Endocyclic torsion angles (in degrees) of ring_count rings of
+ * ring_size atoms (at most MAX_RING_SIZE) given by coordinates - X, Y, Z
+ * of every atom, rings one after another. torsions[i] of a ring is the
+ * angle around the bond of atoms i and i+1, signed as by IUPAC (Klyne-
+ * Prelog). Bond vectors and normals of the planes of consecutive bonds
+ * are computed once and shared by the neighbouring torsions, the loops
+ * run over plain arrays. Instantiated for float (batch classification,
+ * PDB coordinates have 3 decimal places only) and double.
+ */
+template<typename T>
+void ring_torsions(const T *coordinates, size_t ring_count,
+                   size_t ring_size, T *torsions);
+
+/* Pattern (PATTERN_*) of signs and magnitudes of torsions of a ring */
+template<typename T>
+int torsion_pattern(const T *torsions, size_t ring_size);
+
+/* Code of conformation matching the pattern in table of the ring type,
+   UNDEFINIED if the ring type does not know such conformation */
+short pattern_conformation(int pattern,
+                           const std::map<std::string, short> &conformations);
+
+/* Engine by its name (geometric, torsion), -1 if not known */
+int engine_from_name(const char *name);
+
+#endif
@@ -4,64 +4,78 @@
 using namespace std ;
 
 
-Vector_3D::Vector_3D(double _X, double _Y, double _Z) : Point_3D (_X, _Y, _Z) {}
+template<typename T>
+Vector_3D_t<T>::Vector_3D_t(T _X, T _Y, T _Z) : Point_3D_t<T> (_X, _Y, _Z) {}
 
 
-Vector_3D::Vector_3D(const Point_3D &A, const Point_3D &B)
+template<typename T>
+Vector_3D_t<T>::Vector_3D_t(const Point_3D_t<T> &A, const Point_3D_t<T> &B)
 {
-        X = A.X - B.X;
-        Y = A.Y - B.Y;
-        Z = A.Z - B.Z;
+        this->X = A.X - B.X;
+        this->Y = A.Y - B.Y;
+        this->Z = A.Z - B.Z;
 }
 
 
-double Vector_3D::length() const
+template<typename T>
+T Vector_3D_t<T>::length() const
 {
-        return sqrt(pow(X, 2) + pow(Y, 2) + pow(Z, 2));
+        return sqrt(this->X * this->X + this->Y * this->Y + this->Z * this->Z);
 }
 
 
-Vector_3D Vector_3D::operator+(const Vector_3D &vec) const
+template<typename T>
+Vector_3D_t<T> Vector_3D_t<T>::operator+(const Vector_3D_t &vec) const
 {
-        return Vector_3D(X + vec.X, Y + vec.Y, Z + vec.Z);
+        return Vector_3D_t(this->X + vec.X, this->Y + vec.Y, this->Z + vec.Z);
 }
 
 
-Vector_3D Vector_3D::operator-(const Vector_3D &vec) const
+template<typename T>
+Vector_3D_t<T> Vector_3D_t<T>::operator-(const Vector_3D_t &vec) const
 {
-        return Vector_3D(X - vec.X, Y - vec.Y, Z - vec.Z);
+        return Vector_3D_t(this->X - vec.X, this->Y - vec.Y, this->Z - vec.Z);
 }
 
 
-Vector_3D Vector_3D::operator/(const double num) const
+template<typename T>
+Vector_3D_t<T> Vector_3D_t<T>::operator/(const T num) const
 {
-        return Vector_3D(X / num, Y / num, Z / num);
+        return Vector_3D_t(this->X / num, this->Y / num, this->Z / num);
 }
 
 
-Vector_3D Vector_3D::operator*(const double num) const
+template<typename T>
+Vector_3D_t<T> Vector_3D_t<T>::operator*(const T num) const
 {
-        return Vector_3D(X * num, Y * num, Z * num);
+        return Vector_3D_t(this->X * num, this->Y * num, this->Z * num);
 }
 
 
-Vector_3D Vector_3D::get_normal() const
+template<typename T>
+Vector_3D_t<T> Vector_3D_t<T>::get_normal() const
 {
-        float mag = length();
+        T mag = length();
 
-        return Vector_3D(X / mag, Y / mag, Z / mag);
+        return Vector_3D_t(this->X / mag, this->Y / mag, this->Z / mag);
 }
 
 
-double Vector_3D::dot(const Vector_3D &vec1, const Vector_3D &vec2)
+template<typename T>
+T Vector_3D_t<T>::dot(const Vector_3D_t &vec1, const Vector_3D_t &vec2)
 {
         return vec1.X * vec2.X + vec1.Y * vec2.Y + vec1.Z * vec2.Z;
 }
 
 
-Vector_3D Vector_3D::cross(const Vector_3D &vec1, const Vector_3D &vec2)
+template<typename T>
+Vector_3D_t<T> Vector_3D_t<T>::cross(const Vector_3D_t &vec1, const Vector_3D_t &vec2)
 {
-        return Vector_3D(vec1.Y * vec2.Z - vec1.Z * vec2.Y,
-                         vec1.Z * vec2.X - vec1.X * vec2.Z,
-                         vec1.X * vec2.Y - vec1.Y * vec2.X);
+        return Vector_3D_t(vec1.Y * vec2.Z - vec1.Z * vec2.Y,
+                           vec1.Z * vec2.X - vec1.X * vec2.Z,
+                           vec1.X * vec2.Y - vec1.Y * vec2.X);
 }
+
+
+template struct Vector_3D_t<float>;
+template struct Vector_3D_t<double>;
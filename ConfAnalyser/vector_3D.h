@@ -3,21 +3,29 @@
 
 #include "point_3D.h"
 
-struct Vector_3D : public Point_3D
+template<typename T>
+struct Vector_3D_t : public Point_3D_t<T>
 {
         /* Constructors */
-        Vector_3D(double _X = 0, double _Y = 0, double _Z = 0);
-        Vector_3D(const Point_3D &A, const Point_3D &B = Point_3D(0, 0, 0));
+        Vector_3D_t(T _X = 0, T _Y = 0, T _Z = 0);
+        Vector_3D_t(const Point_3D_t<T> &A,
+                    const Point_3D_t<T> &B = Point_3D_t<T>(0, 0, 0));
 
         /* Arithmetic operations */
-        double length() const;
-        Vector_3D operator+(const Vector_3D &vec) const;
-        Vector_3D operator-(const Vector_3D &vec) const;
-        Vector_3D operator/(const double num) const;
-        Vector_3D operator*(const double num) const;
-        Vector_3D get_normal() const;
-        static double dot(const Vector_3D &vec1, const Vector_3D &vec2);
-        static Vector_3D cross(const Vector_3D &vec1, const Vector_3D &vec2);
+        T length() const;
+        Vector_3D_t operator+(const Vector_3D_t &vec) const;
+        Vector_3D_t operator-(const Vector_3D_t &vec) const;
+        Vector_3D_t operator/(const T num) const;
+        Vector_3D_t operator*(const T num) const;
+        Vector_3D_t get_normal() const;
+        static T dot(const Vector_3D_t &vec1, const Vector_3D_t &vec2);
+        static Vector_3D_t cross(const Vector_3D_t &vec1, const Vector_3D_t &vec2);
 };
 
+extern template struct Vector_3D_t<float>;
+extern template struct Vector_3D_t<double>;
+
+typedef Vector_3D_t<double> Vector_3D;
+typedef Vector_3D_t<float> Vector_3Df;
+
 #endif
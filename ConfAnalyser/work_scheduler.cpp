@@ -0,0 +1,176 @@
+#include "work_scheduler.h"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <numeric>
+#include <sstream>
+#include <thread>
+
+using namespace std;
+
+
+static double seconds_since(chrono::steady_clock::time_point start)
+{
+        return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+
+Work_scheduler::Work_scheduler(size_t _workers)
+        : workers(_workers == 0 ? 1 : _workers), queues(workers),
+          statistics(workers)
+{
+        wall_seconds = 0;
+        costs = nullptr;
+}
+
+
+bool Work_scheduler::take(size_t worker, size_t &task, bool &stolen)
+{
+        {
+                lock_guard<mutex> lock(queues[worker].lock);
+                if (!queues[worker].tasks.empty()) {
+                        task = queues[worker].tasks.front();
+                        queues[worker].tasks.pop_front();
+                        stolen = false;
+                        return true;
+                }
+        }
+
+        /* the most expensive task left in the queues of the others is
+           stolen, so that a single worker is not left finishing a large
+           task at the end of the run; tasks are never added during the
+           run, so empty queues of all the others mean there is nothing
+           left and the search is repeated only if the chosen task was
+           taken by someone else meanwhile */
+        while (true) {
+                size_t richest = workers;
+                size_t richest_cost = 0;
+                for (size_t i = 1; i < workers; i++) {
+                        size_t other = (worker + i) % workers;
+                        lock_guard<mutex> lock(queues[other].lock);
+                        if (!queues[other].tasks.empty() &&
+                            (richest == workers ||
+                             (*costs)[queues[other].tasks.front()] > richest_cost)) {
+                                richest = other;
+                                richest_cost = (*costs)[queues[other].tasks.front()];
+                        }
+                }
+                if (richest == workers) {
+                        return false;
+                }
+
+                Queue &victim = queues[richest];
+                lock_guard<mutex> lock(victim.lock);
+                if (!victim.tasks.empty()) {
+                        task = victim.tasks.front();
+                        victim.tasks.pop_front();
+                        stolen = true;
+                        return true;
+                }
+        }
+}
+
+
+void Work_scheduler::work(size_t worker,
+                          const function<void(size_t, size_t)> &task)
+{
+        Worker_statistics &stats = statistics[worker];
+        size_t index;
+        bool stolen;
+        while (take(worker, index, stolen)) {
+                auto start = chrono::steady_clock::now();
+                task(index, worker);
+                stats.busy_seconds += seconds_since(start);
+                stats.tasks++;
+                if (stolen) {
+                        stats.stolen++;
+                }
+        }
+}
+
+
+void Work_scheduler::run(const vector<size_t> &costs,
+                         const function<void(size_t, size_t)> &task)
+{
+        /* the most expensive tasks first, ties in the original order */
+        vector<size_t> order(costs.size());
+        iota(order.begin(), order.end(), 0);
+        stable_sort(order.begin(), order.end(), [&costs](size_t a, size_t b) {
+                return costs[a] > costs[b];
+        });
+
+        this->costs = &costs;
+        for (size_t i = 0; i < workers; i++) {
+                queues[i].tasks.clear();
+                statistics[i] = Worker_statistics{0, 0, 0};
+        }
+        for (size_t i = 0; i < order.size(); i++) {
+                queues[i % workers].tasks.push_back(order[i]);
+        }
+
+        auto start = chrono::steady_clock::now();
+        vector<thread> threads;
+        for (size_t i = 0; i < workers; i++) {
+                threads.emplace_back(&Work_scheduler::work, this, i, cref(task));
+        }
+        for (auto &x : threads) {
+                x.join();
+        }
+        wall_seconds = seconds_since(start);
+        this->costs = nullptr;
+}
+
+
+void Work_scheduler::stop()
+{
+        for (auto &x : queues) {
+                lock_guard<mutex> lock(x.lock);
+                x.tasks.clear();
+        }
+}
+
+
+size_t Work_scheduler::get_workers() const
+{
+        return workers;
+}
+
+
+const vector<Worker_statistics> &Work_scheduler::get_statistics() const
+{
+        return statistics;
+}
+
+
+double Work_scheduler::get_wall_seconds() const
+{
+        return wall_seconds;
+}
+
+
+void Work_scheduler::report(ostream &out) const
+{
+        /* formatted aside, so that the flags of out are kept */
+        ostringstream table;
+        table << "WORKERS\n-------\n"
+              << setw(10) << left << "WORKER"
+              << setw(10) << right << "TASKS"
+              << setw(10) << right << "STOLEN"
+              << setw(14) << right << "BUSY [s]"
+              << setw(14) << right << "UTILISATION" << '\n';
+        for (size_t i = 0; i < workers; i++) {
+                const Worker_statistics &x = statistics[i];
+                double utilisation = wall_seconds > 0 ?
+                                     x.busy_seconds / wall_seconds * 100 : 0;
+                table << setw(10) << left << i
+                      << setw(10) << right << x.tasks
+                      << setw(10) << right << x.stolen
+                      << setw(14) << right << fixed << setprecision(6)
+                      << x.busy_seconds
+                      << setw(13) << right << setprecision(2) << utilisation
+                      << "%\n";
+        }
+        table << setw(18) << left << "Wall time [s]: "
+              << setprecision(6) << wall_seconds << '\n';
+        out << table.str();
+}
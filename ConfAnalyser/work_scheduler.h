@@ -0,0 +1,59 @@
+#ifndef WORK_SCHEDULER_H
+#define WORK_SCHEDULER_H
+
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+/* Work done by single worker of Work_scheduler */
+struct Worker_statistics
+{
+        size_t tasks;
+        size_t stolen;
+        double busy_seconds;
+};
+
+/*
+ * Work-stealing scheduler of independent tasks with known relative costs
+ * (e.g. file sizes). Tasks are ordered from the most expensive one and
+ * dealt round-robin to per-worker queues. Worker takes the most expensive
+ * task of its own queue, an idle worker steals the most expensive task
+ * left in the queues of the others, so that the largest tasks are started
+ * early and the tail of the run consists of the small ones.
+ */
+class Work_scheduler
+{
+        public:
+                Work_scheduler(size_t _workers);
+                /* Call task(index, worker) for each index of costs, returns
+                   after all the tasks are finished */
+                void run(const std::vector<size_t> &costs,
+                         const std::function<void(size_t, size_t)> &task);
+                /* Drop the tasks not started yet (may be called by a task),
+                   run() returns once the running ones are finished */
+                void stop();
+                size_t get_workers() const;
+                const std::vector<Worker_statistics> &get_statistics() const;
+                double get_wall_seconds() const;
+                /* Table of tasks and utilisation of particular workers */
+                void report(std::ostream &out) const;
+        private:
+                struct Queue
+                {
+                        std::mutex lock;
+                        std::deque<size_t> tasks;
+                };
+                bool take(size_t worker, size_t &task, bool &stolen);
+                void work(size_t worker,
+                          const std::function<void(size_t, size_t)> &task);
+                size_t workers;
+                std::vector<Queue> queues;
+                std::vector<Worker_statistics> statistics;
+                double wall_seconds;
+                /* costs of the tasks during run() */
+                const std::vector<size_t> *costs;
+};
+
+#endif